@@ -0,0 +1,280 @@
+#include "Compressor.h"
+#include "Encryptor.h"
+#include "FileTracker.h"
+#include "BackupMetadata.h"
+#include "Utils.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// Microbenchmarks of the codec, hashing, scan and metadata paths.
+// Usage: backup_bench [--benchmark_filter=REGEX] [--benchmark_out=results.json --benchmark_out_format=json]
+//
+// Inputs are generated once per size under the system temp directory and removed at exit.
+// Payloads are half random and half repeated text, so the compressor has real work to do.
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t FILE_BYTES = 16 * 1024 * 1024;
+
+// Scratch directory for generated inputs, removed when the process exits
+class Scratch {
+public:
+    Scratch() : root_((fs::temp_directory_path() / ("backup_bench_" + std::to_string(::getpid()))).string()) {
+        fs::create_directories(root_);
+    }
+
+    ~Scratch() {
+        std::error_code error;
+        fs::remove_all(root_, error);
+    }
+
+    std::string path(const std::string& name) const {
+        return Utils::joinPaths(root_, name);
+    }
+
+private:
+    std::string root_;
+};
+
+Scratch& scratch() {
+    static Scratch instance;
+    return instance;
+}
+
+std::vector<uint8_t> payload(size_t bytes) {
+    static const std::string text = "backup block of moderately repetitive text, as logs and sources tend to be. ";
+    std::vector<uint8_t> data = Utils::generateRandomBytes(bytes / 2);
+    data.reserve(bytes);
+    while (data.size() < bytes) {
+        size_t take = std::min(text.size(), bytes - data.size());
+        data.insert(data.end(), text.begin(), text.begin() + take);
+    }
+    return data;
+}
+
+// A generated file of the given size, written once and reused by every benchmark that reads it
+const std::string& inputFile(size_t bytes) {
+    static std::map<size_t, std::string> files;
+    auto it = files.find(bytes);
+    if (it == files.end()) {
+        std::string path = scratch().path("input_" + std::to_string(bytes));
+        std::vector<uint8_t> data = payload(bytes);
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+        it = files.emplace(bytes, path).first;
+    }
+    return it->second;
+}
+
+// A tree of small files spread over nested directories of 100 entries each
+const std::string& inputTree(size_t count) {
+    static std::map<size_t, std::string> trees;
+    auto it = trees.find(count);
+    if (it == trees.end()) {
+        std::string root = scratch().path("tree_" + std::to_string(count));
+        std::vector<uint8_t> data = payload(4096);
+        for (size_t i = 0; i < count; ++i) {
+            std::string directory = Utils::joinPaths(root, "d" + std::to_string(i / 10000) + "/d" + std::to_string(i / 100));
+            if (i % 100 == 0) {
+                Utils::createDirectoryRecursive(directory);
+            }
+            std::ofstream(Utils::joinPaths(directory, "f" + std::to_string(i)), std::ios::binary)
+                .write(reinterpret_cast<const char*>(data.data()), 512 + (i % 8) * 448);
+        }
+        it = trees.emplace(count, root).first;
+    }
+    return it->second;
+}
+
+BackupMetadata::BackupInfo syntheticBackup(size_t entries) {
+    BackupMetadata::BackupInfo info;
+    info.backupId = "bench-" + std::to_string(entries);
+    info.backupType = "full";
+    info.timestamp = std::chrono::system_clock::now();
+    info.sourcePath = "/data";
+    info.totalSize = 0;
+    info.compressedSize = 0;
+    info.encrypted = false;
+    info.compressionMethod = "zlib";
+    info.compressionLevel = 6;
+    info.blockSize = 1024 * 1024;
+    info.files.reserve(entries);
+    for (size_t i = 0; i < entries; ++i) {
+        BackupMetadata::FileEntry entry;
+        entry.relativePath = "projects/p" + std::to_string(i / 1000) + "/src/file_" + std::to_string(i) + ".cpp";
+        entry.checksum = Digest::sha256(&i, sizeof(i));
+        entry.size = 4096 + i % 65536;
+        entry.lastModified = info.timestamp;
+        entry.compressed = true;
+        entry.encrypted = false;
+        entry.compressedSize = entry.size / 3;
+        entry.storedChecksum = Digest::sha256(&entry.size, sizeof(entry.size));
+        entry.blockChecksums = {static_cast<uint32_t>(i), static_cast<uint32_t>(i * 2654435761u)};
+        info.totalSize += entry.size;
+        info.compressedSize += entry.compressedSize;
+        info.files.push_back(std::move(entry));
+    }
+    return info;
+}
+
+void BM_CompressData(benchmark::State& state) {
+    auto level = static_cast<Compressor::CompressionLevel>(state.range(0));
+    std::vector<uint8_t> data = payload(static_cast<size_t>(state.range(1)));
+    Compressor compressor;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(compressor.compressData(data, level));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(1));
+}
+BENCHMARK(BM_CompressData)->ArgNames({"level", "bytes"})
+    ->ArgsProduct({{1, 6, 9}, {64 * 1024, 4 * 1024 * 1024}});
+
+void BM_CompressFile(benchmark::State& state) {
+    auto level = static_cast<Compressor::CompressionLevel>(state.range(0));
+    const std::string& input = inputFile(FILE_BYTES);
+    std::string output = scratch().path("compressed");
+    Compressor compressor;
+    for (auto _ : state) {
+        if (!compressor.compressFile(input, output, level)) {
+            state.SkipWithError("compressFile failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * FILE_BYTES);
+}
+BENCHMARK(BM_CompressFile)->ArgName("level")->Arg(1)->Arg(6)->Arg(9)->Unit(benchmark::kMillisecond);
+
+void BM_EncryptData(benchmark::State& state) {
+    std::vector<uint8_t> data = payload(static_cast<size_t>(state.range(0)));
+    Encryptor encryptor;
+    encryptor.generateRandomKey();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(encryptor.encryptData(data));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_EncryptData)->ArgName("bytes")->Arg(64 * 1024)->Arg(4 * 1024 * 1024);
+
+void BM_DecryptData(benchmark::State& state) {
+    Encryptor encryptor;
+    encryptor.generateRandomKey();
+    std::vector<uint8_t> encrypted = encryptor.encryptData(payload(static_cast<size_t>(state.range(0))));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(encryptor.decryptData(encrypted));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_DecryptData)->ArgName("bytes")->Arg(64 * 1024)->Arg(4 * 1024 * 1024);
+
+void BM_EncryptFile(benchmark::State& state) {
+    const std::string& input = inputFile(FILE_BYTES);
+    std::string output = scratch().path("encrypted");
+    Encryptor encryptor;
+    encryptor.generateRandomKey();
+    for (auto _ : state) {
+        if (!encryptor.encryptFile(input, output)) {
+            state.SkipWithError("encryptFile failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * FILE_BYTES);
+}
+BENCHMARK(BM_EncryptFile)->Unit(benchmark::kMillisecond);
+
+void BM_DecryptFile(benchmark::State& state) {
+    Encryptor encryptor;
+    encryptor.generateRandomKey();
+    std::string encrypted = scratch().path("decrypt_input");
+    std::string output = scratch().path("decrypted");
+    if (!encryptor.encryptFile(inputFile(FILE_BYTES), encrypted)) {
+        state.SkipWithError("encryptFile failed");
+        return;
+    }
+    for (auto _ : state) {
+        if (!encryptor.decryptFile(encrypted, output)) {
+            state.SkipWithError("decryptFile failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * FILE_BYTES);
+}
+BENCHMARK(BM_DecryptFile)->Unit(benchmark::kMillisecond);
+
+void BM_SHA256Data(benchmark::State& state) {
+    std::vector<uint8_t> data = payload(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Utils::calculateSHA256(data));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_SHA256Data)->ArgName("bytes")->Arg(4 * 1024)->Arg(64 * 1024)->Arg(4 * 1024 * 1024);
+
+void BM_SHA256File(benchmark::State& state) {
+    const std::string& input = inputFile(FILE_BYTES);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Utils::calculateSHA256(input));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * FILE_BYTES);
+}
+BENCHMARK(BM_SHA256File)->Unit(benchmark::kMillisecond);
+
+// Includes hashing every file, as a first scan does
+void BM_ScanDirectory(benchmark::State& state) {
+    const std::string& root = inputTree(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        FileTracker tracker;
+        if (!tracker.scanDirectory(root)) {
+            state.SkipWithError("scanDirectory failed");
+            break;
+        }
+        benchmark::DoNotOptimize(tracker.getTotalFiles());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_ScanDirectory)->ArgName("files")->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+void BM_MetadataExport(benchmark::State& state) {
+    BackupMetadata metadata;
+    BackupMetadata::BackupInfo info = syntheticBackup(static_cast<size_t>(state.range(0)));
+    metadata.adoptBackupInfo(info);
+    std::string output = scratch().path("metadata_export.json");
+    for (auto _ : state) {
+        if (!metadata.exportToJson(output)) {
+            state.SkipWithError("exportToJson failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    state.counters["fileBytes"] = static_cast<double>(Utils::getFileSize(output));
+}
+BENCHMARK(BM_MetadataExport)->ArgName("entries")->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+void BM_MetadataImport(benchmark::State& state) {
+    std::string input = scratch().path("metadata_import_" + std::to_string(state.range(0)) + ".json");
+    {
+        BackupMetadata metadata;
+        BackupMetadata::BackupInfo info = syntheticBackup(static_cast<size_t>(state.range(0)));
+        metadata.adoptBackupInfo(info);
+        metadata.exportToJson(input);
+    }
+    for (auto _ : state) {
+        BackupMetadata metadata;
+        if (!metadata.importFromJson(input)) {
+            state.SkipWithError("importFromJson failed");
+            break;
+        }
+        benchmark::DoNotOptimize(metadata.getFileCount("bench-" + std::to_string(state.range(0))));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_MetadataImport)->ArgName("entries")->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,540 @@
+#include "BackupManager.h"
+#include "Utils.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+// End-to-end pipeline benchmark over generated corpora.
+// Usage: e2e_bench [--profile tiny|huge|mixed|sparse|churn|all] [--scale F] [--seed N]
+//                  [--work DIR] [--no-compress] [--out FILE] [--baseline FILE] [--tolerance PCT]
+//
+// Each profile generates a reproducible corpus (same seed and scale, same bytes), then
+// runs a full backup, applies its churn and runs an incremental, restores the full backup
+// and verifies it. Every stage reports wall and CPU time, throughput, read/write syscalls
+// and bytes from /proc/self/io, context switches and peak RSS. Peak RSS is reset before
+// each stage through /proc/self/clear_refs where the kernel allows it, otherwise it is the
+// high-water mark of the whole process. With --baseline, stages that got slower, hungrier
+// or chattier than the stored results by more than the tolerance are flagged and the exit
+// status is 1.
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+constexpr std::uint64_t KiB = 1024;
+constexpr std::uint64_t MiB = 1024 * KiB;
+constexpr std::uint64_t GiB = 1024 * MiB;
+
+struct Corpus {
+    std::uint64_t files = 0;
+    std::uint64_t bytes = 0;            // Apparent size, which is what a backup reads
+};
+
+struct Churn {
+    double modify = 0.01;               // Share of files rewritten in part
+    double add = 0.0;                   // New files, as a share of the existing ones
+    double remove = 0.0;
+};
+
+struct Profile {
+    std::string name;
+    std::string description;
+    Churn churn;
+    std::function<Corpus(const std::string&, std::mt19937_64&, double)> generate;
+};
+
+struct Measurement {
+    bool ok = false;
+    double wallSeconds = 0.0;
+    double cpuSeconds = 0.0;
+    std::uint64_t bytes = 0;            // Payload the stage is measured against
+    std::uint64_t readSyscalls = 0;
+    std::uint64_t writeSyscalls = 0;
+    std::uint64_t bytesRead = 0;        // rchar/wchar: every byte through read/write, cached or not
+    std::uint64_t bytesWritten = 0;
+    std::uint64_t contextSwitches = 0;
+    std::uint64_t peakRssBytes = 0;
+
+    double throughput() const { return wallSeconds > 0.0 ? bytes / wallSeconds : 0.0; }
+};
+
+struct ProcessCounters {
+    std::uint64_t syscr = 0;
+    std::uint64_t syscw = 0;
+    std::uint64_t rchar = 0;
+    std::uint64_t wchar = 0;
+    double cpuSeconds = 0.0;
+    std::uint64_t contextSwitches = 0;
+};
+
+// ---- Corpus generation ----
+
+std::vector<uint8_t> randomBytes(std::mt19937_64& rng, size_t length) {
+    std::vector<uint8_t> bytes(length);
+    for (size_t i = 0; i < length; i += 8) {
+        std::uint64_t value = rng();
+        std::memcpy(&bytes[i], &value, std::min<size_t>(8, length - i));
+    }
+    return bytes;
+}
+
+std::vector<uint8_t> textBytes(std::mt19937_64& rng, size_t length) {
+    static const char* words[] = {"backup ", "restore ", "block ", "digest ", "stream ", "metadata ",
+                                  "the ", "of ", "and ", "file ", "error ", "ok\n", "2026-10-17 ", "INFO "};
+    std::vector<uint8_t> bytes;
+    bytes.reserve(length);
+    while (bytes.size() < length) {
+        const char* word = words[rng() % (sizeof(words) / sizeof(words[0]))];
+        bytes.insert(bytes.end(), word, word + std::strlen(word));
+    }
+    bytes.resize(length);
+    return bytes;
+}
+
+void writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(bytes.data()),
+                                                                  static_cast<std::streamsize>(bytes.size()));
+}
+
+// Large files are written in chunks so generation never holds them in memory
+void writeLargeFile(const std::string& path, std::uint64_t size, std::mt19937_64& rng) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    for (std::uint64_t written = 0; written < size;) {
+        size_t chunk = static_cast<size_t>(std::min<std::uint64_t>(4 * MiB, size - written));
+        std::vector<uint8_t> bytes = (written / (4 * MiB)) % 2 == 0 ? randomBytes(rng, chunk) : textBytes(rng, chunk);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(chunk));
+        written += chunk;
+    }
+}
+
+std::uint64_t scaled(std::uint64_t value, double scale, std::uint64_t minimum = 1) {
+    return std::max<std::uint64_t>(minimum, static_cast<std::uint64_t>(std::llround(value * scale)));
+}
+
+std::string bucket(const std::string& root, std::uint64_t index, std::uint64_t perDirectory) {
+    std::string directory = Utils::joinPaths(root, "d" + std::to_string(index / (perDirectory * 100)) +
+                                                   "/d" + std::to_string(index / perDirectory));
+    if (index % perDirectory == 0) {
+        Utils::createDirectoryRecursive(directory);
+    }
+    return directory;
+}
+
+Corpus smallFiles(const std::string& root, std::mt19937_64& rng, std::uint64_t count,
+                  std::uint64_t minSize, std::uint64_t maxSize, std::uint64_t perDirectory) {
+    Corpus corpus;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        size_t size = static_cast<size_t>(minSize + rng() % (maxSize - minSize + 1));
+        writeFile(Utils::joinPaths(bucket(root, i, perDirectory), "f" + std::to_string(i) + ".txt"),
+                  i % 4 == 0 ? randomBytes(rng, size) : textBytes(rng, size));
+        corpus.files++;
+        corpus.bytes += size;
+    }
+    return corpus;
+}
+
+std::vector<Profile> profiles() {
+    std::vector<Profile> list;
+
+    list.push_back({"tiny", "1M files of 64 B - 2 KiB, 1000 per directory", Churn{0.01, 0.001, 0.001},
+        [](const std::string& root, std::mt19937_64& rng, double scale) {
+            return smallFiles(root, rng, scaled(1000000, scale), 64, 2 * KiB, 1000);
+        }});
+
+    list.push_back({"huge", "3 files of 2 GiB, half random and half text", Churn{0.34, 0.0, 0.0},
+        [](const std::string& root, std::mt19937_64& rng, double scale) {
+            Corpus corpus;
+            std::uint64_t size = scaled(2 * GiB, scale, MiB);
+            for (int i = 0; i < 3; ++i) {
+                writeLargeFile(Utils::joinPaths(root, "huge_" + std::to_string(i) + ".bin"), size, rng);
+                corpus.files++;
+                corpus.bytes += size;
+            }
+            return corpus;
+        }});
+
+    list.push_back({"mixed", "1000 media files of 256 KiB - 8 MiB and 20k text files of 1 - 64 KiB", Churn{0.02, 0.01, 0.005},
+        [](const std::string& root, std::mt19937_64& rng, double scale) {
+            Corpus corpus;
+            std::string media = Utils::joinPaths(root, "media");
+            Utils::createDirectoryRecursive(media);
+            std::uint64_t count = scaled(1000, scale);
+            for (std::uint64_t i = 0; i < count; ++i) {
+                std::uint64_t size = 256 * KiB + rng() % (8 * MiB - 256 * KiB);
+                writeFile(Utils::joinPaths(media, "clip_" + std::to_string(i) + ".mp4"), randomBytes(rng, size));
+                corpus.files++;
+                corpus.bytes += size;
+            }
+            Corpus text = smallFiles(Utils::joinPaths(root, "docs"), rng, scaled(20000, scale), KiB, 64 * KiB, 200);
+            corpus.files += text.files;
+            corpus.bytes += text.bytes;
+            return corpus;
+        }});
+
+    list.push_back({"sparse", "8 disk images of 1 GiB apparent size with 64 extents of 1 MiB", Churn{0.25, 0.0, 0.0},
+        [](const std::string& root, std::mt19937_64& rng, double scale) {
+            Corpus corpus;
+            std::uint64_t size = scaled(GiB, scale, 64 * MiB);
+            for (int i = 0; i < 8; ++i) {
+                std::string path = Utils::joinPaths(root, "disk_" + std::to_string(i) + ".img");
+                std::ofstream(path, std::ios::binary | std::ios::trunc).close();
+                fs::resize_file(path, size);
+                std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+                for (int extent = 0; extent < 64; ++extent) {
+                    std::vector<uint8_t> bytes = randomBytes(rng, MiB);
+                    file.seekp(static_cast<std::streamoff>((size / 64) * extent));
+                    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+                }
+                corpus.files++;
+                corpus.bytes += size;
+            }
+            return corpus;
+        }});
+
+    list.push_back({"churn", "100k files of 1 - 32 KiB; 10% rewritten, 2% added, 2% deleted per incremental",
+                    Churn{0.10, 0.02, 0.02},
+        [](const std::string& root, std::mt19937_64& rng, double scale) {
+            return smallFiles(root, rng, scaled(100000, scale), KiB, 32 * KiB, 500);
+        }});
+
+    return list;
+}
+
+// Deterministic for a given corpus and seed; returns the bytes the incremental has to read
+std::uint64_t applyChurn(const std::string& root, const Churn& churn, std::mt19937_64& rng) {
+    std::vector<std::string> files;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    std::shuffle(files.begin(), files.end(), rng);
+
+    std::uint64_t changedBytes = 0;
+    size_t modify = static_cast<size_t>(std::ceil(files.size() * churn.modify));
+    size_t remove = static_cast<size_t>(files.size() * churn.remove);
+    size_t add = static_cast<size_t>(files.size() * churn.add);
+    for (size_t i = 0; i < modify && i < files.size(); ++i) {
+        // Rewrite the first 4 KiB in place, as an edit or a log append would touch a small part
+        std::uint64_t size = Utils::getFileSize(files[i]);
+        std::vector<uint8_t> bytes = randomBytes(rng, static_cast<size_t>(std::min<std::uint64_t>(4 * KiB, size)));
+        std::fstream file(files[i], std::ios::binary | std::ios::in | std::ios::out);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        changedBytes += size;
+    }
+    for (size_t i = modify; i < modify + remove && i < files.size(); ++i) {
+        fs::remove(files[i]);
+    }
+    std::string added = Utils::joinPaths(root, "added");
+    Utils::createDirectoryRecursive(added);
+    for (size_t i = 0; i < add; ++i) {
+        size_t size = static_cast<size_t>(KiB + rng() % (32 * KiB));
+        writeFile(Utils::joinPaths(added, "new_" + std::to_string(i) + ".txt"), textBytes(rng, size));
+        changedBytes += size;
+    }
+    return changedBytes;
+}
+
+// ---- Measurement ----
+
+ProcessCounters readCounters() {
+    ProcessCounters counters;
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    std::uint64_t value = 0;
+    while (io >> key >> value) {
+        if (key == "syscr:") {
+            counters.syscr = value;
+        } else if (key == "syscw:") {
+            counters.syscw = value;
+        } else if (key == "rchar:") {
+            counters.rchar = value;
+        } else if (key == "wchar:") {
+            counters.wchar = value;
+        }
+    }
+
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) == 0) {
+        counters.cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                              usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+        counters.contextSwitches = static_cast<std::uint64_t>(usage.ru_nvcsw + usage.ru_nivcsw);
+    }
+    return counters;
+}
+
+bool resetPeakRss() {
+    std::ofstream clear("/proc/self/clear_refs");
+    return static_cast<bool>(clear << "5" << std::flush);
+}
+
+std::uint64_t peakRss() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stoull(line.substr(6)) * KiB;
+        }
+    }
+    return 0;
+}
+
+// Runs one stage with its console output suppressed
+Measurement measure(std::uint64_t bytes, const std::function<bool()>& stage) {
+    Measurement measurement;
+    measurement.bytes = bytes;
+    resetPeakRss();
+    ProcessCounters before = readCounters();
+    auto start = std::chrono::steady_clock::now();
+
+    std::ostringstream discarded;
+    std::streambuf* console = std::cout.rdbuf(discarded.rdbuf());
+    try {
+        measurement.ok = stage();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Stage threw: " << e.what() << std::endl;
+    }
+    std::cout.rdbuf(console);
+
+    measurement.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ProcessCounters after = readCounters();
+    measurement.cpuSeconds = after.cpuSeconds - before.cpuSeconds;
+    measurement.readSyscalls = after.syscr - before.syscr;
+    measurement.writeSyscalls = after.syscw - before.syscw;
+    measurement.bytesRead = after.rchar - before.rchar;
+    measurement.bytesWritten = after.wchar - before.wchar;
+    measurement.contextSwitches = after.contextSwitches - before.contextSwitches;
+    measurement.peakRssBytes = peakRss();
+    return measurement;
+}
+
+json toJson(const Measurement& m) {
+    return {
+        {"ok", m.ok}, {"wallSeconds", m.wallSeconds}, {"cpuSeconds", m.cpuSeconds}, {"bytes", m.bytes},
+        {"throughput", m.throughput()}, {"readSyscalls", m.readSyscalls}, {"writeSyscalls", m.writeSyscalls},
+        {"bytesRead", m.bytesRead}, {"bytesWritten", m.bytesWritten}, {"contextSwitches", m.contextSwitches},
+        {"peakRssBytes", m.peakRssBytes}
+    };
+}
+
+// Backup directory names have one-second resolution; the next backup must not reuse one
+void waitForNextSecond() {
+    auto now = std::chrono::system_clock::now();
+    auto next = std::chrono::time_point_cast<std::chrono::seconds>(now) + std::chrono::seconds(1);
+    std::this_thread::sleep_until(next + std::chrono::milliseconds(10));
+}
+
+json runProfile(const Profile& profile, const std::string& work, double scale, std::uint64_t seed, bool compress) {
+    std::string corpusRoot = Utils::joinPaths(work, "corpus_" + profile.name);
+    std::string backups = Utils::joinPaths(work, "backups_" + profile.name);
+    std::string restore = Utils::joinPaths(work, "restore_" + profile.name);
+    std::error_code error;
+    fs::remove_all(corpusRoot, error);
+    fs::remove_all(backups, error);
+    fs::remove_all(restore, error);
+    Utils::createDirectoryRecursive(corpusRoot);
+    Utils::createDirectoryRecursive(backups);
+
+    std::cout << profile.name << ": generating (" << profile.description << ", scale " << std::defaultfloat << scale << ")" << std::endl;
+    std::mt19937_64 rng(seed ^ std::hash<std::string>()(profile.name));
+    auto generateStart = std::chrono::steady_clock::now();
+    Corpus corpus = profile.generate(corpusRoot, rng, scale);
+    double generateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - generateStart).count();
+    std::cout << profile.name << ": " << corpus.files << " files, " << Utils::formatBytes(corpus.bytes)
+              << " in " << std::fixed << std::setprecision(1) << generateSeconds << "s" << std::endl;
+
+    BackupManager manager;
+    manager.setProgressCallback([](const std::string&, float) {});
+    BackupManager::BackupOptions options;
+    options.sourcePath = corpusRoot;
+    options.destPath = backups;
+    options.enableCompression = compress;
+
+    json stages = json::object();
+    auto report = [&](const std::string& stage, const Measurement& m) {
+        stages[stage] = toJson(m);
+        std::cout << "  " << std::left << std::setw(12) << stage << std::right
+                  << (m.ok ? "" : "FAILED ") << std::fixed << std::setprecision(2) << std::setw(9) << m.wallSeconds << "s"
+                  << std::setw(12) << Utils::formatBytes(static_cast<std::uint64_t>(m.throughput())) << "/s"
+                  << std::setw(12) << (m.readSyscalls + m.writeSyscalls) << " syscalls"
+                  << std::setw(12) << Utils::formatBytes(m.peakRssBytes) << " peak RSS" << std::endl;
+    };
+
+    report("full", measure(corpus.bytes, [&] { return manager.createBackup(options); }));
+    std::vector<std::string> created = manager.listBackups(backups);
+    std::string fullBackup = created.empty() ? "" : created.front();
+
+    std::uint64_t changedBytes = applyChurn(corpusRoot, profile.churn, rng);
+    waitForNextSecond();
+    options.incremental = true;
+    report("incremental", measure(changedBytes, [&] { return manager.createIncrementalBackup(options); }));
+
+    report("restore", measure(corpus.bytes, [&] {
+        return !fullBackup.empty() && manager.restoreBackup(fullBackup, restore);
+    }));
+    std::uint64_t stored = fullBackup.empty() ? 0 : manager.getBackupSize(fullBackup);
+    report("verify", measure(stored, [&] { return !fullBackup.empty() && manager.verifyBackup(fullBackup); }));
+
+    fs::remove_all(corpusRoot, error);
+    fs::remove_all(backups, error);
+    fs::remove_all(restore, error);
+
+    return {
+        {"description", profile.description}, {"files", corpus.files}, {"bytes", corpus.bytes},
+        {"changedBytes", changedBytes}, {"generateSeconds", generateSeconds}, {"stages", stages}
+    };
+}
+
+// ---- Baseline comparison ----
+
+struct Metric {
+    const char* name;
+    bool higherIsBetter;
+};
+
+bool compareBaseline(const json& current, const json& baseline, double tolerance) {
+    static const Metric metrics[] = {
+        {"wallSeconds", false}, {"throughput", true}, {"peakRssBytes", false}, {"readSyscalls", false},
+        {"writeSyscalls", false}
+    };
+
+    if (baseline.value("scale", 0.0) != current.value("scale", 0.0) ||
+        baseline.value("seed", 0) != current.value("seed", 0) ||
+        baseline.value("compression", true) != current.value("compression", true)) {
+        std::cout << "Warning: Baseline was recorded with a different scale, seed or compression setting" << std::endl;
+    }
+
+    bool regressed = false;
+    std::cout << "\nAgainst baseline (tolerance " << std::defaultfloat << tolerance * 100 << "%):" << std::endl;
+    for (const auto& profile : current["profiles"].items()) {
+        if (!baseline["profiles"].contains(profile.key())) {
+            continue;
+        }
+        const json& baseStages = baseline["profiles"][profile.key()]["stages"];
+        for (const auto& stage : profile.value()["stages"].items()) {
+            if (!baseStages.contains(stage.key())) {
+                continue;
+            }
+            for (const Metric& metric : metrics) {
+                double now = stage.value().value(metric.name, 0.0);
+                double before = baseStages[stage.key()].value(metric.name, 0.0);
+                if (before <= 0.0) {
+                    continue;
+                }
+                double change = (now - before) / before;
+                bool worse = metric.higherIsBetter ? change < -tolerance : change > tolerance;
+                regressed = regressed || worse;
+                std::cout << "  " << std::left << std::setw(8) << profile.key() << std::setw(13) << stage.key()
+                          << std::setw(15) << metric.name << std::right << std::showpos << std::fixed
+                          << std::setprecision(1) << std::setw(8) << change * 100 << "%" << std::noshowpos
+                          << (worse ? "  REGRESSED" : "") << std::endl;
+            }
+        }
+    }
+    return !regressed;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string selected = "all";
+    double scale = 1.0;
+    std::uint64_t seed = 1;
+    std::string work = (fs::temp_directory_path() / ("backup_e2e_" + std::to_string(::getpid()))).string();
+    bool compress = true;
+    std::string outFile;
+    std::string baselineFile;
+    double tolerance = 0.10;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--profile" && hasValue) {
+            selected = argv[++i];
+        } else if (arg == "--scale" && hasValue) {
+            scale = std::stod(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            seed = std::stoull(argv[++i]);
+        } else if (arg == "--work" && hasValue) {
+            work = argv[++i];
+        } else if (arg == "--no-compress") {
+            compress = false;
+        } else if (arg == "--out" && hasValue) {
+            outFile = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselineFile = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            tolerance = std::stod(argv[++i]) / 100.0;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--profile tiny|huge|mixed|sparse|churn|all] [--scale F] [--seed N]\n"
+                      << "       [--work DIR] [--no-compress] [--out FILE] [--baseline FILE] [--tolerance PCT]\n";
+            return 1;
+        }
+    }
+
+    json results = {
+        {"version", "1.0"}, {"scale", scale}, {"seed", seed}, {"compression", compress},
+        {"timestamp", Utils::formatTimestamp(std::chrono::system_clock::now())}, {"profiles", json::object()}
+    };
+    if (!resetPeakRss()) {
+        std::cout << "Note: /proc/self/clear_refs is not writable; peak RSS is the process high-water mark" << std::endl;
+    }
+
+    bool found = false;
+    bool allOk = true;
+    Utils::createDirectoryRecursive(work);
+    for (const Profile& profile : profiles()) {
+        if (selected != "all" && selected != profile.name) {
+            continue;
+        }
+        found = true;
+        json result = runProfile(profile, work, scale, seed, compress);
+        for (const auto& stage : result["stages"]) {
+            allOk = allOk && stage.value("ok", false);
+        }
+        results["profiles"][profile.name] = result;
+    }
+    std::error_code error;
+    fs::remove(work, error);
+
+    if (!found) {
+        std::cerr << "Error: Unknown profile '" << selected << "'" << std::endl;
+        return 1;
+    }
+
+    if (!outFile.empty()) {
+        std::ofstream(outFile) << results.dump(2) << std::endl;
+        std::cout << "Results written to " << outFile << std::endl;
+    }
+
+    bool withinBaseline = true;
+    if (!baselineFile.empty()) {
+        std::ifstream file(baselineFile);
+        json baseline = json::parse(file, nullptr, false);
+        if (baseline.is_discarded() || !baseline.contains("profiles")) {
+            std::cerr << "Error: Cannot read baseline: " << baselineFile << std::endl;
+            return 1;
+        }
+        withinBaseline = compareBaseline(results, baseline, tolerance);
+    }
+
+    return allOk && withinBaseline ? 0 : 1;
+}
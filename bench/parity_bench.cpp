@@ -0,0 +1,94 @@
+#include "ErasureCoder.h"
+#include "Utils.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Encode and reconstruct throughput of the Reed-Solomon kernels.
+// Usage: parity_bench [MiB per layout, default 256]
+
+namespace {
+
+double measure(const std::function<void()>& step, size_t bytesPerStep, size_t totalBytes) {
+    size_t iterations = std::max<size_t>(1, totalBytes / bytesPerStep);
+    step(); // Warm up caches and page in the buffers
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        step();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (static_cast<double>(iterations) * bytesPerStep / (1024.0 * 1024.0)) / seconds;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t totalBytes = static_cast<size_t>(argc > 1 ? std::stoul(argv[1]) : 256) * 1024 * 1024;
+    const size_t shardSize = ErasureCoder::DEFAULT_SHARD_SIZE;
+    const std::vector<std::pair<size_t, size_t>> layouts = {{4, 2}, {8, 2}, {8, 4}, {10, 4}, {16, 4}};
+    const std::vector<ErasureCoder::Kernel> kernels = {
+        ErasureCoder::Kernel::SCALAR, ErasureCoder::Kernel::SSSE3, ErasureCoder::Kernel::AVX2
+    };
+
+    std::cout << "Shard size " << Utils::formatBytes(shardSize) << ", "
+              << Utils::formatBytes(totalBytes) << " of data per measurement\n\n";
+    std::cout << std::left << std::setw(8) << "layout" << std::setw(8) << "kernel"
+              << std::right << std::setw(14) << "encode MB/s" << std::setw(14) << "decode MB/s" << "\n";
+
+    for (const auto& layout : layouts) {
+        size_t k = layout.first;
+        size_t m = layout.second;
+
+        std::vector<uint8_t> stripe((k + m) * shardSize);
+        std::vector<uint8_t> original = Utils::generateRandomBytes(k * shardSize);
+        std::copy(original.begin(), original.end(), stripe.begin());
+
+        std::vector<uint8_t*> shards(k + m);
+        std::vector<const uint8_t*> data(k);
+        std::vector<uint8_t*> parity(m);
+        for (size_t s = 0; s < k + m; ++s) {
+            shards[s] = &stripe[s * shardSize];
+        }
+        for (size_t j = 0; j < k; ++j) {
+            data[j] = shards[j];
+        }
+        for (size_t i = 0; i < m; ++i) {
+            parity[i] = shards[k + i];
+        }
+
+        // Worst case for decoding: the first m data shards are lost
+        std::vector<bool> present(k + m, true);
+        for (size_t j = 0; j < m && j < k; ++j) {
+            present[j] = false;
+        }
+
+        for (auto kernel : kernels) {
+            if (!ErasureCoder::isKernelSupported(kernel)) {
+                continue;
+            }
+            ErasureCoder coder(k, m, kernel);
+
+            double encodeRate = measure([&]() { coder.encode(data, parity, shardSize); },
+                                        k * shardSize, totalBytes);
+            double decodeRate = measure([&]() { coder.reconstruct(shards, present, shardSize); },
+                                        k * shardSize, totalBytes);
+
+            if (!std::equal(original.begin(), original.end(), stripe.begin())) {
+                std::cerr << "Error: reconstruction mismatch for " << k << "+" << m << " ("
+                          << ErasureCoder::kernelName(kernel) << ")\n";
+                return 1;
+            }
+
+            std::cout << std::left << std::setw(8) << (std::to_string(k) + "+" + std::to_string(m))
+                      << std::setw(8) << ErasureCoder::kernelName(kernel) << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(14) << encodeRate << std::setw(14) << decodeRate << "\n";
+        }
+    }
+
+    return 0;
+}
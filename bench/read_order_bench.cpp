@@ -0,0 +1,131 @@
+#include "ReadOrder.h"
+#include "Utils.h"
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Head movement and cold-cache read time of each read order over a directory tree.
+// Usage: read_order_bench DIRECTORY
+//
+// Seeks and seek distance are counted from FIEMAP extents: every extent that does
+// not start where the previous one ended is one seek. The read pass drops each
+// file from the page cache first, so run it on an otherwise idle disk.
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Result {
+    size_t seeks = 0;
+    std::uint64_t distance = 0;
+    bool mapped = true;
+    std::uint64_t bytes = 0;
+    double seconds = 0.0;
+};
+
+void dropCache(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+}
+
+Result measure(const std::vector<std::string>& files, const std::vector<size_t>& order) {
+    Result result;
+    std::uint64_t head = 0;
+    bool first = true;
+    for (size_t index : order) {
+        std::vector<ReadOrder::Extent> extents;
+        if (!ReadOrder::mapExtents(files[index], extents)) {
+            result.mapped = false;
+            break;
+        }
+        for (const auto& extent : extents) {
+            if (!first && extent.physical != head) {
+                result.seeks++;
+                result.distance += extent.physical > head ? extent.physical - head : head - extent.physical;
+            }
+            head = extent.physical + extent.length;
+            first = false;
+        }
+    }
+
+    for (const auto& file : files) {
+        dropCache(file);
+    }
+
+    std::vector<char> buffer(1024 * 1024);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t index : order) {
+        int fd = ::open(files[index].c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        ssize_t bytes;
+        while ((bytes = ::read(fd, buffer.data(), buffer.size())) > 0) {
+            result.bytes += static_cast<std::uint64_t>(bytes);
+        }
+        ::close(fd);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " DIRECTORY\n";
+        return 1;
+    }
+
+    // The order the backup used before reads were planned
+    std::vector<std::string> files;
+    for (const auto& entry : fs::recursive_directory_iterator(argv[1])) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path().string());
+        }
+    }
+    if (files.empty()) {
+        std::cerr << "Error: No files under " << argv[1] << "\n";
+        return 1;
+    }
+    std::cout << files.size() << " files\n\n";
+
+    const std::vector<ReadOrder::Mode> modes = {
+        ReadOrder::Mode::SCAN, ReadOrder::Mode::INODE, ReadOrder::Mode::PHYSICAL
+    };
+    std::cout << std::left << std::setw(10) << "order" << std::right << std::setw(10) << "seeks"
+              << std::setw(16) << "seek distance" << std::setw(12) << "read s" << std::setw(12) << "MB/s" << "\n";
+
+    Result baseline;
+    for (auto mode : modes) {
+        Result result = measure(files, ReadOrder::plan(files, mode));
+        if (mode == ReadOrder::Mode::SCAN) {
+            baseline = result;
+        }
+
+        double rate = result.seconds > 0.0 ? result.bytes / (1024.0 * 1024.0) / result.seconds : 0.0;
+        std::cout << std::left << std::setw(10) << ReadOrder::modeToString(mode) << std::right;
+        if (result.mapped) {
+            std::cout << std::setw(10) << result.seeks << std::setw(16) << Utils::formatBytes(result.distance);
+        } else {
+            std::cout << std::setw(10) << "n/a" << std::setw(16) << "n/a";
+        }
+        std::cout << std::fixed << std::setprecision(2) << std::setw(12) << result.seconds
+                  << std::setprecision(1) << std::setw(12) << rate;
+        if (mode != ReadOrder::Mode::SCAN && result.mapped && baseline.seeks > 0) {
+            std::cout << "   (" << std::setprecision(0)
+                      << (100.0 - 100.0 * result.seeks / baseline.seeks) << "% fewer seeks)";
+        }
+        std::cout << "\n";
+    }
+
+    return 0;
+}
@@ -5,11 +5,24 @@
 #include <memory>
 #include <chrono>
 #include <functional>
+#include <atomic>
+#include <mutex>
+#include "Digest.h"
+#include "BackupVerifier.h"
+#include "IoThrottle.h"
+#include "IoScheduler.h"
+#include "ReadOrder.h"
+#include "WorkPlanner.h"
+#include "BlockCache.h"
+#include "ConcurrencyTuner.h"
 
 class FileTracker;
 class Compressor;
 class Encryptor;
 class BackupMetadata;
+class PackStore;
+class StoredChecksums;
+class EntrySpill;
 
 /**
  * Main backup manager that coordinates all backup operations
@@ -24,8 +37,33 @@ public:
         std::string encryptionKey;
         bool incremental = false;
         int compressionLevel = 6;
+        std::uint32_t checksumBlockSize = 1024 * 1024; // CRC32C block size for at-rest verification
+        std::uint32_t parityDataShards = 0;     // Reed-Solomon k, 0 = no parity sidecars
+        std::uint32_t parityShards = 2;         // Reed-Solomon m
+        std::uintmax_t readBytesPerSecond = 0;  // I/O limits for the whole run, 0 = unlimited
+        std::uintmax_t writeBytesPerSecond = 0;
+        std::uint32_t iopsLimit = 0;
+        std::string jobName;                    // Fair-share identity; empty = the source path
+        unsigned int ioWeight = 100;            // Share relative to other concurrent jobs
+        int ioPriority = 0;                     // Higher classes go first while active
+        ReadOrder::Mode readOrder = ReadOrder::Mode::AUTO;  // Order of source reads during scan and copy
+        WorkPlanner::Options workPlan;          // Large-file splitting and small-file batching
+        ConcurrencyTuner::Options tuning;       // Adaptive copy workers and write slots
     };
 
+    struct Status {
+        bool running = false;
+        std::string operation;
+        float progress = 0.0f;
+        std::string lastBackupPath;
+        std::string lastBackupId;
+        size_t trackedFiles = 0;
+        size_t deltaChain = 0;          // Delta state files since the last full snapshot
+    };
+
+    // Resident mode writes a full file state snapshot at least this often
+    static constexpr size_t MAX_DELTA_CHAIN = 24;
+
     BackupManager();
     ~BackupManager();
 
@@ -37,7 +75,11 @@ public:
     
     // Verification and integrity
     bool verifyBackup(const std::string& backupPath);
-    bool verifyFile(const std::string& filePath, const std::string& expectedChecksum);
+    bool verifyBackup(const std::string& backupPath, const BackupVerifier::Options& options);
+    bool verifyFile(const std::string& filePath, const Digest& expectedChecksum);
+    
+    // Comparison (target may be a backup or a source directory)
+    bool diffBackups(const std::string& basePath, const std::string& targetPath);
     
     // Information and status
     std::vector<std::string> listBackups(const std::string& backupRoot);
@@ -46,19 +88,88 @@ public:
     
     // Progress callback
     void setProgressCallback(std::function<void(const std::string&, float)> callback);
+    
+    // Resident mode keeps file state and catalog in memory between incremental
+    // backups, so a run only rescans, hashes and persists what changed
+    void setResident(bool resident);
+    void cancelBackup();
+    bool wasCancelled() const;
+    Status getStatus() const;
+    
+    // Share of wall time to idle between files (0 = full speed); may change mid-backup
+    void setThrottle(float idleFraction);
+    
+    // Token-bucket limits shared by every pipeline stage; each run starts with the
+    // limits from its BackupOptions, and this may change them mid-run
+    void setIoLimits(const IoThrottle::Limits& limits);
+    IoThrottle::Limits getIoLimits() const;
+    
+    // Fair sharing between concurrent jobs; managers may share one scheduler
+    void setIoScheduler(std::shared_ptr<IoScheduler> scheduler);
+    std::shared_ptr<IoScheduler> getIoScheduler() const;
+    
+    // Continuous data protection: one micro-incremental per batch of changed files,
+    // appended to the pack store in DEST/cdp instead of a new backup directory
+    bool commitMicroBatch(const BackupOptions& options, const std::vector<std::string>& changed,
+                          const std::vector<std::string>& deleted, bool rescan);
+    bool restoreContinuous(const std::string& cdpPath, const std::string& restorePath,
+                           std::chrono::system_clock::time_point until, const std::string& encryptionKey);
+    
+    // Decoded blocks shared by restore workers; 0 disables the cache
+    void setBlockCacheCapacity(std::uint64_t bytes);
+    BlockCache::Stats getBlockCacheStats() const;
+    
+    static constexpr const char* CDP_DIRECTORY = "cdp";
 
 private:
     std::unique_ptr<FileTracker> fileTracker_;
     std::unique_ptr<Compressor> compressor_;
     std::unique_ptr<Encryptor> encryptor_;
     std::unique_ptr<BackupMetadata> metadata_;
+    std::unique_ptr<PackStore> packStore_;
+    std::unique_ptr<IoThrottle> ioThrottle_;
+    std::shared_ptr<IoScheduler> ioScheduler_;
+    std::unique_ptr<BlockCache> blockCache_;
     
     std::function<void(const std::string&, float)> progressCallback_;
+    std::atomic<float> throttle_;
+    std::atomic<bool> running_;
+    std::atomic<bool> cancelRequested_;
+    mutable std::mutex statusMutex_;
+    std::string operation_;
+    float progress_;
+    
+    // Resident state, valid while residentStateFile_ is set
+    bool resident_;
+    std::string residentSource_;
+    std::string residentDest_;
+    std::string residentStateFile_;
+    std::string residentBackupId_;
+    size_t residentDeltaChain_;
+    size_t trackedFiles_;               // Tracker size when the last run ended, under statusMutex_
     
     // Helper methods
     bool createBackupDirectory(const std::string& path);
-    bool copyFileWithOptions(const std::string& src, const std::string& dest, const BackupOptions& options);
+    bool abortIfCancelled(const std::string& backupDir);
+    void recordTrackedFiles();
+    void rememberResidentState(const BackupOptions& options, const std::string& stateFile, const std::string& backupId);
+    bool copyFiles(const std::vector<std::string>& files, const std::string& backupDir, const BackupOptions& options,
+                   const std::string& stage, BackupMetadata::BackupInfo& backupInfo, EntrySpill& spill);
+    static std::string spillPath(const std::string& backupDir);
+    bool writeMetadata(const std::string& backupDir, BackupMetadata::BackupInfo& backupInfo, EntrySpill& spill,
+                       const BackupOptions& options);
+    bool copyFileWithOptions(const std::string& src, const std::string& dest, const BackupOptions& options,
+                             StoredChecksums* checksums = nullptr);
+    bool copyFileThrottled(const std::string& src, const std::string& dest, StoredChecksums* checksums = nullptr);
+    bool copyBlockWithOptions(const std::string& src, const std::string& dest, const BackupOptions& options,
+                              std::uint64_t offset, std::uint64_t length);
+    bool copyRange(const std::string& src, const std::string& dest, std::uint64_t offset, std::uint64_t length);
+    bool appendSegment(const std::string& dest, const std::string& segmentPath, bool first,
+                       StoredChecksums& checksums, std::uint64_t& size);
+    void applyIoLimits(const BackupOptions& options);
     bool restoreFileInternal(const std::string& src, const std::string& dest);
+    bool writeParity(const std::string& backupDir, const std::string& relativePath, const BackupOptions& options);
+    void applyThrottle(std::chrono::steady_clock::time_point workStart);
     std::string generateBackupPath(const std::string& basePath);
     void updateProgress(const std::string& operation, float percentage);
 };
@@ -3,8 +3,14 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <map>
 #include <chrono>
+#include <functional>
 #include <nlohmann/json.hpp>
+#include "Digest.h"
+#include "MerkleTree.h"
+
+class Encryptor;
 
 /**
  * Manages backup metadata and information
@@ -13,12 +19,16 @@ class BackupMetadata {
 public:
     struct FileEntry {
         std::string relativePath;
-        std::string checksum;
+        Digest checksum;
         std::uintmax_t size;
         std::chrono::system_clock::time_point lastModified;
         bool compressed;
         bool encrypted;
         std::uintmax_t compressedSize;
+        Digest storedChecksum;                  // Digest of the stored (compressed/encrypted) blob
+        std::vector<uint32_t> blockChecksums;   // CRC32C per blockSize bytes of the stored blob
+        std::uint64_t segmentSize = 0;          // Original bytes per segment of a split file
+        std::vector<std::uint64_t> segments;    // Stored length of each independently encoded segment; empty = one stream
     };
 
     struct BackupInfo {
@@ -34,13 +44,25 @@ public:
         std::string encryptionMethod;
         std::string compressionMethod;
         int compressionLevel;
+        std::uint32_t blockSize = 0;            // Block size used for FileEntry::blockChecksums
+        Digest merkleRoot;                      // Root of the MerkleTree over files
+        Digest merkleSignature;                 // HMAC of the root when the backup is encrypted
+        std::map<std::string, Digest> directoryDigests;
+        std::uint32_t parityDataShards = 0;     // Reed-Solomon k+m layout of parity sidecars, 0 = none
+        std::uint32_t parityShards = 0;
     };
 
+    // Entries of a backup kept outside BackupInfo::files (spilled to disk while copying);
+    // the stream calls the visitor once per entry and stops when it returns false
+    using EntryVisitor = std::function<bool(const FileEntry&)>;
+    using EntryStream = std::function<bool(const EntryVisitor&)>;
+
     BackupMetadata();
     ~BackupMetadata();
 
     // Backup information management
     bool createBackupInfo(const BackupInfo& info);
+    bool adoptBackupInfo(BackupInfo& info);     // As createBackupInfo, but moves info.files in instead of copying
     bool updateBackupInfo(const std::string& backupId, const BackupInfo& info);
     BackupInfo getBackupInfo(const std::string& backupId) const;
     bool deleteBackupInfo(const std::string& backupId);
@@ -58,9 +80,18 @@ public:
     
     // Verification and integrity
     bool verifyBackupIntegrity(const std::string& backupId) const;
-    std::string calculateBackupChecksum(const std::string& backupId) const;
+    Digest calculateBackupChecksum(const std::string& backupId) const;
     bool validateFileChecksums(const std::string& backupId) const;
     
+    // Merkle tree over file entries
+    MerkleTree buildMerkleTree(const std::string& backupId, const EntryStream& spilled = nullptr) const;
+    bool sealBackup(const std::string& backupId, Encryptor* signer = nullptr, const EntryStream& spilled = nullptr);
+    bool verifyBackupSignature(const std::string& backupId, Encryptor& signer) const;
+    std::vector<std::string> findDamagedDirectories(const std::string& backupId) const;
+    std::vector<std::string> compareBackups(const std::string& backupIdA, const std::string& backupIdB) const;
+    bool getInclusionProof(const std::string& backupId, const std::string& relativePath,
+                           MerkleTree::InclusionProof& proof) const;
+    
     // Search and query
     std::vector<std::string> listAllBackups() const;
     std::vector<std::string> findBackupsContainingFile(const std::string& relativePath) const;
@@ -77,7 +108,11 @@ public:
     bool saveToFile(const std::string& filename) const;
     bool loadFromFile(const std::string& filename);
     bool exportToJson(const std::string& filename) const;
+    // As above, with the spilled entries of backupId written after its resident ones
+    bool exportToJson(const std::string& filename, const std::string& backupId, const EntryStream& spilled) const;
     bool importFromJson(const std::string& filename);
+    static nlohmann::json fileEntryToJson(const FileEntry& entry);
+    static FileEntry fileEntryFromJson(const nlohmann::json& json);
     
     // Cleanup
     bool cleanupOrphanedEntries();
@@ -90,7 +125,6 @@ private:
     std::string generateBackupId() const;
     nlohmann::json backupInfoToJson(const BackupInfo& info) const;
     BackupInfo backupInfoFromJson(const nlohmann::json& json) const;
-    nlohmann::json fileEntryToJson(const FileEntry& entry) const;
-    FileEntry fileEntryFromJson(const nlohmann::json& json) const;
     bool validateBackupInfo(const BackupInfo& info) const;
+    static std::string signatureMessage(const BackupInfo& info);
 };
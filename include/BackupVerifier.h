@@ -0,0 +1,153 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include "BackupMetadata.h"
+
+class Encryptor;
+
+/**
+ * Verifies backup contents against the checksums recorded in the metadata
+ */
+class BackupVerifier {
+public:
+    enum class Mode {
+        FULL,           // Decrypt, decompress and hash every file
+        AT_REST,        // Hash the stored blobs as-is against digests recorded at write time
+        SAMPLE          // Fully verify a stratified, size-weighted random sample of files
+    };
+
+    enum class FileStatus {
+        OK,
+        CORRUPT,
+        MISSING,
+        EXTRA,
+        SKIPPED,
+        REPAIRED        // Was corrupt or missing, rebuilt from parity and re-verified
+    };
+
+    struct Options {
+        Mode mode = Mode::FULL;
+        std::string encryptionKey;
+        size_t threads = 0;         // 0 = one worker per hardware thread
+        std::string reportPath;     // Empty = REPORT_FILE in the backup's control directory
+        
+        // Sampling mode: stop once corruption above maxCorruption (fraction of bytes)
+        // would have been detected with the requested confidence, or the budget runs out
+        double confidence = 0.95;
+        double maxCorruption = 0.01;
+        std::chrono::seconds timeBudget{0};  // 0 = no time limit
+        unsigned int seed = 0;               // 0 = random seed
+        bool repair = true;                  // Rebuild damaged blobs from parity sidecars when present
+    };
+
+    struct FileResult {
+        std::string relativePath;
+        FileStatus status;
+        std::string detail;
+        std::uintmax_t bytesRead = 0;
+        std::uintmax_t bytesDecoded = 0;
+    };
+
+    struct StratumSummary {
+        std::string label;
+        size_t files = 0;
+        double byteShare = 0.0;             // Fraction of all bytes held by this stratum
+        size_t sampled = 0;
+        size_t verified = 0;
+        size_t clean = 0;
+    };
+
+    struct SamplingSummary {
+        size_t samplesPlanned = 0;
+        size_t samplesVerified = 0;
+        double requestedConfidence = 0.0;
+        double maxCorruption = 0.0;
+        double achievedConfidence = 0.0;    // P(detecting corruption above maxCorruption)
+        double corruptionBound = 1.0;       // Corrupted byte fraction ruled out at requested confidence
+        bool exhaustive = false;            // Sample covered every file
+        bool timeBudgetExhausted = false;
+        std::vector<StratumSummary> strata;
+    };
+
+    struct Report {
+        std::string backupPath;
+        std::string backupId;
+        std::string mode;
+        std::string error;                  // Set when the backup could not be verified at all
+        size_t filesChecked = 0;
+        size_t filesOk = 0;
+        size_t filesCorrupt = 0;
+        size_t filesMissing = 0;
+        size_t filesSkipped = 0;
+        size_t filesRepaired = 0;
+        size_t extraBlobs = 0;
+        bool metadataRepaired = false;
+        std::uintmax_t bytesRead = 0;       // Stored (compressed/encrypted) bytes read
+        std::uintmax_t bytesVerified = 0;   // Original bytes hashed
+        double elapsedSeconds = 0.0;
+        double throughputMBps = 0.0;
+        std::vector<FileResult> problems;   // Only non-OK results are kept
+        SamplingSummary sampling;           // Only filled in SAMPLE mode
+        std::string merkleStatus;           // "absent", "ok", "signed", "unsigned", "mismatch", "bad-signature"
+        std::vector<std::string> damagedDirectories;  // Directories whose recorded digest no longer matches
+
+        bool success() const;
+    };
+
+    explicit BackupVerifier(const Options& options);
+    ~BackupVerifier();
+
+    // Verification
+    Report verify(const std::string& backupPath);
+    bool writeReport(const Report& report, const std::string& reportPath) const;
+
+    // Progress callback
+    void setProgressCallback(std::function<void(const std::string&, float)> callback);
+
+    // At-rest check of one stored blob; the gate runs before each block is read
+    // and may wait (to throttle) or return false to abandon the check
+    using BlockGate = std::function<bool(size_t blockBytes)>;
+    static FileResult checkStoredBlob(const std::string& blobPath, const BackupMetadata::FileEntry& entry,
+                                      std::uint32_t blockSize, const BlockGate& gate = BlockGate());
+
+    // Files inside a backup directory that are not backed-up content: the control files at
+    // the top level, and everything under the parity and control directories
+    static constexpr const char* CONTROL_DIRECTORY = ".backup_control";  // Inside each backup directory
+    static constexpr const char* REPORT_FILE = "verify_report.json";
+    static bool isControlFile(const std::string& fileName);
+    static bool isControlPath(const std::string& relativePath);
+    static std::string statusToString(FileStatus status);
+    static std::string modeToString(Mode mode);
+    static bool parseMode(const std::string& name, Mode& mode);
+
+private:
+    Options options_;
+    std::unique_ptr<Encryptor> encryptor_;
+    std::function<void(const std::string&, float)> progressCallback_;
+    std::mutex progressMutex_;
+
+    // Helper methods
+    FileResult verifyEntry(const std::string& backupPath, const BackupMetadata::FileEntry& entry,
+                           std::uint32_t blockSize) const;
+    FileResult checkEntry(const std::string& backupPath, const BackupMetadata::FileEntry& entry,
+                          std::uint32_t blockSize) const;
+    void repairEntry(const std::string& backupPath, const BackupMetadata::FileEntry& entry,
+                     std::uint32_t blockSize, FileResult& result) const;
+    FileResult verifyContent(const std::string& blobPath, const BackupMetadata::FileEntry& entry) const;
+    std::vector<std::string> findExtraBlobs(const std::string& backupPath,
+                                            const std::vector<BackupMetadata::FileEntry>& entries) const;
+    void recordResult(Report& report, FileResult result) const;
+    void checkMerkleTree(const BackupMetadata& metadata, const BackupMetadata::BackupInfo& info,
+                         Report& report) const;
+    std::vector<BackupMetadata::FileEntry> planSample(const std::vector<BackupMetadata::FileEntry>& entries,
+                                                      SamplingSummary& sampling,
+                                                      std::vector<size_t>& sampleStrata) const;
+    static void finishSampling(Report& report);
+    static double missProbability(const std::vector<StratumSummary>& strata, double corruption);
+    void updateProgress(const std::string& operation, float percentage);
+};
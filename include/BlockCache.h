@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "Digest.h"
+
+/**
+ * Size-bounded LRU cache of decoded (decrypted and decompressed) blocks keyed by content digest
+ *
+ * Restores that meet the same content more than once, such as duplicate files or
+ * the same version replayed from several points, decode it once. The cache is
+ * split into shards by digest, each with its own lock and an equal share of the
+ * memory budget, so concurrent restore workers rarely contend. A block larger
+ * than one shard's budget is never cached. Cached bytes are also charged to the
+ * MemoryBudget, and a block that would push it over its limit is not cached.
+ */
+class BlockCache {
+public:
+    using Block = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t insertions = 0;
+        std::uint64_t evictions = 0;
+        size_t entries = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t capacity = 0;
+
+        double hitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+    };
+
+    static constexpr std::uint64_t DEFAULT_CAPACITY = 256ull * 1024 * 1024;
+    static constexpr size_t DEFAULT_SHARDS = 16;
+
+    explicit BlockCache(std::uint64_t capacity = DEFAULT_CAPACITY, size_t shards = DEFAULT_SHARDS);
+    ~BlockCache();
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    // Null on a miss
+    Block get(const Digest& key);
+    void put(const Digest& key, Block block);
+    bool admits(std::uint64_t size) const;
+
+    // Configuration; shrinking evicts immediately
+    void setCapacity(std::uint64_t capacity);
+    std::uint64_t getCapacity() const;
+    void clear();
+
+    Stats getStats() const;
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::list<std::pair<Digest, Block>> entries;        // Most recently used first
+        std::unordered_map<Digest, std::list<std::pair<Digest, Block>>::iterator> index;
+        std::uint64_t bytes = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<std::uint64_t> capacity_;
+    std::atomic<std::uint64_t> hits_;
+    std::atomic<std::uint64_t> misses_;
+    std::atomic<std::uint64_t> insertions_;
+    std::atomic<std::uint64_t> evictions_;
+
+    // Helper methods
+    Shard& shardFor(const Digest& key);
+    std::uint64_t shardCapacity() const;
+    void evict(Shard& shard, std::uint64_t limit);
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Process-wide pool of 4 KiB-aligned I/O and codec buffers
+ *
+ * Buffers come in power-of-two size classes from 4 KiB to 16 MiB and are carved
+ * out of slabs of at least 2 MiB. Slabs are mapped on a 2 MiB boundary and
+ * advised for transparent huge pages, and they are never unmapped, so the pool
+ * settles at the peak working set. A returned buffer goes to a small per-thread
+ * cache first and to the shared free list under a lock only when that cache is
+ * full, so a worker that leases and returns the same sizes in a loop touches
+ * neither the lock nor the allocator. Once warm, slabAllocations stays flat.
+ * Requests above the largest class are mapped directly and unmapped on return.
+ * Slabs and oversize buffers are charged to the MemoryBudget.
+ */
+class BufferPool {
+public:
+    static constexpr size_t ALIGNMENT = 4096;
+    static constexpr size_t MIN_BUFFER = 4 * 1024;
+    static constexpr size_t MAX_BUFFER = 16 * 1024 * 1024;
+    static constexpr size_t SLAB_BYTES = 2 * 1024 * 1024;
+    static constexpr size_t THREAD_CACHE = 4;      // Buffers per size class kept by each thread (1 from 1 MiB up)
+
+    // A leased buffer; returns itself to the pool when destroyed
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease();
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        uint8_t* data() const { return data_; }
+        char* chars() const { return reinterpret_cast<char*>(data_); }
+        size_t size() const { return size_; }      // At least the requested size
+        explicit operator bool() const { return data_ != nullptr; }
+
+        void release();
+
+    private:
+        friend class BufferPool;
+        uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    struct Stats {
+        std::uint64_t leases = 0;
+        std::uint64_t threadCacheHits = 0;      // Served without a lock
+        std::uint64_t sharedHits = 0;           // Served from the shared free lists
+        std::uint64_t slabAllocations = 0;      // Fresh mappings; flat once the pool is warm
+        std::uint64_t oversizeAllocations = 0;  // Requests above MAX_BUFFER, mapped one by one
+        std::uint64_t reservedBytes = 0;        // Slab memory held by the pool
+        std::uint64_t hugePageBytes = 0;        // Part of reservedBytes advised for huge pages
+        std::uint64_t leasedBytes = 0;          // Currently out on lease
+    };
+
+    static BufferPool& instance();
+
+    // Buffer of at least bytes, rounded up to its size class
+    Lease lease(size_t bytes);
+
+    Stats getStats() const;
+    static size_t classSize(size_t bytes);
+
+private:
+    static constexpr size_t CLASSES = 13;       // 4 KiB << 0 ... 4 KiB << 12 = 16 MiB
+
+    struct ThreadCache;
+
+    mutable std::mutex mutex_;
+    std::array<std::vector<uint8_t*>, CLASSES> free_;
+    std::atomic<std::uint64_t> leases_;
+    std::atomic<std::uint64_t> threadCacheHits_;
+    std::atomic<std::uint64_t> sharedHits_;
+    std::atomic<std::uint64_t> slabAllocations_;
+    std::atomic<std::uint64_t> oversizeAllocations_;
+    std::atomic<std::uint64_t> reservedBytes_;
+    std::atomic<std::uint64_t> hugePageBytes_;
+    std::atomic<std::uint64_t> leasedBytes_;
+
+    BufferPool();
+
+    // Helper methods
+    void giveBack(uint8_t* data, size_t size);
+    bool refill(size_t sizeClass);
+    static size_t classIndex(size_t bytes);
+    static ThreadCache& threadCache();
+};
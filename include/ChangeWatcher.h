@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+/**
+ * Watches a directory tree through inotify and groups changes into batches
+ *
+ * Events for the same path coalesce. A file is ready once its writer closed
+ * it, or once it has been quiet for the debounce period. A file under
+ * continuous write is taken anyway after maxHoldTime. A batch closes
+ * maxBatchDelay after its first event, or sooner when maxBatchFiles are ready.
+ * If the pending set would exceed maxPendingPaths, or the kernel queue
+ * overflows, individual paths are dropped. The next batch then asks for a
+ * full rescan instead, so a burst never grows memory without bound.
+ */
+class ChangeWatcher {
+public:
+    struct Options {
+        std::chrono::milliseconds quietPeriod{1000};
+        std::chrono::milliseconds maxBatchDelay{2000};
+        std::chrono::seconds maxHoldTime{60};
+        size_t maxBatchFiles = 1000;
+        size_t maxPendingPaths = 100000;
+    };
+
+    struct Batch {
+        std::vector<std::string> changed;   // Full paths of files to store
+        std::vector<std::string> deleted;   // Full paths removed, files or whole directories
+        bool rescan = false;                // Events were lost; rescan the whole tree
+    };
+
+    ChangeWatcher();
+    explicit ChangeWatcher(const Options& options);
+    ~ChangeWatcher();
+
+    ChangeWatcher(const ChangeWatcher&) = delete;
+    ChangeWatcher& operator=(const ChangeWatcher&) = delete;
+
+    // Control
+    bool start(const std::string& rootPath);
+    void stop();
+    bool isRunning() const;
+
+    // Blocks until a batch is ready; returns false once the watcher stops
+    bool nextBatch(Batch& batch);
+
+    // Information
+    size_t getPendingCount() const;
+    size_t getWatchCount() const;
+
+private:
+    struct Pending {
+        std::chrono::steady_clock::time_point firstEvent;
+        std::chrono::steady_clock::time_point lastEvent;
+        bool closed = false;        // Writer finished (close after write, or renamed into place)
+        bool deleted = false;
+    };
+
+    Options options_;
+    std::string rootPath_;
+    int inotifyFd_;
+    int wakeFds_[2];
+    std::atomic<bool> running_;
+    std::thread watchThread_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable batchReady_;
+    std::unordered_map<int, std::string> watches_;     // Watch descriptor -> directory
+    std::unordered_map<std::string, Pending> pending_;
+    std::chrono::steady_clock::time_point windowOpened_;
+    bool overflow_;
+
+    // Helper methods
+    void watchLoop();
+    void handleEvents(const char* buffer, size_t length);
+    void addWatchRecursive(const std::string& directory, bool markFiles);
+    void notePath(const std::string& path, bool closed, bool deleted);
+    void markOverflow();
+    bool batchDue(std::chrono::steady_clock::time_point now) const;
+    bool isReady(const Pending& pending, std::chrono::steady_clock::time_point now) const;
+};
@@ -3,12 +3,43 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include "BufferPool.h"
+
+struct z_stream_s;
+class IoThrottle;
 
 /**
  * Handles file compression and decompression using ZLIB
  */
 class Compressor {
 public:
+    using DataSink = std::function<bool(const uint8_t*, size_t)>;
+
+    /**
+     * Push-style inflater so decompression can be chained behind other stream stages
+     */
+    class StreamInflater {
+    public:
+        explicit StreamInflater(DataSink sink);
+        ~StreamInflater();
+
+        StreamInflater(const StreamInflater&) = delete;
+        StreamInflater& operator=(const StreamInflater&) = delete;
+
+        bool write(const uint8_t* data, size_t length);
+        bool finish();
+
+    private:
+        std::unique_ptr<z_stream_s> strm_;
+        DataSink sink_;
+        BufferPool::Lease outBuffer_;
+        bool initialized_;
+        bool streamEnded_;
+    };
+
     enum class CompressionLevel {
         NO_COMPRESSION = 0,
         BEST_SPEED = 1,
@@ -19,9 +50,13 @@ public:
     Compressor();
     ~Compressor();
 
-    // File compression
+    // File compression; written, if set, sees every byte that goes to the output file
     bool compressFile(const std::string& inputFile, const std::string& outputFile, 
-                     CompressionLevel level = CompressionLevel::DEFAULT_COMPRESSION);
+                     CompressionLevel level = CompressionLevel::DEFAULT_COMPRESSION,
+                     const DataSink& written = nullptr);
+    // Compresses length bytes from offset as a self-contained zlib stream
+    bool compressFile(const std::string& inputFile, const std::string& outputFile, CompressionLevel level,
+                      std::uint64_t offset, std::uint64_t length, const DataSink& written = nullptr);
     bool decompressFile(const std::string& inputFile, const std::string& outputFile);
     
     // Memory compression
@@ -43,13 +78,17 @@ public:
     size_t getTotalBytesCompressed() const;
     size_t getTotalBytesOriginal() const;
     double getAverageCompressionRatio() const;
+    
+    // File passes charge their reads and writes here (not owned, may be null)
+    void setIoThrottle(IoThrottle* throttle);
 
 private:
-    size_t totalBytesCompressed_;
-    size_t totalBytesOriginal_;
+    std::atomic<size_t> totalBytesCompressed_;     // Files may be compressed from several workers
+    std::atomic<size_t> totalBytesOriginal_;
+    IoThrottle* ioThrottle_;
     
     // Helper methods
-    bool compressFileInternal(FILE* source, FILE* dest, int level);
+    bool compressFileInternal(FILE* source, FILE* dest, int level, std::uint64_t limit, const DataSink& written);
     bool decompressFileInternal(FILE* source, FILE* dest);
     std::vector<uint8_t> processData(const std::vector<uint8_t>& data, bool compress, int level = 6);
 };
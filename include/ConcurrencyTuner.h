@@ -0,0 +1,115 @@
+#pragma once
+
+#include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Hill-climbing controller for the copy pipeline's concurrency
+ *
+ * Two knobs are tuned: reader workers per source device and write slots, the
+ * tasks allowed to write to the destination at once. Every interval the tuner
+ * takes a Sample of the pipeline and moves one knob by one step. A step that
+ * raises throughput by more than the tolerance is kept and repeated; one that
+ * does not is undone and the other direction is tried. After two reversals the
+ * knob is settled and the other one is tuned, and once neither improves the
+ * tuner holds the best setting until throughput falls well below it. Workers
+ * are not added while the process already uses cpuCeiling of all cores or no
+ * task is waiting for one, and write slots are not added while the destination
+ * is busy ioCeiling of the time.
+ *
+ * The best setting of a run is saved per source/destination pair, so the next
+ * run starts there instead of at the device defaults.
+ */
+class ConcurrencyTuner {
+public:
+    struct Options {
+        bool enabled = false;
+        size_t maxWorkers = 0;                          // Cap for both knobs; 0 = twice the cores
+        std::chrono::milliseconds interval{1000};
+        double tolerance = 0.05;                        // Throughput changes within this fraction count as flat
+        double cpuCeiling = 0.90;
+        double ioCeiling = 0.95;
+    };
+
+    struct Setting {
+        size_t workers = 1;
+        size_t writeSlots = 1;
+    };
+
+    // What the pipeline did during one interval
+    struct Sample {
+        double throughput = 0.0;        // Bytes per second
+        double queueOccupancy = 0.0;    // Tasks waiting per worker
+        double cpu = 0.0;               // Process CPU time over all cores, 0-1
+        double ioBusy = -1.0;           // Share of time the destination was busy, 0-1; negative = unknown
+    };
+
+    struct Stats {
+        size_t steps = 0;
+        size_t reversals = 0;
+        Setting best;
+        double bestThroughput = 0.0;
+        bool learned = false;           // Started from a saved setting
+    };
+
+    using Probe = std::function<Sample()>;
+    using Apply = std::function<void(const Setting&)>;
+
+    ConcurrencyTuner(const Options& options, const Setting& defaults);
+    ~ConcurrencyTuner();
+
+    ConcurrencyTuner(const ConcurrencyTuner&) = delete;
+    ConcurrencyTuner& operator=(const ConcurrencyTuner&) = delete;
+
+    // Learned settings, keyed by source and destination
+    bool load(const std::string& stateFile, const std::string& source, const std::string& destination);
+    bool save(const std::string& stateFile, const std::string& source, const std::string& destination) const;
+
+    // Steps once per interval on a background thread until stopped
+    void start(Probe probe, Apply apply);
+    void stop();
+
+    Setting step(const Sample& sample);
+    Setting current() const;
+    Stats getStats() const;
+    size_t getMaxWorkers() const;
+
+    // Process CPU seconds (user + system) so far
+    static double processCpuSeconds();
+
+    // Milliseconds the block device has spent doing I/O, from /proc/diskstats
+    static bool readIoTicks(const std::string& deviceName, std::uint64_t& milliseconds);
+
+private:
+    Options options_;
+    mutable std::mutex mutex_;
+    Setting current_;
+    Setting best_;
+    double bestThroughput_;
+    bool measured_;             // best_ has a throughput of its own
+    size_t knob_;               // 0 = workers, 1 = write slots
+    int direction_;
+    size_t reversals_;          // On the current knob
+    size_t settled_;            // Knobs settled in a row without improvement; 2 = holding
+    size_t steps_;
+    size_t totalReversals_;
+    bool learned_;
+
+    std::thread thread_;
+    std::mutex stopMutex_;
+    std::condition_variable stopRequested_;
+    bool stopping_;
+
+    // Helper methods
+    size_t& knob(Setting& setting) const;
+    bool canRaise(const Sample& sample) const;
+    void move(const Sample& sample);
+    void settleKnob();
+    Setting clamp(Setting setting) const;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <sys/un.h>
+
+/**
+ * Line-based control channel on a local Unix domain socket
+ *
+ * Each connection sends one command line ("status", "trigger", ...) and
+ * receives one response line. The socket is created with 0600 permissions,
+ * so only the owning user can drive the daemon.
+ */
+class ControlServer {
+public:
+    // Receives the command split on whitespace; returns the response line
+    using Handler = std::function<std::string(const std::vector<std::string>&)>;
+
+    explicit ControlServer(const std::string& socketPath);
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // Configuration
+    void registerCommand(const std::string& name, Handler handler);
+
+    // Control
+    bool start();
+    void stop();
+    bool isRunning() const;
+    std::string getSocketPath() const;
+
+    // Client side: send one command and read the response line
+    static bool sendCommand(const std::string& socketPath, const std::string& command, std::string& response);
+
+private:
+    std::string socketPath_;
+    int listenFd_;
+    int wakeFds_[2];
+    std::atomic<bool> running_;
+    std::thread serverThread_;
+    std::map<std::string, Handler> handlers_;
+    std::mutex handlersMutex_;
+
+    // Helper methods
+    void serverLoop();
+    void handleConnection(int clientFd);
+    std::string dispatch(const std::string& line);
+    static bool fillAddress(const std::string& socketPath, sockaddr_un& address);
+};
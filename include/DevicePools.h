@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+class ThreadPool;
+
+/**
+ * Per-device worker pools for the copy pipeline
+ *
+ * Work is grouped by the st_dev of the file it reads, and every source device
+ * gets its own queue and workers sized to the device type from sysfs: one
+ * stream for a rotational disk, so its head is not dragged between files, and
+ * one per core for SSD and NVMe. Destination devices are guarded the same
+ * way: a task holds one of its destination's write slots while it runs, so a
+ * single HDD target is not thrashed by several fast sources. Both counts can be
+ * changed while tasks run (see ConcurrencyTuner), up to maxWorkers threads.
+ */
+class DevicePools {
+public:
+    enum class DeviceType {
+        ROTATIONAL,
+        SOLID_STATE,
+        UNKNOWN         // Not a block device (tmpfs, overlay, network) or no sysfs entry
+    };
+
+    struct Options {
+        size_t rotationalWorkers = 1;
+        size_t solidStateWorkers = 0;       // 0 = one per core
+        size_t unknownWorkers = 2;
+        size_t maxWorkers = 0;              // Threads per source, for raising workers later; 0 = no headroom
+        size_t writeSlots = 0;              // Per destination; 0 = its worker count
+    };
+
+    struct DeviceInfo {
+        std::uint64_t device = 0;
+        std::string name;                   // Block device name, or "major:minor"
+        DeviceType type = DeviceType::UNKNOWN;
+        size_t workers = 0;                 // Concurrent reads
+        size_t writeSlots = 0;              // Concurrent writes when a destination
+        size_t tasks = 0;                   // Tasks read from this device so far
+        size_t queued = 0;                  // Tasks waiting for a reader
+        size_t running = 0;
+    };
+
+    DevicePools();
+    explicit DevicePools(const Options& options);
+    ~DevicePools();
+
+    DevicePools(const DevicePools&) = delete;
+    DevicePools& operator=(const DevicePools&) = delete;
+
+    // Queues a task on its source device; it runs holding a write slot on its destination device
+    void submit(std::uint64_t sourceDevice, std::uint64_t destinationDevice, std::function<void()> task);
+    void waitIdle();
+
+    // Concurrency of a device seen so far, clamped to 1..maxWorkers (or its thread count)
+    void setWorkers(std::uint64_t device, size_t workers);
+    void setWriteSlots(std::uint64_t device, size_t slots);
+
+    // Information
+    std::vector<DeviceInfo> getDevices() const;
+
+    // st_dev of path, 0 when it cannot be read
+    static std::uint64_t deviceOf(const std::string& path);
+    static DeviceType probeDeviceType(std::uint64_t device, std::string& name);
+    static std::string typeToString(DeviceType type);
+    size_t workersFor(DeviceType type) const;
+
+private:
+    struct Device {
+        DeviceInfo info;
+        std::unique_ptr<ThreadPool> readers;    // Created on first use as a source
+        size_t writers = 0;                     // Write slots in use
+    };
+
+    Options options_;
+    mutable std::mutex mutex_;
+    std::condition_variable slotFree_;
+    std::map<std::uint64_t, Device> devices_;
+
+    // Helper methods
+    Device& getDevice(std::uint64_t device);
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string>
+
+struct evp_md_ctx_st;
+
+/**
+ * Fixed-size binary message digest tagged with the algorithm that produced it
+ */
+class Digest {
+public:
+    enum class Algorithm : uint8_t {
+        NONE = 0,
+        SHA256 = 1,
+        MD5 = 2,
+        HMAC_SHA256 = 3
+    };
+
+    static constexpr size_t MAX_SIZE = 32;
+
+    Digest();
+    Digest(Algorithm algorithm, const uint8_t* bytes, size_t length);
+
+    // One-shot hashing
+    static Digest sha256(const void* data, size_t length);
+
+    // Hex conversion (only used at JSON/CLI boundaries)
+    std::string toHex() const;
+    static Digest fromHex(const std::string& hex);
+    static Digest fromHex(const std::string& hex, Algorithm algorithm);
+
+    // Accessors
+    Algorithm algorithm() const { return algorithm_; }
+    size_t size() const { return digestSize(algorithm_); }
+    bool empty() const { return algorithm_ == Algorithm::NONE; }
+    const uint8_t* data() const { return bytes_.data(); }
+
+    static size_t digestSize(Algorithm algorithm);
+
+    bool operator==(const Digest& other) const {
+        return algorithm_ == other.algorithm_ && std::memcmp(bytes_.data(), other.bytes_.data(), MAX_SIZE) == 0;
+    }
+    bool operator!=(const Digest& other) const { return !(*this == other); }
+    bool operator<(const Digest& other) const {
+        if (algorithm_ != other.algorithm_) {
+            return algorithm_ < other.algorithm_;
+        }
+        return std::memcmp(bytes_.data(), other.bytes_.data(), MAX_SIZE) < 0;
+    }
+
+private:
+    std::array<uint8_t, MAX_SIZE> bytes_;
+    Algorithm algorithm_;
+};
+
+/**
+ * Incremental digest computation backed by an OpenSSL EVP context
+ */
+class DigestBuilder {
+public:
+    explicit DigestBuilder(Digest::Algorithm algorithm = Digest::Algorithm::SHA256);
+    ~DigestBuilder();
+
+    DigestBuilder(const DigestBuilder&) = delete;
+    DigestBuilder& operator=(const DigestBuilder&) = delete;
+
+    void update(const void* data, size_t length);
+    Digest finish();
+    void reset();
+
+private:
+    evp_md_ctx_st* ctx_;
+    Digest::Algorithm algorithm_;
+};
+
+namespace std {
+template <>
+struct hash<Digest> {
+    size_t operator()(const Digest& digest) const noexcept {
+        // Digest bytes are already uniformly distributed
+        size_t value;
+        std::memcpy(&value, digest.data(), sizeof(value));
+        return value ^ static_cast<size_t>(digest.algorithm());
+    }
+};
+}
@@ -3,12 +3,45 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstdio>
+#include <functional>
+#include "Digest.h"
+#include "BufferPool.h"
+
+struct evp_cipher_ctx_st;
+class IoThrottle;
 
 /**
  * Handles file encryption and decryption using AES
  */
 class Encryptor {
 public:
+    using DataSink = std::function<bool(const uint8_t*, size_t)>;
+
+    /**
+     * Push-style decryption of the encryptFile format (header, IV, ciphertext),
+     * for blobs that arrive in pieces rather than as a file
+     */
+    class StreamDecryptor {
+    public:
+        StreamDecryptor(const Encryptor& encryptor, DataSink sink);
+        ~StreamDecryptor();
+
+        StreamDecryptor(const StreamDecryptor&) = delete;
+        StreamDecryptor& operator=(const StreamDecryptor&) = delete;
+
+        bool write(const uint8_t* data, size_t length);
+        bool finish();
+
+    private:
+        std::vector<uint8_t> key_;
+        DataSink sink_;
+        evp_cipher_ctx_st* ctx_;
+        std::vector<uint8_t> header_;       // Header and IV bytes until the cipher starts
+        BufferPool::Lease outBuffer_;
+        bool failed_;
+    };
+
     enum class KeySize {
         AES_128 = 128,
         AES_192 = 192,
@@ -22,13 +55,21 @@ public:
     bool setKey(const std::string& key);
     bool generateRandomKey(KeySize keySize = KeySize::AES_256);
     std::string getKeyHex() const;
+    bool hasKey() const;
     bool loadKeyFromFile(const std::string& keyFile);
     bool saveKeyToFile(const std::string& keyFile);
     
-    // File encryption
-    bool encryptFile(const std::string& inputFile, const std::string& outputFile);
+    // File encryption; written, if set, sees every byte that goes to the output file
+    bool encryptFile(const std::string& inputFile, const std::string& outputFile,
+                     const DataSink& written = nullptr);
+    // Encrypts length bytes from offset as a self-contained blob (header, IV, ciphertext)
+    bool encryptFile(const std::string& inputFile, const std::string& outputFile,
+                     std::uint64_t offset, std::uint64_t length, const DataSink& written = nullptr);
     bool decryptFile(const std::string& inputFile, const std::string& outputFile);
     
+    // Stream decryption (pushes plaintext chunks to the sink, safe to call concurrently)
+    bool decryptStream(FILE* input, const DataSink& sink) const;
+    
     // Data encryption
     std::vector<uint8_t> encryptData(const std::vector<uint8_t>& data);
     std::vector<uint8_t> decryptData(const std::vector<uint8_t>& encryptedData);
@@ -39,22 +80,26 @@ public:
     
     // Utility functions
     bool isEncrypted(const std::string& filePath);
-    std::string calculateHMAC(const std::string& data);
-    bool verifyHMAC(const std::string& data, const std::string& hmac);
+    Digest calculateHMAC(const std::string& data);
+    bool verifyHMAC(const std::string& data, const Digest& hmac);
     
     // Key derivation
     std::string deriveKeyFromPassword(const std::string& password, const std::string& salt);
     std::string generateSalt();
+    
+    // File passes charge their reads and writes here (not owned, may be null)
+    void setIoThrottle(IoThrottle* throttle);
 
 private:
     std::vector<uint8_t> key_;
-    std::vector<uint8_t> iv_;
+    std::vector<uint8_t> iv_;           // In-memory data only; files carry their own IV
     KeySize keySize_;
+    IoThrottle* ioThrottle_;
     
     // Helper methods
     bool initializeEncryption();
     std::vector<uint8_t> generateRandomBytes(size_t length);
     std::vector<uint8_t> processData(const std::vector<uint8_t>& data, bool encrypt);
-    bool encryptFileInternal(FILE* input, FILE* output);
+    bool encryptFileInternal(FILE* input, FILE* output, std::uint64_t limit, const DataSink& written);
     bool decryptFileInternal(FILE* input, FILE* output);
 };
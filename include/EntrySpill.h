@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <cstddef>
+#include "BackupMetadata.h"
+
+/**
+ * Disk-backed holding area for file entries that do not fit the memory budget
+ *
+ * While a backup copies, finished entries pile up until the metadata is written.
+ * When the MemoryBudget is over its limit, they are appended here as JSON lines
+ * and freed. forEach() streams them back one at a time, so sealing and exporting
+ * the metadata never hold the spilled entries in memory together. The file is
+ * removed when the spill goes away.
+ */
+class EntrySpill {
+public:
+    explicit EntrySpill(const std::string& path);
+    ~EntrySpill();
+
+    EntrySpill(const EntrySpill&) = delete;
+    EntrySpill& operator=(const EntrySpill&) = delete;
+
+    bool write(const BackupMetadata::FileEntry& entry);
+    // Visits spilled entries in the order they were written; the visitor returns false to stop
+    bool forEach(const std::function<bool(const BackupMetadata::FileEntry&)>& visit);
+
+    size_t size() const;
+    const std::string& getPath() const;
+
+private:
+    std::string path_;
+    std::ofstream output_;
+    size_t count_;
+    mutable std::mutex mutex_;
+};
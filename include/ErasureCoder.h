@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Systematic Reed-Solomon erasure coding over GF(2^8)
+ *
+ * k data shards are extended with m parity shards from a Cauchy matrix, so any
+ * k surviving shards rebuild the rest. Parity for a whole file is kept in a
+ * sidecar file of stripes, each with a CRC32C per shard to locate damage.
+ */
+class ErasureCoder {
+public:
+    enum class Kernel {
+        AUTO,           // Fastest available on this CPU
+        SCALAR,
+        SSSE3,
+        AVX2
+    };
+
+    struct RepairResult {
+        bool parityFound = false;
+        bool damaged = false;           // At least one shard failed its CRC
+        bool repaired = false;          // All damage was rebuilt and written back
+        size_t shardsRepaired = 0;
+        size_t stripesUnrecoverable = 0;
+        std::string error;
+    };
+
+    static constexpr size_t MAX_SHARDS = 255;
+    static constexpr size_t DEFAULT_SHARD_SIZE = 64 * 1024;
+    static constexpr const char* PARITY_DIRECTORY = ".backup_parity";  // Inside each backup directory
+
+    ErasureCoder(size_t dataShards, size_t parityShards, Kernel kernel = Kernel::AUTO);
+    ~ErasureCoder();
+
+    // Shard-level coding; every shard is shardSize bytes
+    void encode(const std::vector<const uint8_t*>& data, std::vector<uint8_t*>& parity, size_t shardSize) const;
+    bool reconstruct(std::vector<uint8_t*>& shards, const std::vector<bool>& present, size_t shardSize) const;
+
+    // Parity sidecar files
+    bool encodeFile(const std::string& filePath, const std::string& parityPath,
+                    size_t maxShardSize = DEFAULT_SHARD_SIZE) const;
+    static RepairResult repairFile(const std::string& filePath, const std::string& parityPath);
+    static std::string parityPath(const std::string& backupPath, const std::string& relativePath);
+
+    // Information
+    size_t getDataShards() const { return dataShards_; }
+    size_t getParityShards() const { return parityShards_; }
+    Kernel getKernel() const { return kernel_; }
+    static std::string kernelName(Kernel kernel);
+    static bool isKernelSupported(Kernel kernel);
+    static bool parseLayout(const std::string& layout, size_t& dataShards, size_t& parityShards);
+
+private:
+    size_t dataShards_;
+    size_t parityShards_;
+    Kernel kernel_;
+    std::vector<uint8_t> matrix_;       // (k + m) x k encoding matrix, identity on top
+
+    // Helper methods
+    void mulAdd(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t length) const;
+    bool invertMatrix(std::vector<uint8_t>& matrix, size_t n) const;
+};
@@ -5,6 +5,11 @@
 #include <vector>
 #include <chrono>
 #include <filesystem>
+#include <nlohmann/json.hpp>
+#include "Digest.h"
+#include "ReadOrder.h"
+
+class IoThrottle;
 
 /**
  * Tracks file changes to enable incremental backups
@@ -15,8 +20,18 @@ public:
         std::string path;
         std::uintmax_t size;
         std::chrono::system_clock::time_point lastModified;
-        std::string checksum;
+        Digest checksum;
         bool isDirectory;
+        std::uint64_t device = 0;       // st_dev seen by the last scan; not persisted
+    };
+
+    // Differences between the previous and current state, relative to the scanned root
+    struct StateDiff {
+        std::vector<std::string> added;
+        std::vector<std::string> modified;
+        std::vector<std::string> deleted;
+        size_t directoriesVisited = 0;
+        size_t directoriesSkipped = 0;      // Identical subtrees that were not descended into
     };
 
     FileTracker();
@@ -24,10 +39,15 @@ public:
 
     // File tracking operations
     bool scanDirectory(const std::string& path);
+    bool rescanDirectory(const std::string& path);     // Reuses checksums of files whose size and mtime match the previous state
     bool loadPreviousState(const std::string& stateFile);
+    bool loadCurrentState(const std::string& stateFile);
     bool saveDatabaseState(const std::string& stateFile);
+    bool saveDatabaseDelta(const std::string& stateFile, const std::string& baseStateFile);  // Changes since previous state only; false if the base is gone
+    void commitCurrentState();                          // The current scan becomes the previous state
     
     // Change detection
+    StateDiff diffStates() const;
     std::vector<std::string> getChangedFiles();
     std::vector<std::string> getNewFiles();
     std::vector<std::string> getDeletedFiles();
@@ -36,7 +56,8 @@ public:
     // File information
     bool hasFileChanged(const std::string& filePath);
     FileInfo getFileInfo(const std::string& filePath);
-    std::string calculateFileChecksum(const std::string& filePath);
+    Digest calculateFileChecksum(const std::string& filePath);
+    Digest getDirectoryDigest(const std::string& directoryPath) const;
     
     // Database management
     void updateFileInfo(const std::string& filePath, const FileInfo& info);
@@ -47,14 +68,44 @@ public:
     size_t getTotalFiles() const;
     size_t getChangedFilesCount() const;
     size_t getTotalSize() const;
+    
+    // Checksum reads are charged here (not owned, may be null)
+    void setIoThrottle(IoThrottle* throttle);
+    
+    // Order in which a scan reads the files it has to hash
+    void setReadOrder(ReadOrder::Mode mode);
 
 private:
+    // Aggregate digests of every directory, computed bottom-up from its children
+    struct DirectoryIndex {
+        std::string root;
+        std::unordered_map<std::string, Digest> digests;
+        std::unordered_map<std::string, std::vector<std::string>> children;  // Sorted child names
+    };
+
     std::unordered_map<std::string, FileInfo> currentState_;
     std::unordered_map<std::string, FileInfo> previousState_;
+    DirectoryIndex currentDirectories_;
+    DirectoryIndex previousDirectories_;
+    IoThrottle* ioThrottle_ = nullptr;
+    ReadOrder::Mode readOrder_ = ReadOrder::Mode::AUTO;
+    std::uint64_t chargedBytes_ = 0;    // Estimated state size charged to the MemoryBudget
     
     // Helper methods
-    FileInfo createFileInfo(const std::filesystem::directory_entry& entry);
-    std::string calculateChecksumSHA256(const std::string& filePath);
+    bool scan(const std::string& path, bool reuseChecksums);
+    // Charges the state to the MemoryBudget; the state itself is never bounded or spilled
+    void chargeState();
+    FileInfo createFileInfo(const std::filesystem::directory_entry& entry, bool reuseChecksums);
+    Digest calculateChecksumSHA256(const std::string& filePath);
     bool compareFileInfo(const FileInfo& current, const FileInfo& previous) const;
-    void scanDirectoryRecursive(const std::string& path);
+    void scanDirectoryRecursive(const std::string& path, bool reuseChecksums);
+    void diffDirectory(const std::string& currentPath, const std::string& previousPath,
+                       const std::string& relativePath, StateDiff& diff) const;
+    std::vector<std::string> toCurrentPaths(const std::vector<std::string>& relativePaths) const;
+    static bool readStateFile(const std::string& stateFile, std::unordered_map<std::string, FileInfo>& files,
+                              DirectoryIndex& index, size_t depth = 0);
+    static nlohmann::json fileInfoToJson(const FileInfo& info);
+    static FileInfo fileInfoFromJson(const nlohmann::json& item);
+    static void buildDirectoryIndex(const std::unordered_map<std::string, FileInfo>& files, DirectoryIndex& index);
+    static std::string childPath(const std::string& directory, const std::string& name);
 };
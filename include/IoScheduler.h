@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+/**
+ * Weighted fair sharing of disk I/O between concurrently running backup jobs
+ *
+ * Each job advances a virtual clock by the bytes it moves divided by its
+ * weight. A job that runs more than one slice ahead of the slowest active
+ * job in its priority class waits for the others to catch up. While a
+ * higher-priority job is active, lower classes wait too. I/O on files of at
+ * most smallFileBytes passes straight through, so metadata and small-file
+ * I/O keep low latency behind a large job; it is still charged to the
+ * job's share. No request waits longer than maxWait, so nothing starves.
+ *
+ * Jobs are bound to threads: a JobScope registers the job for the calling
+ * thread, and charge() bills whatever job is bound to the caller. Callers
+ * announce each file's size with setCurrentFile() before moving its data.
+ */
+class IoScheduler {
+public:
+    struct Options {
+        std::uint64_t sliceBytes = 4 * 1024 * 1024;         // Lead allowed over the slowest job (weight 100)
+        std::uintmax_t smallFileBytes = 64 * 1024;          // Files this small are served without waiting
+        std::chrono::milliseconds activeWindow{200};        // A job idle this long stops counting
+        std::chrono::milliseconds maxWait{250};             // Longest a single request is held
+    };
+
+    struct JobStats {
+        std::string name;
+        unsigned int weight = 100;
+        int priority = 0;
+        bool active = false;
+        std::uintmax_t bytesRead = 0;
+        std::uintmax_t bytesWritten = 0;
+        std::uintmax_t operations = 0;
+        double bytesPerSecond = 0.0;        // Over the last few seconds
+        double waitSeconds = 0.0;           // Total time held back for fairness
+    };
+
+    struct Job;
+
+    /**
+     * Binds a job to the calling thread for the lifetime of the scope
+     */
+    class JobScope {
+    public:
+        JobScope(IoScheduler& scheduler, const std::string& name, unsigned int weight, int priority);
+        ~JobScope();
+
+        JobScope(const JobScope&) = delete;
+        JobScope& operator=(const JobScope&) = delete;
+
+    private:
+        IoScheduler& scheduler_;
+        std::shared_ptr<Job> job_;
+        std::shared_ptr<Job> previous_;
+    };
+
+    IoScheduler();
+    explicit IoScheduler(const Options& options);
+    ~IoScheduler();
+
+    IoScheduler(const IoScheduler&) = delete;
+    IoScheduler& operator=(const IoScheduler&) = delete;
+
+    // Bills the job bound to the calling thread; no-op without one
+    static void charge(size_t bytes, bool write);
+    static void setCurrentFile(std::uintmax_t size);
+
+    // Information
+    bool hasConcurrentJobs() const;
+    std::vector<JobStats> getJobStats() const;
+
+private:
+    Options options_;
+    mutable std::mutex mutex_;
+    std::condition_variable turn_;
+    std::map<std::string, std::shared_ptr<Job>> jobs_;
+
+    // Helper methods
+    std::shared_ptr<Job> attach(const std::string& name, unsigned int weight, int priority);
+    void detach(const std::shared_ptr<Job>& job);
+    void account(Job& job, size_t bytes, bool write);
+    bool mustWait(const Job& job, std::chrono::steady_clock::time_point now) const;
+    bool isActive(const Job& job, std::chrono::steady_clock::time_point now) const;
+};
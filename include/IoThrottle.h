@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "RateLimiter.h"
+
+/**
+ * Read bandwidth, write bandwidth and IOPS limits for the backup pipeline
+ *
+ * One instance is shared by every stage that touches the disk: source reads,
+ * compression and encryption passes, and blob and pack writes. Each call
+ * charges one I/O operation plus its bytes. Limits may change at any time.
+ * The calling thread's IoScheduler job is billed first, so concurrent jobs
+ * share the budget fairly.
+ */
+class IoThrottle {
+public:
+    struct Limits {
+        std::uintmax_t readBytesPerSecond = 0;      // 0 = unlimited
+        std::uintmax_t writeBytesPerSecond = 0;
+        std::uint32_t iops = 0;                     // Read and write calls combined
+
+        bool any() const { return readBytesPerSecond > 0 || writeBytesPerSecond > 0 || iops > 0; }
+    };
+
+    IoThrottle();
+    ~IoThrottle();
+
+    // Configuration
+    void setLimits(const Limits& limits);
+    Limits getLimits() const;
+    bool isLimited() const;
+
+    // Accounting; blocks while over budget
+    void read(size_t bytes);
+    void write(size_t bytes);
+
+    // "50M", "512K", "1G" or plain bytes; "0" and "off" mean unlimited
+    static bool parseRate(const std::string& text, std::uintmax_t& bytesPerSecond);
+    static std::string describe(const Limits& limits);
+
+private:
+    RateLimiter readBytes_;
+    RateLimiter writeBytes_;
+    RateLimiter operations_;
+};
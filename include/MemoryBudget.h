@@ -0,0 +1,85 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+/**
+ * Process-wide memory budget shared by buffers, in-flight blocks and metadata
+ *
+ * Memory is accounted in two ways. Long-lived structures (pool slabs, cached
+ * blocks, file state, metadata entries) are charged: a charge never blocks, but
+ * it counts against the limit, and owners that can drop or spill what they hold
+ * check overBudget() and do so. Data in flight between a producer and its
+ * consumer is reserved: reserve() blocks until the reservation fits under the
+ * limit, so producers wait for consumers instead of queueing without bound. A
+ * reservation is always granted when nothing else is reserved, so a single
+ * producer keeps moving even when charges alone exceed the limit. With no limit
+ * set, everything is still counted but nothing blocks or spills.
+ */
+class MemoryBudget {
+public:
+    // Reserved bytes; released when destroyed
+    class Reservation {
+    public:
+        Reservation() = default;
+        ~Reservation();
+        Reservation(Reservation&& other) noexcept;
+        Reservation& operator=(Reservation&& other) noexcept;
+
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+
+        std::uint64_t bytes() const { return bytes_; }
+        void release();
+
+    private:
+        friend class MemoryBudget;
+        std::uint64_t bytes_ = 0;
+    };
+
+    struct Stats {
+        std::uint64_t limit = 0;            // 0 = unlimited
+        std::uint64_t charged = 0;
+        std::uint64_t reserved = 0;
+        std::uint64_t peak = 0;             // Highest charged + reserved seen
+        std::uint64_t waits = 0;            // Reservations that had to block
+        double waitSeconds = 0.0;
+        std::uint64_t spills = 0;           // Times an owner moved data to disk
+    };
+
+    static MemoryBudget& instance();
+
+    void setLimit(std::uint64_t bytes);
+    std::uint64_t getLimit() const;
+    bool isLimited() const;
+
+    // In-flight data; blocks while the budget is full
+    Reservation reserve(std::uint64_t bytes);
+
+    // Long-lived data; charge() always succeeds, tryCharge() only under the limit
+    void charge(std::uint64_t bytes);
+    bool tryCharge(std::uint64_t bytes);
+    void uncharge(std::uint64_t bytes);
+
+    bool overBudget() const;
+    void recordSpill();
+    Stats getStats() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+    std::uint64_t limit_;
+    std::uint64_t charged_;
+    std::uint64_t reserved_;
+    std::uint64_t peak_;
+    std::uint64_t waits_;
+    double waitSeconds_;
+    std::uint64_t spills_;
+
+    MemoryBudget();
+
+    // Helper methods
+    void releaseReserved(std::uint64_t bytes);
+    void notePeak();
+};
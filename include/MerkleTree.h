@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include "Digest.h"
+
+/**
+ * Merkle tree over backed-up files, organized by directory
+ *
+ * Each directory's digest is a binary Merkle root over its sorted children, so
+ * two trees can be compared by descending only into subtrees whose digests
+ * differ, and a single file's inclusion can be proven with a short path.
+ */
+class MerkleTree {
+public:
+    struct ProofStep {
+        Digest sibling;
+        bool siblingOnLeft;
+    };
+
+    struct ProofLevel {
+        std::string name;               // Child hashed at this level (file first, then directories)
+        std::vector<ProofStep> steps;   // Sibling path inside the directory
+    };
+
+    struct InclusionProof {
+        std::string relativePath;
+        std::vector<ProofLevel> levels; // Innermost directory first, root last
+    };
+
+    MerkleTree();
+    ~MerkleTree();
+
+    // Construction
+    void addFile(const std::string& relativePath, const Digest& checksum, std::uintmax_t size);
+    void build();
+    void clear();
+
+    // Digests
+    Digest getRoot() const;
+    Digest getDirectoryDigest(const std::string& directory) const;
+    std::map<std::string, Digest> getDirectoryDigests() const;
+
+    // Comparison
+    std::vector<std::string> diff(const MerkleTree& other) const;
+    std::vector<std::string> findMismatchedDirectories(const std::map<std::string, Digest>& recorded) const;
+
+    // Inclusion proofs
+    bool getInclusionProof(const std::string& relativePath, InclusionProof& proof) const;
+    static bool verifyInclusionProof(const InclusionProof& proof, const Digest& checksum,
+                                     std::uintmax_t size, const Digest& root);
+
+private:
+    struct Child {
+        bool isDirectory = false;
+        Digest checksum;                // File content digest
+        std::uintmax_t size = 0;
+    };
+
+    struct Directory {
+        std::map<std::string, Child> children;
+        Digest digest;
+    };
+
+    std::map<std::string, Directory> directories_;
+    bool built_;
+
+    // Helper methods
+    Directory& ensureDirectory(const std::string& path);
+    std::vector<Digest> childHashes(const std::string& path, const Directory& directory) const;
+    void diffDirectory(const MerkleTree& other, const std::string& path,
+                       const Directory* mine, const Directory* theirs,
+                       std::vector<std::string>& differences) const;
+    void collectFiles(const std::string& path, const Directory& directory,
+                      std::vector<std::string>& files) const;
+
+    static std::string normalizePath(const std::string& path);
+    static std::string joinPath(const std::string& directory, const std::string& name);
+    static Digest fileHash(const std::string& name, const Digest& checksum, std::uintmax_t size);
+    static Digest directoryHash(const std::string& name, const Digest& digest);
+    static Digest nodeHash(const Digest& left, const Digest& right);
+    static Digest foldHashes(std::vector<Digest> hashes);
+};
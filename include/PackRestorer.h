@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "PackStore.h"
+
+class Encryptor;
+class BlockCache;
+
+/**
+ * Restores files from pack blobs with a few large sequential reads
+ *
+ * Records are read in (pack, offset) order rather than path order, and blobs
+ * no more than maxGap bytes apart are read as one run, reading through the gap
+ * instead of seeking over it. A single reader decodes each blob as it streams
+ * past and hands the plaintext in pieces to the writer threads. All pieces of
+ * a record go to the same writer, which also hashes them against the journal
+ * checksum. At most bufferBytes of decoded data wait for writers at any time,
+ * so memory stays flat regardless of file sizes. With a BlockCache attached,
+ * content that was decoded before is served from memory instead of the pack.
+ */
+class PackRestorer {
+public:
+    struct Options {
+        std::uint64_t maxGap = PackStore::DEFAULT_READ_GAP;
+        size_t readBlockBytes = 4 * 1024 * 1024;    // Size of each pack read
+        size_t bufferBytes = 32 * 1024 * 1024;      // Decoded data queued for writers
+        size_t writers = 4;
+    };
+
+    struct Result {
+        size_t restored = 0;
+        size_t failed = 0;
+        size_t runs = 0;
+        std::uint64_t bytesRead = 0;                // Pack bytes read, gaps included
+        size_t cacheHits = 0;                       // Records served from the block cache
+    };
+
+    using ProgressCallback = std::function<void(size_t done, size_t total)>;
+
+    // encryptor holds the key for encrypted records (not owned, may be null)
+    PackRestorer(const std::string& directory, const Encryptor* encryptor);
+    PackRestorer(const std::string& directory, const Encryptor* encryptor, const Options& options);
+
+    // Decoded blobs are looked up and kept here (not owned, may be null)
+    void setBlockCache(BlockCache* cache);
+
+    // Writes each non-deleted record to restorePath/relativePath
+    Result restore(const std::vector<PackStore::Record>& records, const std::string& restorePath,
+                   ProgressCallback progress = nullptr);
+
+private:
+    std::string directory_;
+    const Encryptor* encryptor_;
+    BlockCache* cache_;
+    Options options_;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include "Digest.h"
+
+class IoThrottle;
+
+/**
+ * Append-only pack files plus a JSON-lines journal for continuous data protection
+ *
+ * A commit appends the stored blob of each file to the current pack and syncs
+ * it. It then appends one journal line per file, followed by a commit marker.
+ * Records after the last marker belong to an interrupted commit and are
+ * ignored, and open() truncates their bytes from the pack.
+ */
+class PackStore {
+public:
+    struct Record {
+        std::uint64_t commit = 0;
+        std::chrono::system_clock::time_point time;
+        std::string relativePath;
+        bool deleted = false;           // The path and everything below it were removed
+        std::string pack;
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;       // Stored bytes in the pack
+        std::uintmax_t size = 0;        // Original file size
+        Digest checksum;                // SHA-256 of the original file
+        bool compressed = false;
+        bool encrypted = false;
+    };
+
+    // One sequential read covering the blobs of nearby records in the same pack
+    struct ReadRun {
+        std::string pack;
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+        std::vector<size_t> records;    // Indices into the planned records, in offset order
+    };
+
+    static constexpr std::uint64_t DEFAULT_PACK_LIMIT = 256ull * 1024 * 1024;
+    static constexpr std::uint64_t DEFAULT_READ_GAP = 1024 * 1024;
+    static constexpr const char* JOURNAL_FILE = "cdp_journal.jsonl";
+
+    explicit PackStore(const std::string& directory, std::uint64_t packLimit = DEFAULT_PACK_LIMIT);
+    ~PackStore();
+
+    PackStore(const PackStore&) = delete;
+    PackStore& operator=(const PackStore&) = delete;
+
+    bool open();
+    void close();
+    std::string getDirectory() const;
+    std::uint64_t getLastCommit() const;
+    void setIoThrottle(IoThrottle* throttle);   // Not owned, may be null
+
+    // Commit building; nothing is visible to readers until commit() returns
+    bool beginCommit();
+    bool appendBlob(const std::string& blobPath, Record record);
+    void recordDeletion(const std::string& relativePath);
+    bool commit();
+    void abortCommit();
+
+    // Reading committed history
+    static bool readJournal(const std::string& directory, std::vector<Record>& records);
+    static bool extractBlob(const std::string& directory, const Record& record, const std::string& outputPath);
+    
+    // Orders blob reads by (pack, offset); blobs at most maxGap bytes apart share a run
+    static std::vector<ReadRun> planReads(const std::vector<Record>& records, std::uint64_t maxGap = DEFAULT_READ_GAP);
+
+private:
+    std::string directory_;
+    std::uint64_t packLimit_;
+    std::uint64_t lastCommit_;
+    std::string packName_;
+    FILE* pack_;
+    std::uint64_t packSize_;
+    std::uint64_t committedSize_;       // Pack bytes covered by committed records
+    bool inCommit_;
+    std::vector<Record> staged_;
+    IoThrottle* ioThrottle_;
+
+    // Helper methods
+    bool openPack(const std::string& name, std::uint64_t committedSize);
+    std::string nextPackName() const;
+    static bool syncFile(FILE* file);
+};
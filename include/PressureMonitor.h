@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <functional>
+
+/**
+ * Samples system resource pressure from Linux PSI (/proc/pressure)
+ *
+ * Values are the "some avg10" percentages: the share of the last 10 seconds
+ * in which at least one task stalled on the resource. Kernels without PSI
+ * fall back to the 1-minute load average per CPU. Applications can add their
+ * own signals on the same 0-100 scale (e.g. request latency or queue depth).
+ */
+class PressureMonitor {
+public:
+    struct Thresholds {
+        double io = 40.0;
+        double cpu = 60.0;
+        double memory = 20.0;
+        double loadPerCpu = 1.5;    // Used only when PSI is unavailable
+        double signal = 80.0;       // Applies to every application signal
+    };
+
+    struct Sample {
+        bool psiAvailable = false;
+        double io = 0.0;
+        double cpu = 0.0;
+        double memory = 0.0;
+        double loadPerCpu = 0.0;
+        std::map<std::string, double> signals;
+    };
+
+    using Signal = std::function<double()>;
+
+    PressureMonitor();
+    explicit PressureMonitor(const Thresholds& thresholds);
+    ~PressureMonitor();
+
+    // Configuration
+    void setThresholds(const Thresholds& thresholds);
+    Thresholds getThresholds() const;
+    void addSignal(const std::string& name, Signal signal);
+    void removeSignal(const std::string& name);
+
+    // Sampling
+    Sample sample() const;
+    bool isHigh(const Sample& sample, std::string* reason = nullptr) const;
+
+    static bool readPsi(const std::string& path, double& avg10);
+
+private:
+    mutable std::mutex mutex_;
+    Thresholds thresholds_;
+    std::map<std::string, Signal> signals_;
+
+    // Helper methods
+    static bool readLoadPerCpu(double& loadPerCpu);
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Token bucket shared by any number of threads
+ *
+ * Each thread takes tokens from the shared bucket in slices of about 10 ms
+ * worth and spends them from a thread-local cache, so small, frequent
+ * acquisitions rarely touch the lock. A caller that overdraws the bucket
+ * sleeps until the debt is repaid. Changing the rate invalidates every
+ * thread's cache, so the new rate applies at once.
+ */
+class RateLimiter {
+public:
+    RateLimiter();
+    explicit RateLimiter(double tokensPerSecond);
+    ~RateLimiter();
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    // Configuration (0 = unlimited)
+    void setRate(double tokensPerSecond);
+    double getRate() const;
+    bool isLimited() const;
+
+    // Blocks until the tokens are available
+    void acquire(double tokens);
+
+private:
+    const std::uint64_t id_;                // Keys the per-thread caches
+    std::atomic<bool> limited_;
+    std::atomic<std::uint64_t> generation_;
+
+    mutable std::mutex mutex_;
+    double rate_;
+    double burst_;
+    double available_;                      // Negative while callers are paying off debt
+    std::chrono::steady_clock::time_point lastRefill_;
+
+    // Helper methods
+    std::chrono::duration<double> take(double tokens);
+};
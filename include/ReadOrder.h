@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Orders a list of files for reading by where they sit on disk
+ *
+ * Directory order has little to do with block placement, so reading a tree in
+ * recursive_directory_iterator order makes a spinning disk seek between almost
+ * every file. PHYSICAL sorts by the first extent's physical offset from FIEMAP.
+ * On filesystems without FIEMAP, and for files with no mapped extents (empty,
+ * inline or not yet allocated), it falls back to the inode number, which most
+ * filesystems allocate close to the data. AUTO applies PHYSICAL to files on
+ * rotational devices and leaves everything else in scan order.
+ */
+class ReadOrder {
+public:
+    enum class Mode {
+        AUTO,
+        SCAN,           // As listed
+        INODE,
+        PHYSICAL
+    };
+
+    struct Extent {
+        std::uint64_t logical = 0;
+        std::uint64_t physical = 0;
+        std::uint64_t length = 0;
+    };
+
+    // Permutation of indices into paths in the order they should be read
+    static std::vector<size_t> plan(const std::vector<std::string>& paths, Mode mode);
+    static void arrange(std::vector<std::string>& paths, Mode mode);
+
+    // Whether plan() reorders files on this st_dev; others keep their listed order
+    static bool ordersDevice(std::uint64_t device, Mode mode);
+
+    // Extents of a file via FIEMAP; false when the filesystem cannot report them
+    static bool mapExtents(const std::string& path, std::vector<Extent>& extents, size_t maxExtents = 0);
+
+    static bool parseMode(const std::string& text, Mode& mode);
+    static std::string modeToString(Mode mode);
+};
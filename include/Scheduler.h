@@ -5,7 +5,17 @@
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <vector>
 #include <unordered_map>
+#include <cstdint>
+#include "Scrubber.h"
+#include "PressureMonitor.h"
+
+class ThreadPool;
 
 /**
  * Handles automatic backup scheduling
@@ -27,6 +37,18 @@ public:
         std::chrono::system_clock::time_point nextRun;
         std::string backupName;
         bool enabled;
+        std::string sourcePath;     // Runs sharing a source never overlap; empty = keyed by name
+        unsigned int ioWeight = 100;    // Fair share of disk I/O against concurrent runs
+        int ioPriority = 0;             // Higher classes are served first
+    };
+
+    // Deferral of due backups while the system is under pressure
+    struct PressurePolicy {
+        bool enabled = false;
+        PressureMonitor::Thresholds thresholds;
+        std::chrono::seconds maxDelay{3600};        // Run anyway once a backup is this late
+        std::chrono::seconds recheckInterval{30};   // How often a deferred backup looks again
+        std::chrono::seconds sampleInterval{5};     // Sampling period while backups are running
     };
 
     Scheduler();
@@ -36,49 +58,108 @@ public:
     bool scheduleBackup(const std::string& name, ScheduleType type, 
                        std::chrono::seconds customInterval = std::chrono::seconds(0));
     bool scheduleBackupAt(const std::string& name, const std::chrono::system_clock::time_point& when);
+    bool setScheduleSource(const std::string& name, const std::string& sourcePath);
+    bool setScheduleIoShare(const std::string& name, unsigned int weight, int priority);
     bool cancelScheduledBackup(const std::string& name);
     bool pauseScheduledBackup(const std::string& name);
     bool resumeScheduledBackup(const std::string& name);
+    bool runNow(const std::string& name);   // Fire an existing schedule immediately
     
     // Scheduler control
     void start();
     void stop();
     bool isRunning() const;
     
+    // Background scrubbing (paused while any backup or restore job runs)
+    void enableScrubbing(const Scrubber::Options& options);
+    void disableScrubbing();
+    bool isScrubbingEnabled() const;
+    Scrubber::Stats getScrubStats() const;
+    void beginJob();
+    void endJob();
+    
     // Callback management
     void setBackupCallback(std::function<bool(const std::string&)> callback);
     void setErrorCallback(std::function<void(const std::string&, const std::string&)> callback);
+    void setPressureCallback(std::function<void(bool, const std::string&)> callback);  // (high, reason)
     
     // Information
     std::vector<ScheduleInfo> getScheduledBackups() const;
+    bool getSchedule(const std::string& name, ScheduleInfo& info) const;
     std::chrono::system_clock::time_point getNextScheduledTime() const;
     size_t getActiveSchedulesCount() const;
+    size_t getRunningBackupsCount() const;
     
-    // Configuration
+    // Configuration (the concurrency limit sizes the executor at start())
     void setMaxConcurrentBackups(size_t maxConcurrent);
     void setRetryAttempts(int attempts);
     void setRetryDelay(std::chrono::seconds delay);
+    void setStartJitter(std::chrono::seconds jitter);   // Spread first runs of recurring schedules
+    void setPressurePolicy(const PressurePolicy& policy);
+    void addPressureSignal(const std::string& name, PressureMonitor::Signal signal);
     
     // Persistence
     bool saveSchedulesToFile(const std::string& filename);
     bool loadSchedulesFromFile(const std::string& filename);
 
 private:
+    // Heap entry for one pending run; every re-arm, pause or cancel retires the
+    // schedule's previous generation, and entries of a retired one are dropped lazily
+    struct Timer {
+        std::chrono::system_clock::time_point when;
+        std::string name;
+        std::uint64_t generation;
+        
+        bool operator>(const Timer& other) const { return when > other.when; }
+    };
+    
     std::unordered_map<std::string, ScheduleInfo> schedules_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::unordered_map<std::string, std::uint64_t> armed_;              // Schedule -> generation of its live timer
+    std::uint64_t nextGeneration_;
+    mutable std::mutex scheduleMutex_;
+    std::condition_variable wakeup_;
     std::atomic<bool> running_;
     std::thread schedulerThread_;
+    std::unique_ptr<ThreadPool> executor_;
+    std::unordered_map<std::string, std::string> busySources_;          // Source -> schedule running against it
+    std::unordered_map<std::string, std::vector<std::string>> deferred_;  // Source -> schedules waiting on it
+    std::unordered_map<std::string, int> attempts_;                     // Attempts made by the current run
     
     std::function<bool(const std::string&)> backupCallback_;
     std::function<void(const std::string&, const std::string&)> errorCallback_;
+    std::function<void(bool, const std::string&)> pressureCallback_;
+    
+    std::unique_ptr<Scrubber> scrubber_;
+    mutable std::mutex jobMutex_;
+    size_t activeJobs_;
     
     size_t maxConcurrentBackups_;
     int retryAttempts_;
     std::chrono::seconds retryDelay_;
     
+    PressurePolicy pressurePolicy_;
+    PressureMonitor pressureMonitor_;
+    std::chrono::system_clock::time_point lastSampleTime_;
+    bool pressureHigh_;
+    std::string pressureReason_;
+    std::unordered_map<std::string, std::chrono::system_clock::time_point> deferredSince_;
+    std::chrono::seconds startJitter_;
+    
     // Internal methods
     void schedulerLoop();
     std::chrono::system_clock::time_point calculateNextRun(const ScheduleInfo& schedule);
-    void executeScheduledBackup(const std::string& name);
+    void dispatchBackup(const std::string& name);
+    void finishBackup(const std::string& name, const std::string& source, bool success);
+    bool executeScheduledBackup(const std::string& name, int attempt);
     bool shouldExecuteBackup(const ScheduleInfo& schedule);
     void updateNextRunTime(const std::string& name);
+    void addTimer(const std::string& name, const ScheduleInfo& schedule);
+    void disarmTimer(const std::string& name);
+    bool isTimerCurrent(const Timer& timer) const;
+    void rebuildTimers();
+    bool refreshPressure(std::unique_lock<std::mutex>& lock);
+    bool deferForPressure(const std::string& name, ScheduleInfo& schedule);
+    std::chrono::seconds startOffset(const std::string& name) const;
+    static std::string sourceKey(const std::string& name, const ScheduleInfo& schedule);
 };
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <unordered_map>
+#include "BackupMetadata.h"
+
+/**
+ * Background at-rest verification of every blob in a backup repository
+ *
+ * Blobs are checked least recently verified first, within a bandwidth and
+ * read-rate budget. Progress is persisted so a restarted scrubber resumes
+ * where it stopped, and pausing takes effect before the next block is read.
+ */
+class Scrubber {
+public:
+    struct Options {
+        std::string repositoryPath;                 // Directory holding backup_* directories
+        std::uintmax_t bytesPerSecond = 16 * 1024 * 1024;  // 0 = unlimited
+        size_t readsPerSecond = 0;                  // Block reads per second, 0 = unlimited
+        std::chrono::seconds minInterval{24 * 3600};  // Don't re-verify a blob more often than this
+        std::string statePath;                      // Empty = scrub_state.json in the repository
+    };
+
+    struct Stats {
+        size_t blobsVerified = 0;
+        size_t blobsCorrupt = 0;
+        size_t blobsSkipped = 0;                    // No stored digest to check against
+        size_t passesCompleted = 0;
+        std::uintmax_t bytesRead = 0;
+        std::string lastBlob;
+    };
+
+    explicit Scrubber(const Options& options);
+    ~Scrubber();
+
+    // Control
+    void start();
+    void stop();
+    bool isRunning() const;
+    void pause();
+    void resume();
+    bool isPaused() const;
+
+    // Callback management
+    void setErrorCallback(std::function<void(const std::string&, const std::string&)> callback);
+
+    // Information
+    Stats getStats() const;
+
+private:
+    struct BlobRecord {
+        std::chrono::system_clock::time_point lastVerified;
+        bool corrupt = false;
+    };
+
+    struct Blob {
+        std::string key;                            // "<backup directory>/<relative path>"
+        std::string path;
+        BackupMetadata::FileEntry entry;
+        std::uint32_t blockSize = 0;
+    };
+
+    Options options_;
+    std::function<void(const std::string&, const std::string&)> errorCallback_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::thread scrubThread_;
+    bool running_;
+    bool paused_;
+    Stats stats_;
+
+    std::unordered_map<std::string, BlobRecord> records_;
+    std::string cursor_;                            // Last blob completed, breaks ties in the order
+    std::chrono::steady_clock::time_point nextRead_;
+    std::chrono::steady_clock::time_point lastSave_;
+
+    // Helper methods
+    void scrubLoop();
+    std::vector<Blob> collectBlobs() const;
+    std::vector<const Blob*> orderBlobs(const std::vector<Blob>& blobs) const;
+    bool scrubBlob(const Blob& blob);
+    bool throttle(size_t blockBytes);
+    bool waitWhilePaused(std::unique_lock<std::mutex>& lock);
+    bool loadState();
+    bool saveState();
+    std::string statePath() const;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include "Digest.h"
+
+/**
+ * Checksums of a stored blob, accumulated from the bytes as they are written
+ *
+ * The copy, compress and encrypt passes hand every byte they write to sink(),
+ * so the SHA-256 of the blob and its CRC32C per blockSize block are known when
+ * the blob is closed, without reading it back. The result matches what
+ * Utils::calculateStoredChecksums computes from the finished file.
+ */
+class StoredChecksums {
+public:
+    using DataSink = std::function<bool(const uint8_t*, size_t)>;
+
+    explicit StoredChecksums(size_t blockSize);
+
+    StoredChecksums(const StoredChecksums&) = delete;
+    StoredChecksums& operator=(const StoredChecksums&) = delete;
+
+    void update(const uint8_t* data, size_t length);
+    DataSink sink();
+
+    // Closes the running digest; false if there is nothing to record
+    bool finish(Digest& digest, std::vector<uint32_t>& blockChecksums);
+
+private:
+    DigestBuilder builder_;
+    size_t blockSize_;
+    size_t blockFill_;          // Bytes in the current, unfinished block
+    uint32_t blockCrc_;
+    std::vector<uint32_t> blockChecksums_;
+    bool finished_;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size worker pool used to run pipeline tasks in parallel
+ *
+ * The number of threads is fixed, but how many of them run tasks at once can be
+ * lowered and raised again with setConcurrency(); the rest stay parked. Tasks
+ * are always started in submission order.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Task management
+    void submit(std::function<void()> task);
+    void waitIdle();
+    
+    // Tasks allowed to run at once, between 1 and the thread count
+    void setConcurrency(size_t limit);
+    size_t getConcurrency() const;
+    
+    // Information
+    size_t getThreadCount() const;
+    size_t getPendingTasks() const;
+    size_t getActiveTasks() const;
+
+    static size_t defaultThreadCount();
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    mutable std::mutex mutex_;
+    std::condition_variable taskAvailable_;
+    std::condition_variable idle_;
+    size_t activeTasks_;
+    size_t concurrency_;
+    bool stopping_;
+    
+    void workerLoop();
+};
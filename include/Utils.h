@@ -4,6 +4,8 @@
 #include <vector>
 #include <chrono>
 #include <filesystem>
+#include <functional>
+#include "Digest.h"
 
 /**
  * Utility functions for the backup system
@@ -37,11 +39,21 @@ public:
     static std::string toLower(const std::string& str);
     static std::string toUpper(const std::string& str);
     
+    // Hex utilities (SIMD accelerated where available)
+    static std::string hexEncode(const uint8_t* data, size_t length);
+    static std::string hexEncode(const std::vector<uint8_t>& data);
+    static bool hexDecode(const std::string& hex, uint8_t* out, size_t outLength);
+    static std::vector<uint8_t> hexDecode(const std::string& hex);
+    
     // Checksum utilities
-    static std::string calculateSHA256(const std::string& filePath);
-    static std::string calculateSHA256(const std::vector<uint8_t>& data);
-    static std::string calculateMD5(const std::string& filePath);
-    static bool verifyChecksum(const std::string& filePath, const std::string& expectedChecksum);
+    static Digest calculateSHA256(const std::string& filePath);
+    static Digest calculateSHA256(const std::string& filePath, const std::function<void(size_t)>& onRead);
+    static Digest calculateSHA256(const std::vector<uint8_t>& data);
+    static Digest calculateMD5(const std::string& filePath);
+    static bool verifyChecksum(const std::string& filePath, const Digest& expectedChecksum);
+    static uint32_t crc32c(const uint8_t* data, size_t length, uint32_t crc = 0);
+    static bool calculateStoredChecksums(const std::string& filePath, size_t blockSize,
+                                         Digest& digest, std::vector<uint32_t>& blockChecksums);
     
     // Time utilities
     static std::chrono::system_clock::time_point parseTimestamp(const std::string& timestamp);
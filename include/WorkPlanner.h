@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Turns the scanned file list into copy tasks sized for the worker pools
+ *
+ * Handing out one file per task in directory order ends with a single worker
+ * grinding through the largest file while the rest sit idle. The planner uses
+ * the sizes from the scan instead: files above splitThreshold become one task
+ * per blockSize range, each encoded as its own blob segment; files at or below
+ * smallFileLimit are batched so per-task overhead is paid once per batch; and
+ * everything else stays one task per file. On devices whose reads follow the
+ * on-disk order (see ReadOrder) tasks keep that order; on the others they are
+ * sorted longest first, so the big pieces start early and the small ones fill
+ * in at the end.
+ */
+class WorkPlanner {
+public:
+    struct Options {
+        std::uint64_t splitThreshold = 256ull * 1024 * 1024;   // 0 = never split
+        std::uint64_t blockSize = 32ull * 1024 * 1024;
+        std::uint64_t smallFileLimit = 64 * 1024;               // 0 = never batch
+        std::uint64_t batchBytes = 4 * 1024 * 1024;
+        size_t batchFiles = 128;
+    };
+
+    struct File {
+        std::uint64_t size = 0;
+        std::uint64_t device = 0;
+        bool ordered = false;           // The device is read in on-disk order
+    };
+
+    // A whole file, or one block of a split file
+    struct Item {
+        size_t file = 0;                // Index into the planned files
+        size_t block = 0;
+        size_t blocks = 1;              // Blocks the file was split into; 1 = not split
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+    };
+
+    struct Task {
+        std::uint64_t device = 0;
+        std::uint64_t bytes = 0;
+        std::vector<Item> items;
+    };
+
+    // Files are taken in the order given; devices keep the order of their first file
+    static std::vector<Task> plan(const std::vector<File>& files, const Options& options);
+};
@@ -1,4 +1,5 @@
 #include "BackupMetadata.h"
+#include "Encryptor.h"
 #include "Utils.h"
 #include <fstream>
 #include <iostream>
@@ -19,6 +20,20 @@ bool BackupMetadata::createBackupInfo(const BackupInfo& info) {
     return true;
 }
 
+bool BackupMetadata::adoptBackupInfo(BackupInfo& info) {
+    if (!validateBackupInfo(info)) {
+        return false;
+    }
+    
+    // The file list can dwarf everything else, so it is not held twice
+    std::vector<FileEntry> files = std::move(info.files);
+    info.files.clear();
+    BackupInfo& stored = backups_[info.backupId];
+    stored = info;
+    stored.files = std::move(files);
+    return true;
+}
+
 bool BackupMetadata::updateBackupInfo(const std::string& backupId, const BackupInfo& info) {
     auto it = backups_.find(backupId);
     if (it == backups_.end()) {
@@ -216,35 +231,33 @@ bool BackupMetadata::verifyBackupIntegrity(const std::string& backupId) const {
         }
     }
     
+    // Sealed backups must still match their recorded Merkle root
+    if (!info.merkleRoot.empty() && calculateBackupChecksum(backupId) != info.merkleRoot) {
+        return false;
+    }
+    
     return true;
 }
 
-std::string BackupMetadata::calculateBackupChecksum(const std::string& backupId) const {
+Digest BackupMetadata::calculateBackupChecksum(const std::string& backupId) const {
     auto it = backups_.find(backupId);
     if (it == backups_.end()) {
-        return "";
-    }
-    
-    // Create a string representation of the backup info for checksumming
-    std::string data = it->second.backupId + it->second.backupType + it->second.sourcePath;
-    
-    for (const auto& fileEntry : it->second.files) {
-        data += fileEntry.relativePath + fileEntry.checksum + std::to_string(fileEntry.size);
+        return Digest();
     }
     
-    return Utils::calculateSHA256(std::vector<uint8_t>(data.begin(), data.end()));
+    return buildMerkleTree(backupId).getRoot();
 }
 
 bool BackupMetadata::validateFileChecksums(const std::string& backupId) const {
-    // This would need access to the actual backup files to verify checksums
-    // For now, just verify that checksums are present
+    // Content is checked against these digests by BackupVerifier; here we only
+    // make sure every entry carries a digest that verification can use
     auto it = backups_.find(backupId);
     if (it == backups_.end()) {
         return false;
     }
     
     for (const auto& fileEntry : it->second.files) {
-        if (fileEntry.checksum.empty()) {
+        if (fileEntry.checksum.algorithm() != Digest::Algorithm::SHA256) {
             return false;
         }
     }
@@ -252,6 +265,83 @@ bool BackupMetadata::validateFileChecksums(const std::string& backupId) const {
     return true;
 }
 
+MerkleTree BackupMetadata::buildMerkleTree(const std::string& backupId, const EntryStream& spilled) const {
+    MerkleTree tree;
+    auto it = backups_.find(backupId);
+    if (it != backups_.end()) {
+        for (const auto& fileEntry : it->second.files) {
+            tree.addFile(fileEntry.relativePath, fileEntry.checksum, fileEntry.size);
+        }
+    }
+    if (spilled) {
+        // The tree keeps only path, digest and size; each full entry is dropped once added
+        bool complete = spilled([&tree](const FileEntry& fileEntry) {
+            tree.addFile(fileEntry.relativePath, fileEntry.checksum, fileEntry.size);
+            return true;
+        });
+        if (!complete) {
+            tree.clear();
+            return tree;
+        }
+    }
+    tree.build();
+    return tree;
+}
+
+bool BackupMetadata::sealBackup(const std::string& backupId, Encryptor* signer, const EntryStream& spilled) {
+    auto it = backups_.find(backupId);
+    if (it == backups_.end()) {
+        return false;
+    }
+    
+    MerkleTree tree = buildMerkleTree(backupId, spilled);
+    BackupInfo& info = it->second;
+    info.merkleRoot = tree.getRoot();
+    info.directoryDigests = tree.getDirectoryDigests();
+    info.merkleSignature = Digest();
+    
+    if (signer && signer->hasKey()) {
+        info.merkleSignature = signer->calculateHMAC(signatureMessage(info));
+    }
+    
+    return !info.merkleRoot.empty();
+}
+
+bool BackupMetadata::verifyBackupSignature(const std::string& backupId, Encryptor& signer) const {
+    auto it = backups_.find(backupId);
+    if (it == backups_.end() || it->second.merkleSignature.empty()) {
+        return false;
+    }
+    
+    // The signature covers the recorded root, which must also match the entries
+    const BackupInfo& info = it->second;
+    return calculateBackupChecksum(backupId) == info.merkleRoot &&
+           signer.verifyHMAC(signatureMessage(info), info.merkleSignature);
+}
+
+std::vector<std::string> BackupMetadata::findDamagedDirectories(const std::string& backupId) const {
+    auto it = backups_.find(backupId);
+    if (it == backups_.end() || it->second.directoryDigests.empty()) {
+        return {};
+    }
+    
+    return buildMerkleTree(backupId).findMismatchedDirectories(it->second.directoryDigests);
+}
+
+std::vector<std::string> BackupMetadata::compareBackups(const std::string& backupIdA,
+                                                        const std::string& backupIdB) const {
+    return buildMerkleTree(backupIdA).diff(buildMerkleTree(backupIdB));
+}
+
+bool BackupMetadata::getInclusionProof(const std::string& backupId, const std::string& relativePath,
+                                       MerkleTree::InclusionProof& proof) const {
+    if (backups_.find(backupId) == backups_.end()) {
+        return false;
+    }
+    
+    return buildMerkleTree(backupId).getInclusionProof(relativePath, proof);
+}
+
 std::vector<std::string> BackupMetadata::listAllBackups() const {
     std::vector<std::string> backupIds;
     
@@ -345,22 +435,42 @@ bool BackupMetadata::loadFromFile(const std::string& filename) {
 }
 
 bool BackupMetadata::exportToJson(const std::string& filename) const {
+    return exportToJson(filename, "", nullptr);
+}
+
+bool BackupMetadata::exportToJson(const std::string& filename, const std::string& backupId,
+                                  const EntryStream& spilled) const {
     try {
-        json j;
-        j["version"] = "1.0";
-        j["backups"] = json::array();
-        
-        for (const auto& pair : backups_) {
-            j["backups"].push_back(backupInfoToJson(pair.second));
-        }
-        
         std::ofstream file(filename);
         if (!file.is_open()) {
             return false;
         }
         
-        file << j.dump(2);
-        return true;
+        // Streamed entry by entry: a DOM of every file would hold the whole list a second time
+        file << "{\"version\":\"1.0\",\"backups\":[";
+        bool firstBackup = true;
+        for (const auto& pair : backups_) {
+            std::string header = backupInfoToJson(pair.second).dump();
+            header.pop_back();
+            file << (firstBackup ? "\n" : ",\n") << header << ",\"files\":[";
+            bool firstFile = true;
+            auto writeEntry = [&](const FileEntry& fileEntry) {
+                file << (firstFile ? "\n" : ",\n") << fileEntryToJson(fileEntry).dump();
+                firstFile = false;
+                return static_cast<bool>(file);
+            };
+            for (const auto& fileEntry : pair.second.files) {
+                writeEntry(fileEntry);
+            }
+            if (spilled && pair.first == backupId && !spilled(writeEntry)) {
+                std::cerr << "Error: Failed to stream spilled entries into " << filename << std::endl;
+                return false;
+            }
+            file << "]}";
+            firstBackup = false;
+        }
+        file << "]}\n";
+        return static_cast<bool>(file.flush());
         
     } catch (const std::exception& e) {
         std::cerr << "Error exporting metadata: " << e.what() << std::endl;
@@ -438,6 +548,11 @@ bool BackupMetadata::removeOldBackups(const std::chrono::system_clock::time_poin
     return true;
 }
 
+std::string BackupMetadata::signatureMessage(const BackupInfo& info) {
+    // Bind the root to the backup it was computed for
+    return info.backupId + ":" + info.merkleRoot.toHex();
+}
+
 std::string BackupMetadata::generateBackupId() const {
     return Utils::generateUUID();
 }
@@ -455,12 +570,29 @@ json BackupMetadata::backupInfoToJson(const BackupInfo& info) const {
     j["encryptionMethod"] = info.encryptionMethod;
     j["compressionMethod"] = info.compressionMethod;
     j["compressionLevel"] = info.compressionLevel;
+    j["blockSize"] = info.blockSize;
     
-    j["files"] = json::array();
-    for (const auto& fileEntry : info.files) {
-        j["files"].push_back(fileEntryToJson(fileEntry));
+    if (!info.merkleRoot.empty()) {
+        json merkle;
+        merkle["root"] = info.merkleRoot.toHex();
+        if (!info.merkleSignature.empty()) {
+            merkle["hmac"] = info.merkleSignature.toHex();
+        }
+        merkle["directories"] = json::object();
+        for (const auto& pair : info.directoryDigests) {
+            merkle["directories"][pair.first] = pair.second.toHex();
+        }
+        j["merkle"] = merkle;
     }
     
+    if (info.parityDataShards > 0) {
+        j["parity"] = {
+            {"dataShards", info.parityDataShards},
+            {"parityShards", info.parityShards}
+        };
+    }
+    
+    // Files are left to exportToJson, which writes them one at a time
     return j;
 }
 
@@ -479,6 +611,22 @@ BackupMetadata::BackupInfo BackupMetadata::backupInfoFromJson(const json& j) con
         info.encryptionMethod = j.value("encryptionMethod", "");
         info.compressionMethod = j.value("compressionMethod", "");
         info.compressionLevel = j.value("compressionLevel", 6);
+        info.blockSize = j.value("blockSize", 0u);
+        
+        if (j.contains("merkle")) {
+            const json& merkle = j["merkle"];
+            info.merkleRoot = Digest::fromHex(merkle.value("root", ""));
+            info.merkleSignature = Digest::fromHex(merkle.value("hmac", ""), Digest::Algorithm::HMAC_SHA256);
+            json directories = merkle.value("directories", json::object());
+            for (const auto& item : directories.items()) {
+                info.directoryDigests[item.key()] = Digest::fromHex(item.value().get<std::string>());
+            }
+        }
+        
+        if (j.contains("parity")) {
+            info.parityDataShards = j["parity"].value("dataShards", 0u);
+            info.parityShards = j["parity"].value("parityShards", 0u);
+        }
         
         for (const auto& fileJson : j["files"]) {
             info.files.push_back(fileEntryFromJson(fileJson));
@@ -492,31 +640,68 @@ BackupMetadata::BackupInfo BackupMetadata::backupInfoFromJson(const json& j) con
     return info;
 }
 
-json BackupMetadata::fileEntryToJson(const FileEntry& entry) const {
+json BackupMetadata::fileEntryToJson(const FileEntry& entry) {
     json j;
     j["relativePath"] = entry.relativePath;
-    j["checksum"] = entry.checksum;
+    j["checksum"] = entry.checksum.toHex();
     j["size"] = entry.size;
     j["lastModified"] = Utils::formatTimestamp(entry.lastModified);
     j["compressed"] = entry.compressed;
     j["encrypted"] = entry.encrypted;
     j["compressedSize"] = entry.compressedSize;
     
+    if (!entry.storedChecksum.empty()) {
+        j["storedChecksum"] = entry.storedChecksum.toHex();
+        
+        // Block CRCs are packed big-endian into a single hex string to keep the JSON compact
+        std::vector<uint8_t> packed;
+        packed.reserve(entry.blockChecksums.size() * 4);
+        for (uint32_t crc : entry.blockChecksums) {
+            packed.push_back(static_cast<uint8_t>(crc >> 24));
+            packed.push_back(static_cast<uint8_t>(crc >> 16));
+            packed.push_back(static_cast<uint8_t>(crc >> 8));
+            packed.push_back(static_cast<uint8_t>(crc));
+        }
+        j["blockCrc32c"] = Utils::hexEncode(packed);
+    }
+    
+    if (!entry.segments.empty()) {
+        j["segmentSize"] = entry.segmentSize;
+        j["segments"] = entry.segments;
+    }
+    
     return j;
 }
 
-BackupMetadata::FileEntry BackupMetadata::fileEntryFromJson(const json& j) const {
+BackupMetadata::FileEntry BackupMetadata::fileEntryFromJson(const json& j) {
     FileEntry entry;
     
     try {
         entry.relativePath = j["relativePath"];
-        entry.checksum = j["checksum"];
+        entry.checksum = Digest::fromHex(j["checksum"].get<std::string>());
         entry.size = j["size"];
         entry.lastModified = Utils::parseTimestamp(j["lastModified"]);
         entry.compressed = j["compressed"];
         entry.encrypted = j["encrypted"];
         entry.compressedSize = j["compressedSize"];
         
+        if (j.contains("storedChecksum")) {
+            entry.storedChecksum = Digest::fromHex(j["storedChecksum"].get<std::string>());
+            
+            std::vector<uint8_t> packed = Utils::hexDecode(j.value("blockCrc32c", ""));
+            for (size_t i = 0; i + 4 <= packed.size(); i += 4) {
+                entry.blockChecksums.push_back((static_cast<uint32_t>(packed[i]) << 24) |
+                                               (static_cast<uint32_t>(packed[i + 1]) << 16) |
+                                               (static_cast<uint32_t>(packed[i + 2]) << 8) |
+                                               static_cast<uint32_t>(packed[i + 3]));
+            }
+        }
+        
+        if (j.contains("segments")) {
+            entry.segmentSize = j.value("segmentSize", static_cast<std::uint64_t>(0));
+            entry.segments = j["segments"].get<std::vector<std::uint64_t>>();
+        }
+        
     } catch (const std::exception& e) {
         std::cerr << "Error parsing file entry from JSON: " << e.what() << std::endl;
     }
@@ -0,0 +1,791 @@
+#include "BackupVerifier.h"
+#include "Compressor.h"
+#include "Encryptor.h"
+#include "BufferPool.h"
+#include "ErasureCoder.h"
+#include "ThreadPool.h"
+#include "Utils.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <unordered_set>
+#include <fcntl.h>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+bool BackupVerifier::Report::success() const {
+    return error.empty() && filesCorrupt == 0 && filesMissing == 0 &&
+           merkleStatus != "mismatch" && merkleStatus != "bad-signature";
+}
+
+BackupVerifier::BackupVerifier(const Options& options)
+    : options_(options)
+    , encryptor_(std::make_unique<Encryptor>()) {
+    if (!options_.encryptionKey.empty()) {
+        encryptor_->setKey(options_.encryptionKey);
+    }
+}
+
+BackupVerifier::~BackupVerifier() = default;
+
+BackupVerifier::Report BackupVerifier::verify(const std::string& backupPath) {
+    Report report;
+    report.backupPath = backupPath;
+    report.mode = modeToString(options_.mode);
+    
+    auto startTime = std::chrono::steady_clock::now();
+    updateProgress("Starting verification", 0.0f);
+    
+    // Load backup metadata, rebuilding it from parity first if it was damaged
+    std::string metadataFile = Utils::joinPaths(backupPath, "backup_metadata.json");
+    std::string metadataParity = ErasureCoder::parityPath(backupPath, "backup_metadata.json");
+    if (options_.repair && Utils::pathExists(metadataParity)) {
+        report.metadataRepaired = ErasureCoder::repairFile(metadataFile, metadataParity).repaired;
+    }
+    
+    BackupMetadata metadata;
+    if (!Utils::pathExists(metadataFile) || !metadata.loadFromFile(metadataFile)) {
+        report.error = "Backup metadata not found or unreadable: " + metadataFile;
+        return report;
+    }
+    
+    auto backupIds = metadata.listAllBackups();
+    if (backupIds.empty()) {
+        report.error = "Backup metadata contains no backups";
+        return report;
+    }
+    
+    // The newest entry describes the contents of this backup directory
+    BackupMetadata::BackupInfo info = metadata.getBackupInfo(backupIds.back());
+    report.backupId = info.backupId;
+    
+    // Make sure the recorded checksums themselves are intact before trusting them
+    checkMerkleTree(metadata, info, report);
+    
+    std::vector<BackupMetadata::FileEntry> entries;
+    std::vector<size_t> sampleStrata;
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    
+    if (options_.mode == Mode::SAMPLE) {
+        entries = planSample(info.files, report.sampling, sampleStrata);
+        if (options_.timeBudget.count() > 0) {
+            deadline = startTime + options_.timeBudget;
+        }
+    } else {
+        // Largest files first so one huge file doesn't finish last on a single worker
+        entries = info.files;
+        std::sort(entries.begin(), entries.end(),
+                 [](const BackupMetadata::FileEntry& a, const BackupMetadata::FileEntry& b) {
+                     return a.compressedSize > b.compressedSize;
+                 });
+    }
+    
+    updateProgress("Verifying files", 5.0f);
+    
+    std::mutex reportMutex;
+    std::atomic<size_t> nextEntry(0);
+    std::atomic<size_t> completed(0);
+    
+    {
+        ThreadPool pool(options_.threads);
+        for (size_t worker = 0; worker < pool.getThreadCount(); ++worker) {
+            pool.submit([&]() {
+                size_t index;
+                while ((index = nextEntry.fetch_add(1)) < entries.size()) {
+                    if (std::chrono::steady_clock::now() >= deadline) {
+                        std::lock_guard<std::mutex> lock(reportMutex);
+                        report.sampling.timeBudgetExhausted = true;
+                        break;
+                    }
+                    
+                    FileResult result = verifyEntry(backupPath, entries[index], info.blockSize);
+                    {
+                        std::lock_guard<std::mutex> lock(reportMutex);
+                        if (options_.mode == Mode::SAMPLE && result.status != FileStatus::SKIPPED) {
+                            report.sampling.samplesVerified++;
+                            auto& stratum = report.sampling.strata[sampleStrata[index]];
+                            stratum.verified++;
+                            if (result.status == FileStatus::OK) {
+                                stratum.clean++;
+                            }
+                        }
+                        recordResult(report, std::move(result));
+                    }
+                    
+                    // Only report when the whole percentage changes
+                    size_t done = completed.fetch_add(1) + 1;
+                    if (done * 100 / entries.size() != (done - 1) * 100 / entries.size()) {
+                        updateProgress("Verifying files", 5.0f + (done * 90.0f / entries.size()));
+                    }
+                }
+            });
+        }
+        pool.waitIdle();
+    }
+    
+    updateProgress("Checking for extra blobs", 95.0f);
+    
+    for (const auto& extra : findExtraBlobs(backupPath, info.files)) {
+        FileResult result;
+        result.relativePath = extra;
+        result.status = FileStatus::EXTRA;
+        result.detail = "Blob not referenced by metadata";
+        recordResult(report, std::move(result));
+    }
+    
+    if (options_.mode == Mode::SAMPLE) {
+        finishSampling(report);
+    }
+    
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    report.elapsedSeconds = std::chrono::duration<double>(elapsed).count();
+    if (report.elapsedSeconds > 0.0) {
+        report.throughputMBps = (report.bytesRead / (1024.0 * 1024.0)) / report.elapsedSeconds;
+    }
+    
+    // The default report stays out of the content tree, where a backed-up file may share its name
+    std::string reportPath = options_.reportPath;
+    if (reportPath.empty()) {
+        std::string controlDirectory = Utils::joinPaths(backupPath, CONTROL_DIRECTORY);
+        Utils::createDirectoryRecursive(controlDirectory);
+        reportPath = Utils::joinPaths(controlDirectory, REPORT_FILE);
+    }
+    writeReport(report, reportPath);
+    
+    updateProgress("Verification completed", 100.0f);
+    return report;
+}
+
+BackupVerifier::FileResult BackupVerifier::verifyEntry(const std::string& backupPath,
+                                                       const BackupMetadata::FileEntry& entry,
+                                                       std::uint32_t blockSize) const {
+    FileResult result = checkEntry(backupPath, entry, blockSize);
+    if (options_.repair && (result.status == FileStatus::CORRUPT || result.status == FileStatus::MISSING)) {
+        repairEntry(backupPath, entry, blockSize, result);
+    }
+    return result;
+}
+
+BackupVerifier::FileResult BackupVerifier::checkEntry(const std::string& backupPath,
+                                                      const BackupMetadata::FileEntry& entry,
+                                                      std::uint32_t blockSize) const {
+    std::string blobPath = Utils::joinPaths(backupPath, entry.relativePath);
+    if (!Utils::isRegularFile(blobPath)) {
+        FileResult result;
+        result.relativePath = entry.relativePath;
+        result.status = FileStatus::MISSING;
+        result.detail = "Blob not found";
+        return result;
+    }
+    
+    if (options_.mode == Mode::AT_REST) {
+        return checkStoredBlob(blobPath, entry, blockSize);
+    }
+    return verifyContent(blobPath, entry); // FULL and SAMPLE
+}
+
+void BackupVerifier::repairEntry(const std::string& backupPath, const BackupMetadata::FileEntry& entry,
+                                 std::uint32_t blockSize, FileResult& result) const {
+    std::string parityPath = ErasureCoder::parityPath(backupPath, entry.relativePath);
+    if (!Utils::isRegularFile(parityPath)) {
+        return;
+    }
+    
+    ErasureCoder::RepairResult repair =
+        ErasureCoder::repairFile(Utils::joinPaths(backupPath, entry.relativePath), parityPath);
+    if (!repair.repaired) {
+        result.detail += repair.error.empty() ? " (parity could not repair " +
+                         std::to_string(repair.stripesUnrecoverable) + " stripe(s))" :
+                         " (parity repair failed: " + repair.error + ")";
+        return;
+    }
+    
+    // Only trust the repair once the blob passes the same check again
+    FileResult recheck = checkEntry(backupPath, entry, blockSize);
+    if (recheck.status == FileStatus::OK) {
+        recheck.status = FileStatus::REPAIRED;
+        recheck.detail = "Repaired " + std::to_string(repair.shardsRepaired) + " shard(s) from parity";
+    }
+    recheck.bytesRead += result.bytesRead;
+    result = std::move(recheck);
+}
+
+BackupVerifier::FileResult BackupVerifier::verifyContent(const std::string& blobPath,
+                                                         const BackupMetadata::FileEntry& entry) const {
+    FileResult result;
+    result.relativePath = entry.relativePath;
+    result.status = FileStatus::OK;
+    
+    if (entry.encrypted && !encryptor_->hasKey()) {
+        result.status = FileStatus::SKIPPED;
+        result.detail = "Encryption key required";
+        return result;
+    }
+    
+    FILE* blob = fopen(blobPath.c_str(), "rb");
+    if (!blob) {
+        result.status = FileStatus::CORRUPT;
+        result.detail = "Cannot open blob: " + Utils::getLastErrorMessage();
+        return result;
+    }
+    
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fileno(blob), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    
+    // Stream the blob through decrypt -> decompress -> hash without staging to disk
+    DigestBuilder hasher;
+    Compressor::DataSink hashSink = [&](const uint8_t* data, size_t length) {
+        hasher.update(data, length);
+        result.bytesDecoded += length;
+        return true;
+    };
+    
+    // A split file is a run of independently encoded segments; any other blob is one segment
+    std::vector<std::uint64_t> segments = entry.segments;
+    if (segments.empty()) {
+        segments.push_back(std::numeric_limits<std::uint64_t>::max());
+    }
+    
+    BufferPool::Lease buffer = BufferPool::instance().lease(256 * 1024);
+    bool decoded = true;
+    for (std::uint64_t segment : segments) {
+        std::unique_ptr<Compressor::StreamInflater> inflater;
+        std::unique_ptr<Encryptor::StreamDecryptor> decryptor;
+        Compressor::DataSink sink = hashSink;
+        if (entry.compressed) {
+            inflater = std::make_unique<Compressor::StreamInflater>(hashSink);
+            sink = [&inflater](const uint8_t* data, size_t length) {
+                return inflater->write(data, length);
+            };
+        }
+        if (entry.encrypted) {
+            decryptor = std::make_unique<Encryptor::StreamDecryptor>(*encryptor_, sink);
+            sink = [&decryptor](const uint8_t* data, size_t length) {
+                return decryptor->write(data, length);
+            };
+        }
+        
+        std::uint64_t remaining = segment;
+        size_t bytesRead;
+        while (decoded && remaining > 0 &&
+               (bytesRead = fread(buffer.data(), 1, static_cast<size_t>(std::min<std::uint64_t>(buffer.size(), remaining)), blob)) > 0) {
+            remaining -= bytesRead;
+            decoded = sink(buffer.data(), bytesRead);
+        }
+        decoded = decoded && !ferror(blob) && (entry.segments.empty() || remaining == 0);
+        decoded = decoded && (!decryptor || decryptor->finish()) && (!inflater || inflater->finish());
+        if (!decoded) {
+            break;
+        }
+    }
+    if (decoded && !entry.segments.empty()) {
+        decoded = fgetc(blob) == EOF;       // Bytes past the last segment mean the index is wrong
+    }
+    
+    result.bytesRead = Utils::getFileSize(blobPath);
+    fclose(blob);
+    
+    if (!decoded) {
+        result.status = FileStatus::CORRUPT;
+        result.detail = "Blob could not be decoded";
+    } else if (result.bytesDecoded != entry.size) {
+        result.status = FileStatus::CORRUPT;
+        result.detail = "Size mismatch: expected " + std::to_string(entry.size) +
+                        " bytes, got " + std::to_string(result.bytesDecoded);
+    } else if (hasher.finish() != entry.checksum) {
+        result.status = FileStatus::CORRUPT;
+        result.detail = "Checksum mismatch";
+    }
+    
+    return result;
+}
+
+BackupVerifier::FileResult BackupVerifier::checkStoredBlob(const std::string& blobPath,
+                                                           const BackupMetadata::FileEntry& entry,
+                                                           std::uint32_t blockSize, const BlockGate& gate) {
+    FileResult result;
+    result.relativePath = entry.relativePath;
+    result.status = FileStatus::OK;
+    
+    if (entry.storedChecksum.empty() || blockSize == 0) {
+        result.status = FileStatus::SKIPPED;
+        result.detail = "No stored digest recorded for this blob";
+        return result;
+    }
+    
+    FILE* blob = fopen(blobPath.c_str(), "rb");
+    if (!blob) {
+        result.status = FileStatus::CORRUPT;
+        result.detail = "Cannot open blob: " + Utils::getLastErrorMessage();
+        return result;
+    }
+    
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fileno(blob), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    
+    // No key needed: the raw bytes are checked block by block, then as a whole
+    DigestBuilder hasher;
+    BufferPool::Lease buffer = BufferPool::instance().lease(blockSize);
+    size_t blockIndex = 0;
+    size_t bytesRead;
+    while (!feof(blob)) {
+        if (gate && !gate(blockSize)) {
+            fclose(blob);
+            result.status = FileStatus::SKIPPED;
+            result.detail = "Interrupted";
+            return result;
+        }
+        if ((bytesRead = fread(buffer.data(), 1, blockSize, blob)) == 0) {
+            break;
+        }
+        hasher.update(buffer.data(), bytesRead);
+        
+        if (result.status == FileStatus::OK &&
+            (blockIndex >= entry.blockChecksums.size() ||
+             Utils::crc32c(buffer.data(), bytesRead) != entry.blockChecksums[blockIndex])) {
+            result.status = FileStatus::CORRUPT;
+            result.detail = "CRC32C mismatch in block " + std::to_string(blockIndex) +
+                            " (offset " + std::to_string(static_cast<std::uintmax_t>(blockIndex) * blockSize) + ")";
+        }
+        
+        result.bytesRead += bytesRead;
+        blockIndex++;
+    }
+    
+    bool readError = ferror(blob) != 0;
+    fclose(blob);
+    
+    if (readError) {
+        result.status = FileStatus::CORRUPT;
+        result.detail = "Read error";
+    } else if (result.status == FileStatus::OK && result.bytesRead != entry.compressedSize) {
+        result.status = FileStatus::CORRUPT;
+        result.detail = "Size mismatch: expected " + std::to_string(entry.compressedSize) +
+                        " stored bytes, got " + std::to_string(result.bytesRead);
+    } else if (result.status == FileStatus::OK && hasher.finish() != entry.storedChecksum) {
+        result.status = FileStatus::CORRUPT;
+        result.detail = "Stored digest mismatch";
+    }
+    
+    if (result.status == FileStatus::OK) {
+        result.bytesDecoded = entry.size;
+    }
+    
+    return result;
+}
+
+std::vector<BackupMetadata::FileEntry> BackupVerifier::planSample(
+    const std::vector<BackupMetadata::FileEntry>& entries,
+    SamplingSummary& sampling,
+    std::vector<size_t>& sampleStrata) const {
+    
+    sampling.requestedConfidence = std::min(std::max(options_.confidence, 0.0), 0.999999);
+    sampling.maxCorruption = std::min(std::max(options_.maxCorruption, 1e-9), 1.0);
+    
+    // Clean size-weighted draws needed so that corruption covering more than
+    // maxCorruption of the bytes is missed with probability below 1 - confidence
+    size_t required = 1;
+    if (sampling.maxCorruption < 1.0) {
+        required = static_cast<size_t>(std::ceil(std::log(1.0 - sampling.requestedConfidence) /
+                                                 std::log(1.0 - sampling.maxCorruption)));
+        required = std::max<size_t>(required, 1);
+    }
+    
+    // Stratify by size so both tiny and huge files are always represented
+    const std::uintmax_t bounds[] = {64ULL << 10, 1ULL << 20, 16ULL << 20, 256ULL << 20};
+    const char* labels[] = {"<64KiB", "64KiB-1MiB", "1MiB-16MiB", "16MiB-256MiB", ">=256MiB"};
+    const size_t strataCount = 5;
+    
+    std::vector<std::vector<size_t>> strata(strataCount);
+    std::vector<double> strataWeight(strataCount, 0.0);
+    double totalWeight = 0.0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        size_t stratum = 0;
+        while (stratum < strataCount - 1 && entries[i].size >= bounds[stratum]) {
+            stratum++;
+        }
+        double weight = static_cast<double>(std::max<std::uintmax_t>(entries[i].size, 1));
+        strata[stratum].push_back(i);
+        strataWeight[stratum] += weight;
+        totalWeight += weight;
+    }
+    
+    std::mt19937_64 rng(options_.seed != 0 ? options_.seed : std::random_device{}());
+    std::uniform_real_distribution<double> uniform(std::numeric_limits<double>::min(), 1.0);
+    
+    sampling.exhaustive = required >= entries.size();
+    
+    // Each selected entry gets a fractional position so strata interleave in proportion
+    std::vector<std::pair<double, std::pair<size_t, size_t>>> ordered; // position, (stratum, entry)
+    for (size_t stratum = 0; stratum < strataCount; ++stratum) {
+        StratumSummary summary;
+        summary.label = labels[stratum];
+        summary.files = strata[stratum].size();
+        summary.byteShare = totalWeight > 0.0 ? strataWeight[stratum] / totalWeight : 0.0;
+        
+        if (!strata[stratum].empty()) {
+            size_t allocation = strata[stratum].size();
+            if (!sampling.exhaustive) {
+                double share = required * strataWeight[stratum] / totalWeight;
+                allocation = std::min(strata[stratum].size(),
+                                      std::max<size_t>(1, static_cast<size_t>(std::ceil(share))));
+            }
+            
+            // Weighted sampling without replacement (Efraimidis-Spirakis): key = log(u) / weight
+            std::vector<std::pair<double, size_t>> keyed;
+            keyed.reserve(strata[stratum].size());
+            for (size_t index : strata[stratum]) {
+                double weight = static_cast<double>(std::max<std::uintmax_t>(entries[index].size, 1));
+                keyed.emplace_back(std::log(uniform(rng)) / weight, index);
+            }
+            std::partial_sort(keyed.begin(), keyed.begin() + allocation, keyed.end(),
+                              [](const auto& a, const auto& b) { return a.first > b.first; });
+            
+            for (size_t j = 0; j < allocation; ++j) {
+                ordered.push_back({(j + 0.5) / allocation, {stratum, keyed[j].second}});
+            }
+            summary.sampled = allocation;
+        }
+        
+        sampling.strata.push_back(summary);
+    }
+    
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    std::vector<BackupMetadata::FileEntry> sample;
+    sample.reserve(ordered.size());
+    sampleStrata.clear();
+    for (const auto& item : ordered) {
+        sampleStrata.push_back(item.second.first);
+        sample.push_back(entries[item.second.second]);
+    }
+    
+    sampling.samplesPlanned = sample.size();
+    sampling.exhaustive = sampling.exhaustive || sample.size() == entries.size();
+    return sample;
+}
+
+void BackupVerifier::finishSampling(Report& report) {
+    SamplingSummary& sampling = report.sampling;
+    const double p = sampling.maxCorruption;
+    const double c = sampling.requestedConfidence;
+    
+    // Corruption can only hide in strata with files left unchecked
+    double hideable = 0.0;
+    for (const auto& stratum : sampling.strata) {
+        if (stratum.clean < stratum.files) {
+            hideable += stratum.byteShare;
+        }
+    }
+    
+    sampling.achievedConfidence = p > hideable ? 1.0 : 1.0 - missProbability(sampling.strata, p);
+    
+    // Smallest corrupted fraction that would have been caught with the requested confidence;
+    // the miss probability only falls as the corruption grows
+    double low = 0.0;
+    double high = hideable;
+    for (int step = 0; step < 60 && high - low > 1e-9; ++step) {
+        double middle = (low + high) / 2.0;
+        (missProbability(sampling.strata, middle) <= 1.0 - c ? high : low) = middle;
+    }
+    sampling.corruptionBound = high;
+}
+
+double BackupVerifier::missProbability(const std::vector<StratumSummary>& strata, double corruption) {
+    // Corruption of a byte fraction p_i placed in stratum i (byte share s_i) survives n_i
+    // clean size-weighted draws there with probability (1 - p_i / s_i)^n_i. The miss
+    // probability is the largest product over all ways of splitting the corruption across
+    // strata: spreading it thin can be worse than hiding it in one place.
+    double remaining = corruption;
+    std::vector<const StratumSummary*> sampled;
+    for (const auto& stratum : strata) {
+        if (stratum.clean >= stratum.files || stratum.byteShare <= 0.0) {
+            continue;       // Fully checked and clean, or empty
+        }
+        if (stratum.clean == 0) {
+            remaining -= stratum.byteShare;     // Unsampled strata hide their whole share for free
+        } else {
+            sampled.push_back(&stratum);
+        }
+    }
+    if (remaining <= 0.0) {
+        return 1.0;
+    }
+    
+    // The log of the product is concave, so the best split equalises the marginal
+    // n_i / (s_i - p_i) = 1 / mu: p_i = max(0, s_i - n_i * mu). Find mu by bisection.
+    auto placed = [&](double mu) {
+        double total = 0.0;
+        for (const StratumSummary* stratum : sampled) {
+            total += std::max(0.0, stratum->byteShare - static_cast<double>(stratum->clean) * mu);
+        }
+        return total;
+    };
+    double low = 0.0;
+    double high = 0.0;
+    for (const StratumSummary* stratum : sampled) {
+        high = std::max(high, stratum->byteShare / static_cast<double>(stratum->clean));
+    }
+    if (placed(low) <= remaining) {
+        return 0.0;         // Even corrupting every sampled byte would have been seen
+    }
+    for (int step = 0; step < 100; ++step) {
+        double mu = (low + high) / 2.0;
+        (placed(mu) > remaining ? low : high) = mu;
+    }
+    
+    double logMiss = 0.0;
+    for (const StratumSummary* stratum : sampled) {
+        double share = std::max(0.0, stratum->byteShare - static_cast<double>(stratum->clean) * high);
+        logMiss += static_cast<double>(stratum->clean) * std::log1p(-share / stratum->byteShare);
+    }
+    return std::exp(logMiss);
+}
+
+std::vector<std::string> BackupVerifier::findExtraBlobs(const std::string& backupPath,
+                                                        const std::vector<BackupMetadata::FileEntry>& entries) const {
+    std::unordered_set<std::string> known;
+    known.reserve(entries.size());
+    for (const auto& entry : entries) {
+        known.insert(fs::path(entry.relativePath).lexically_normal().string());
+    }
+    
+    std::vector<std::string> extras;
+    try {
+        for (const auto& dirEntry : fs::recursive_directory_iterator(backupPath)) {
+            if (!dirEntry.is_regular_file()) {
+                continue;
+            }
+            
+            std::string relativePath = fs::relative(dirEntry.path(), backupPath).lexically_normal().string();
+            // Older versions wrote the default report at the top level
+            if (!isControlPath(relativePath) && relativePath != REPORT_FILE &&
+                known.find(relativePath) == known.end()) {
+                extras.push_back(relativePath);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error scanning backup for extra blobs: " << e.what() << std::endl;
+    }
+    
+    std::sort(extras.begin(), extras.end());
+    return extras;
+}
+
+void BackupVerifier::recordResult(Report& report, FileResult result) const {
+    report.bytesRead += result.bytesRead;
+    
+    switch (result.status) {
+        case FileStatus::OK:
+            report.filesChecked++;
+            report.filesOk++;
+            report.bytesVerified += result.bytesDecoded;
+            return; // Successful results are only counted
+        case FileStatus::CORRUPT:
+            report.filesChecked++;
+            report.filesCorrupt++;
+            break;
+        case FileStatus::MISSING:
+            report.filesChecked++;
+            report.filesMissing++;
+            break;
+        case FileStatus::SKIPPED:
+            report.filesSkipped++;
+            break;
+        case FileStatus::EXTRA:
+            report.extraBlobs++;
+            break;
+        case FileStatus::REPAIRED:
+            report.filesChecked++;
+            report.filesRepaired++;
+            report.bytesVerified += result.bytesDecoded;
+            break;
+    }
+    
+    report.problems.push_back(std::move(result));
+}
+
+void BackupVerifier::checkMerkleTree(const BackupMetadata& metadata, const BackupMetadata::BackupInfo& info,
+                                     Report& report) const {
+    if (info.merkleRoot.empty()) {
+        report.merkleStatus = "absent";
+        return;
+    }
+    
+    if (metadata.calculateBackupChecksum(info.backupId) != info.merkleRoot) {
+        report.merkleStatus = "mismatch";
+        report.damagedDirectories = metadata.findDamagedDirectories(info.backupId);
+        return;
+    }
+    
+    if (info.merkleSignature.empty()) {
+        report.merkleStatus = "ok";
+    } else if (!encryptor_->hasKey()) {
+        report.merkleStatus = "unsigned";
+    } else {
+        report.merkleStatus = metadata.verifyBackupSignature(info.backupId, *encryptor_) ? "signed" : "bad-signature";
+    }
+}
+
+bool BackupVerifier::writeReport(const Report& report, const std::string& reportPath) const {
+    try {
+        json j;
+        j["version"] = "1.0";
+        j["timestamp"] = Utils::formatTimestamp(std::chrono::system_clock::now());
+        j["backupPath"] = report.backupPath;
+        j["backupId"] = report.backupId;
+        j["mode"] = report.mode;
+        j["success"] = report.success();
+        j["error"] = report.error;
+        
+        json summary;
+        summary["filesChecked"] = report.filesChecked;
+        summary["filesOk"] = report.filesOk;
+        summary["filesCorrupt"] = report.filesCorrupt;
+        summary["filesMissing"] = report.filesMissing;
+        summary["filesSkipped"] = report.filesSkipped;
+        summary["filesRepaired"] = report.filesRepaired;
+        summary["metadataRepaired"] = report.metadataRepaired;
+        summary["extraBlobs"] = report.extraBlobs;
+        summary["bytesRead"] = report.bytesRead;
+        summary["bytesVerified"] = report.bytesVerified;
+        summary["elapsedSeconds"] = report.elapsedSeconds;
+        summary["throughputMBps"] = report.throughputMBps;
+        j["summary"] = summary;
+        
+        json merkle;
+        merkle["status"] = report.merkleStatus;
+        merkle["damagedDirectories"] = report.damagedDirectories;
+        j["merkle"] = merkle;
+        
+        if (report.mode == modeToString(Mode::SAMPLE)) {
+            const SamplingSummary& sampling = report.sampling;
+            json samplingJson;
+            samplingJson["samplesPlanned"] = sampling.samplesPlanned;
+            samplingJson["samplesVerified"] = sampling.samplesVerified;
+            samplingJson["requestedConfidence"] = sampling.requestedConfidence;
+            samplingJson["maxCorruption"] = sampling.maxCorruption;
+            samplingJson["achievedConfidence"] = sampling.achievedConfidence;
+            samplingJson["corruptionBound"] = sampling.corruptionBound;
+            samplingJson["exhaustive"] = sampling.exhaustive;
+            samplingJson["timeBudgetExhausted"] = sampling.timeBudgetExhausted;
+            samplingJson["strata"] = json::array();
+            for (const auto& stratum : sampling.strata) {
+                samplingJson["strata"].push_back({
+                    {"label", stratum.label},
+                    {"files", stratum.files},
+                    {"byteShare", stratum.byteShare},
+                    {"sampled", stratum.sampled},
+                    {"verified", stratum.verified},
+                    {"clean", stratum.clean}
+                });
+            }
+            j["sampling"] = samplingJson;
+        }
+        
+        j["problems"] = json::array();
+        for (const auto& problem : report.problems) {
+            json problemJson;
+            problemJson["path"] = problem.relativePath;
+            problemJson["status"] = statusToString(problem.status);
+            problemJson["detail"] = problem.detail;
+            j["problems"].push_back(problemJson);
+        }
+        
+        std::ofstream file(reportPath);
+        if (!file.is_open()) {
+            std::cerr << "Error: Cannot write verification report: " << reportPath << std::endl;
+            return false;
+        }
+        
+        file << j.dump(2);
+        return true;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error writing verification report: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void BackupVerifier::setProgressCallback(std::function<void(const std::string&, float)> callback) {
+    progressCallback_ = callback;
+}
+
+std::string BackupVerifier::modeToString(Mode mode) {
+    switch (mode) {
+        case Mode::FULL:
+            return "full";
+        case Mode::AT_REST:
+            return "at-rest";
+        case Mode::SAMPLE:
+            return "sample";
+    }
+    return "unknown";
+}
+
+bool BackupVerifier::parseMode(const std::string& name, Mode& mode) {
+    if (name == "full") {
+        mode = Mode::FULL;
+    } else if (name == "at-rest") {
+        mode = Mode::AT_REST;
+    } else if (name == "sample") {
+        mode = Mode::SAMPLE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool BackupVerifier::isControlFile(const std::string& fileName) {
+    return fileName == "backup_metadata.json" ||
+           fileName == "file_state.db";
+}
+
+bool BackupVerifier::isControlPath(const std::string& relativePath) {
+    // Only the top level holds control files; deeper files with those names are content
+    fs::path path = fs::path(relativePath).lexically_normal();
+    if (path.empty()) {
+        return false;
+    }
+    std::string first = path.begin()->string();
+    if (std::next(path.begin()) == path.end()) {
+        return isControlFile(first);
+    }
+    return first == ErasureCoder::PARITY_DIRECTORY || first == CONTROL_DIRECTORY;
+}
+
+std::string BackupVerifier::statusToString(FileStatus status) {
+    switch (status) {
+        case FileStatus::OK:
+            return "ok";
+        case FileStatus::CORRUPT:
+            return "corrupt";
+        case FileStatus::MISSING:
+            return "missing";
+        case FileStatus::EXTRA:
+            return "extra";
+        case FileStatus::SKIPPED:
+            return "skipped";
+        case FileStatus::REPAIRED:
+            return "repaired";
+    }
+    return "unknown";
+}
+
+void BackupVerifier::updateProgress(const std::string& operation, float percentage) {
+    if (progressCallback_) {
+        std::lock_guard<std::mutex> lock(progressMutex_);
+        progressCallback_(operation, percentage);
+    }
+}
@@ -0,0 +1,118 @@
+#include "BlockCache.h"
+#include "MemoryBudget.h"
+#include <algorithm>
+
+BlockCache::BlockCache(std::uint64_t capacity, size_t shards)
+    : capacity_(capacity)
+    , hits_(0)
+    , misses_(0)
+    , insertions_(0)
+    , evictions_(0) {
+    shards_.resize(std::max<size_t>(1, shards));
+    for (auto& shard : shards_) {
+        shard = std::make_unique<Shard>();
+    }
+}
+
+BlockCache::~BlockCache() {
+    clear();
+}
+
+BlockCache::Block BlockCache::get(const Digest& key) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses_++;
+        return nullptr;
+    }
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    hits_++;
+    return it->second->second;
+}
+
+void BlockCache::put(const Digest& key, Block block) {
+    std::uint64_t capacity = shardCapacity();
+    if (!block || block->size() > capacity) {
+        return;
+    }
+
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        // Same digest, same content: just refresh its position
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    evict(shard, capacity - block->size());
+    if (!MemoryBudget::instance().tryCharge(block->size())) {
+        return;
+    }
+    shard.bytes += block->size();
+    shard.entries.emplace_front(key, std::move(block));
+    shard.index[key] = shard.entries.begin();
+    insertions_++;
+}
+
+bool BlockCache::admits(std::uint64_t size) const {
+    return size <= shardCapacity();
+}
+
+void BlockCache::setCapacity(std::uint64_t capacity) {
+    capacity_ = capacity;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        evict(*shard, shardCapacity());
+    }
+}
+
+std::uint64_t BlockCache::getCapacity() const {
+    return capacity_;
+}
+
+void BlockCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        MemoryBudget::instance().uncharge(shard->bytes);
+        shard->entries.clear();
+        shard->index.clear();
+        shard->bytes = 0;
+    }
+}
+
+BlockCache::Stats BlockCache::getStats() const {
+    Stats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.insertions = insertions_;
+    stats.evictions = evictions_;
+    stats.capacity = capacity_;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->index.size();
+        stats.bytes += shard->bytes;
+    }
+    return stats;
+}
+
+BlockCache::Shard& BlockCache::shardFor(const Digest& key) {
+    return *shards_[std::hash<Digest>()(key) % shards_.size()];
+}
+
+std::uint64_t BlockCache::shardCapacity() const {
+    return capacity_ / shards_.size();
+}
+
+void BlockCache::evict(Shard& shard, std::uint64_t limit) {
+    while (shard.bytes > limit && !shard.entries.empty()) {
+        auto& oldest = shard.entries.back();
+        shard.bytes -= oldest.second->size();
+        MemoryBudget::instance().uncharge(oldest.second->size());
+        shard.index.erase(oldest.first);
+        shard.entries.pop_back();
+        evictions_++;
+    }
+}
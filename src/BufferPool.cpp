@@ -0,0 +1,220 @@
+#include "BufferPool.h"
+#include "MemoryBudget.h"
+#include <algorithm>
+#include <new>
+#include <sys/mman.h>
+
+namespace {
+
+constexpr size_t HUGE_PAGE = 2 * 1024 * 1024;
+constexpr size_t LARGE_CLASS = 1024 * 1024;     // Threads cache a single buffer from here up
+
+// Anonymous mapping of bytes starting on an alignment boundary; the padding is unmapped again
+uint8_t* mapAligned(size_t bytes, size_t alignment) {
+    size_t padded = bytes + alignment;
+    void* raw = ::mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (start + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    uintptr_t end = start + padded;
+    if (aligned > start) {
+        ::munmap(raw, aligned - start);
+    }
+    if (end > aligned + bytes) {
+        ::munmap(reinterpret_cast<void*>(aligned + bytes), end - (aligned + bytes));
+    }
+    return reinterpret_cast<uint8_t*>(aligned);
+}
+
+size_t cacheLimit(size_t size) {
+    return size >= LARGE_CLASS ? 1 : BufferPool::THREAD_CACHE;
+}
+
+} // namespace
+
+struct BufferPool::ThreadCache {
+    std::array<std::vector<uint8_t*>, CLASSES> free;
+
+    ThreadCache() {
+        for (auto& list : free) {
+            list.reserve(THREAD_CACHE);
+        }
+    }
+
+    // A finished thread hands its buffers back to the others
+    ~ThreadCache() {
+        BufferPool& pool = BufferPool::instance();
+        std::lock_guard<std::mutex> lock(pool.mutex_);
+        for (size_t index = 0; index < CLASSES; ++index) {
+            pool.free_[index].insert(pool.free_[index].end(), free[index].begin(), free[index].end());
+        }
+    }
+};
+
+BufferPool::Lease::~Lease() {
+    release();
+}
+
+BufferPool::Lease::Lease(Lease&& other) noexcept
+    : data_(other.data_)
+    , size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+BufferPool::Lease& BufferPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void BufferPool::Lease::release() {
+    if (data_) {
+        BufferPool::instance().giveBack(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+BufferPool::BufferPool()
+    : leases_(0)
+    , threadCacheHits_(0)
+    , sharedHits_(0)
+    , slabAllocations_(0)
+    , oversizeAllocations_(0)
+    , reservedBytes_(0)
+    , hugePageBytes_(0)
+    , leasedBytes_(0) {
+}
+
+BufferPool& BufferPool::instance() {
+    // Never destroyed, so buffers and thread caches may outlive static destruction
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+BufferPool::Lease BufferPool::lease(size_t bytes) {
+    leases_++;
+    Lease lease;
+
+    if (bytes > MAX_BUFFER) {
+        size_t size = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        lease.data_ = mapAligned(size, ALIGNMENT);
+        if (!lease.data_) {
+            throw std::bad_alloc();
+        }
+        lease.size_ = size;
+        oversizeAllocations_++;
+        leasedBytes_ += size;
+        MemoryBudget::instance().charge(size);
+        return lease;
+    }
+
+    size_t index = classIndex(bytes);
+    size_t size = MIN_BUFFER << index;
+    std::vector<uint8_t*>& local = threadCache().free[index];
+    if (!local.empty()) {
+        lease.data_ = local.back();
+        local.pop_back();
+        threadCacheHits_++;
+    } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<uint8_t*>& shared = free_[index];
+        if (!shared.empty()) {
+            sharedHits_++;
+        } else if (!refill(index)) {
+            throw std::bad_alloc();
+        }
+        lease.data_ = shared.back();
+        shared.pop_back();
+
+        // Take a few more while holding the lock so the next leases stay local
+        while (local.size() < cacheLimit(size) / 2 && !shared.empty()) {
+            local.push_back(shared.back());
+            shared.pop_back();
+        }
+    }
+
+    lease.size_ = size;
+    leasedBytes_ += size;
+    return lease;
+}
+
+BufferPool::Stats BufferPool::getStats() const {
+    Stats stats;
+    stats.leases = leases_;
+    stats.threadCacheHits = threadCacheHits_;
+    stats.sharedHits = sharedHits_;
+    stats.slabAllocations = slabAllocations_;
+    stats.oversizeAllocations = oversizeAllocations_;
+    stats.reservedBytes = reservedBytes_;
+    stats.hugePageBytes = hugePageBytes_;
+    stats.leasedBytes = leasedBytes_;
+    return stats;
+}
+
+size_t BufferPool::classSize(size_t bytes) {
+    return bytes > MAX_BUFFER ? (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1) : MIN_BUFFER << classIndex(bytes);
+}
+
+void BufferPool::giveBack(uint8_t* data, size_t size) {
+    leasedBytes_ -= size;
+    if (size > MAX_BUFFER) {
+        ::munmap(data, size);
+        MemoryBudget::instance().uncharge(size);
+        return;
+    }
+
+    size_t index = classIndex(size);
+    std::vector<uint8_t*>& local = threadCache().free[index];
+    if (local.size() < cacheLimit(size)) {
+        local.push_back(data);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_[index].push_back(data);
+}
+
+bool BufferPool::refill(size_t sizeClass) {
+    size_t size = MIN_BUFFER << sizeClass;
+    size_t slab = std::max(SLAB_BYTES, size);
+    uint8_t* base = mapAligned(slab, HUGE_PAGE);
+    if (!base) {
+        return false;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (::madvise(base, slab, MADV_HUGEPAGE) == 0) {
+        hugePageBytes_ += slab;
+    }
+#endif
+
+    for (size_t offset = 0; offset < slab; offset += size) {
+        free_[sizeClass].push_back(base + offset);
+    }
+    slabAllocations_++;
+    reservedBytes_ += slab;
+    MemoryBudget::instance().charge(slab);       // Held for good, like the slab itself
+    return true;
+}
+
+size_t BufferPool::classIndex(size_t bytes) {
+    size_t index = 0;
+    while ((MIN_BUFFER << index) < bytes) {
+        index++;
+    }
+    return index;
+}
+
+BufferPool::ThreadCache& BufferPool::threadCache() {
+    thread_local ThreadCache cache;
+    return cache;
+}
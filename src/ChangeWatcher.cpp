@@ -0,0 +1,303 @@
+#include "ChangeWatcher.h"
+#include "Utils.h"
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE |
+                                IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+constexpr int POLL_INTERVAL_MS = 100;
+
+} // namespace
+
+ChangeWatcher::ChangeWatcher()
+    : ChangeWatcher(Options()) {
+}
+
+ChangeWatcher::ChangeWatcher(const Options& options)
+    : options_(options)
+    , inotifyFd_(-1)
+    , wakeFds_{-1, -1}
+    , running_(false)
+    , overflow_(false) {
+}
+
+ChangeWatcher::~ChangeWatcher() {
+    stop();
+}
+
+bool ChangeWatcher::start(const std::string& rootPath) {
+    if (running_) {
+        return true;
+    }
+
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0) {
+        std::cerr << "Error: inotify unavailable: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (::pipe2(wakeFds_, O_CLOEXEC) < 0) {
+        std::cerr << "Error: Cannot create watcher wakeup pipe: " << std::strerror(errno) << std::endl;
+        ::close(inotifyFd_);
+        inotifyFd_ = -1;
+        return false;
+    }
+
+    rootPath_ = rootPath;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.clear();
+        overflow_ = false;
+        addWatchRecursive(rootPath_, false);
+    }
+
+    running_ = true;
+    watchThread_ = std::thread(&ChangeWatcher::watchLoop, this);
+    return true;
+}
+
+void ChangeWatcher::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    char byte = 0;
+    if (::write(wakeFds_[1], &byte, 1) < 0) {
+        // The loop also notices running_ on its next poll timeout
+    }
+    if (watchThread_.joinable()) {
+        watchThread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        watches_.clear();
+    }
+    batchReady_.notify_all();
+
+    ::close(inotifyFd_);
+    ::close(wakeFds_[0]);
+    ::close(wakeFds_[1]);
+    inotifyFd_ = -1;
+    wakeFds_[0] = wakeFds_[1] = -1;
+}
+
+bool ChangeWatcher::isRunning() const {
+    return running_;
+}
+
+bool ChangeWatcher::nextBatch(Batch& batch) {
+    batch = Batch();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    batchReady_.wait(lock, [this]() {
+        return !running_ || batchDue(std::chrono::steady_clock::now());
+    });
+    if (!running_) {
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (overflow_) {
+        batch.rescan = true;
+        overflow_ = false;
+        pending_.clear();
+        return true;
+    }
+
+    for (auto it = pending_.begin(); it != pending_.end() && batch.changed.size() + batch.deleted.size() < options_.maxBatchFiles;) {
+        if (!isReady(it->second, now)) {
+            ++it;
+            continue;
+        }
+        (it->second.deleted ? batch.deleted : batch.changed).push_back(it->first);
+        it = pending_.erase(it);
+    }
+
+    // Files still being written start the next window
+    windowOpened_ = now;
+
+    std::sort(batch.changed.begin(), batch.changed.end());
+    std::sort(batch.deleted.begin(), batch.deleted.end());
+    return true;
+}
+
+size_t ChangeWatcher::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+size_t ChangeWatcher::getWatchCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return watches_.size();
+}
+
+void ChangeWatcher::watchLoop() {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+
+    while (running_) {
+        pollfd fds[2] = {{inotifyFd_, POLLIN, 0}, {wakeFds_[0], POLLIN, 0}};
+        int ready = ::poll(fds, 2, POLL_INTERVAL_MS);
+        if (ready > 0 && (fds[1].revents & POLLIN)) {
+            continue;
+        }
+
+        bool due = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (ready > 0 && (fds[0].revents & POLLIN)) {
+                ssize_t length;
+                while ((length = ::read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+                    handleEvents(buffer, static_cast<size_t>(length));
+                }
+            }
+            due = batchDue(std::chrono::steady_clock::now());
+        }
+
+        // Quiet periods expire without new events, so this is checked on every tick
+        if (due) {
+            batchReady_.notify_all();
+        }
+    }
+}
+
+void ChangeWatcher::handleEvents(const char* buffer, size_t length) {
+    size_t offset = 0;
+    while (offset + sizeof(struct inotify_event) <= length) {
+        const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+        offset += sizeof(struct inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW) {
+            markOverflow();
+            continue;
+        }
+
+        auto watch = watches_.find(event->wd);
+        if (watch == watches_.end()) {
+            continue;
+        }
+        if (event->mask & IN_IGNORED) {
+            watches_.erase(watch);
+            continue;
+        }
+        if (event->len == 0) {
+            continue;   // Event on the watched directory itself
+        }
+
+        std::string path = Utils::joinPaths(watch->second, event->name);
+        if (event->mask & IN_ISDIR) {
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                // Files may have been created before the watch existed
+                addWatchRecursive(path, true);
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                std::string prefix = path + "/";
+                for (auto it = watches_.begin(); it != watches_.end();) {
+                    if (it->second == path || it->second.compare(0, prefix.size(), prefix) == 0) {
+                        inotify_rm_watch(inotifyFd_, it->first);
+                        it = watches_.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                notePath(path, false, true);
+            }
+        } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+            notePath(path, false, true);
+        } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+            notePath(path, true, false);
+        } else if (event->mask & (IN_CREATE | IN_MODIFY | IN_ATTRIB)) {
+            notePath(path, false, false);
+        }
+    }
+}
+
+void ChangeWatcher::addWatchRecursive(const std::string& directory, bool markFiles) {
+    int wd = inotify_add_watch(inotifyFd_, directory.c_str(), WATCH_MASK);
+    if (wd < 0) {
+        if (errno == ENOSPC) {
+            std::cerr << "Warning: Out of inotify watches (raise fs.inotify.max_user_watches); "
+                      << "falling back to rescans" << std::endl;
+            markOverflow();
+        }
+        return;
+    }
+    watches_[wd] = directory;
+
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(directory, fs::directory_options::skip_permission_denied, error)) {
+        if (entry.is_symlink(error)) {
+            continue;
+        }
+        if (entry.is_directory(error)) {
+            addWatchRecursive(entry.path().string(), markFiles);
+        } else if (markFiles && entry.is_regular_file(error)) {
+            notePath(entry.path().string(), true, false);
+        }
+    }
+}
+
+void ChangeWatcher::notePath(const std::string& path, bool closed, bool deleted) {
+    if (overflow_) {
+        return;     // The rescan will pick this up
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto it = pending_.find(path);
+    if (it == pending_.end()) {
+        if (pending_.size() >= options_.maxPendingPaths) {
+            markOverflow();
+            return;
+        }
+        if (pending_.empty()) {
+            windowOpened_ = now;
+        }
+        it = pending_.emplace(path, Pending()).first;
+        it->second.firstEvent = now;
+    }
+
+    it->second.lastEvent = now;
+    it->second.closed = closed;
+    it->second.deleted = deleted;
+}
+
+void ChangeWatcher::markOverflow() {
+    if (!overflow_ && pending_.empty()) {
+        windowOpened_ = std::chrono::steady_clock::now();
+    }
+    overflow_ = true;
+    pending_.clear();
+}
+
+bool ChangeWatcher::batchDue(std::chrono::steady_clock::time_point now) const {
+    bool windowClosed = now - windowOpened_ >= options_.maxBatchDelay;
+    if (overflow_) {
+        return windowClosed;
+    }
+    if (pending_.empty()) {
+        return false;
+    }
+
+    size_t ready = 0;
+    for (const auto& pair : pending_) {
+        if (isReady(pair.second, now) && ++ready >= options_.maxBatchFiles) {
+            return true;
+        }
+    }
+    return windowClosed && ready > 0;
+}
+
+bool ChangeWatcher::isReady(const Pending& pending, std::chrono::steady_clock::time_point now) const {
+    return pending.deleted || pending.closed ||
+           now - pending.lastEvent >= options_.quietPeriod ||
+           now - pending.firstEvent >= options_.maxHoldTime;
+}
@@ -1,22 +1,110 @@
 #include "Compressor.h"
+#include "IoThrottle.h"
 #include <zlib.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 Compressor::Compressor() 
     : totalBytesCompressed_(0)
-    , totalBytesOriginal_(0) {
+    , totalBytesOriginal_(0)
+    , ioThrottle_(nullptr) {
 }
 
 Compressor::~Compressor() = default;
 
-bool Compressor::compressFile(const std::string& inputFile, const std::string& outputFile, CompressionLevel level) {
+void Compressor::setIoThrottle(IoThrottle* throttle) {
+    ioThrottle_ = throttle;
+}
+
+Compressor::StreamInflater::StreamInflater(DataSink sink)
+    : strm_(std::make_unique<z_stream>())
+    , sink_(std::move(sink))
+    , outBuffer_(BufferPool::instance().lease(64 * 1024))
+    , initialized_(false)
+    , streamEnded_(false) {
+    strm_->zalloc = Z_NULL;
+    strm_->zfree = Z_NULL;
+    strm_->opaque = Z_NULL;
+    strm_->avail_in = 0;
+    strm_->next_in = Z_NULL;
+    
+    initialized_ = inflateInit(strm_.get()) == Z_OK;
+    if (!initialized_) {
+        std::cerr << "Error: Failed to initialize decompression" << std::endl;
+    }
+}
+
+Compressor::StreamInflater::~StreamInflater() {
+    if (initialized_) {
+        inflateEnd(strm_.get());
+    }
+}
+
+bool Compressor::StreamInflater::write(const uint8_t* data, size_t length) {
+    if (!initialized_) {
+        return false;
+    }
+    
+    if (streamEnded_) {
+        // Any bytes after the end of the zlib stream mean the blob is damaged
+        return length == 0;
+    }
+    
+    strm_->avail_in = static_cast<uInt>(length);
+    strm_->next_in = const_cast<uint8_t*>(data);
+    
+    do {
+        strm_->avail_out = static_cast<uInt>(outBuffer_.size());
+        strm_->next_out = outBuffer_.data();
+        
+        int ret = inflate(strm_.get(), Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR || ret == Z_NEED_DICT || 
+            ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
+            return false;
+        }
+        
+        size_t have = outBuffer_.size() - strm_->avail_out;
+        if (have > 0 && !sink_(outBuffer_.data(), have)) {
+            return false;
+        }
+        
+        if (ret == Z_STREAM_END) {
+            streamEnded_ = true;
+            return strm_->avail_in == 0;
+        }
+        
+        if (ret == Z_BUF_ERROR && strm_->avail_in == 0) {
+            break; // Needs more input
+        }
+    } while (strm_->avail_in > 0 || strm_->avail_out == 0);
+    
+    return true;
+}
+
+bool Compressor::StreamInflater::finish() {
+    return initialized_ && streamEnded_;
+}
+
+bool Compressor::compressFile(const std::string& inputFile, const std::string& outputFile, CompressionLevel level,
+                              const DataSink& written) {
+    return compressFile(inputFile, outputFile, level, 0, std::numeric_limits<std::uint64_t>::max(), written);
+}
+
+bool Compressor::compressFile(const std::string& inputFile, const std::string& outputFile, CompressionLevel level,
+                              std::uint64_t offset, std::uint64_t length, const DataSink& written) {
     FILE* source = fopen(inputFile.c_str(), "rb");
     if (!source) {
         std::cerr << "Error: Cannot open input file: " << inputFile << std::endl;
         return false;
     }
+    if (offset > 0 && fseeko(source, static_cast<off_t>(offset), SEEK_SET) != 0) {
+        std::cerr << "Error: Cannot seek in input file: " << inputFile << std::endl;
+        fclose(source);
+        return false;
+    }
     
     FILE* dest = fopen(outputFile.c_str(), "wb");
     if (!dest) {
@@ -25,23 +113,22 @@ bool Compressor::compressFile(const std::string& inputFile, const std::string& o
         return false;
     }
     
-    bool result = compressFileInternal(source, dest, static_cast<int>(level));
-    
-    fclose(source);
-    fclose(dest);
+    bool result = compressFileInternal(source, dest, static_cast<int>(level), length, written);
     
     if (result) {
-        // Update statistics
-        std::ifstream in(inputFile, std::ios::binary | std::ios::ate);
-        std::ifstream out(outputFile, std::ios::binary | std::ios::ate);
-        
-        if (in.is_open() && out.is_open()) {
-            totalBytesOriginal_ += in.tellg();
-            totalBytesCompressed_ += out.tellg();
+        // Update statistics; both positions are where this pass stopped
+        off_t consumed = ftello(source) - static_cast<off_t>(offset);
+        off_t produced = ftello(dest);
+        if (consumed >= 0 && produced >= 0) {
+            totalBytesOriginal_ += static_cast<size_t>(consumed);
+            totalBytesCompressed_ += static_cast<size_t>(produced);
         }
     }
     
-    return result;
+    fclose(source);
+    
+    // A failed close means buffered output never reached the file
+    return fclose(dest) == 0 && result;
 }
 
 bool Compressor::decompressFile(const std::string& inputFile, const std::string& outputFile) {
@@ -146,7 +233,7 @@ double Compressor::getAverageCompressionRatio() const {
     return static_cast<double>(totalBytesCompressed_) / static_cast<double>(totalBytesOriginal_);
 }
 
-bool Compressor::compressFileInternal(FILE* source, FILE* dest, int level) {
+bool Compressor::compressFileInternal(FILE* source, FILE* dest, int level, std::uint64_t limit, const DataSink& written) {
     const size_t CHUNK = 16384;
     z_stream strm;
     uint8_t in[CHUNK];
@@ -164,17 +251,22 @@ bool Compressor::compressFileInternal(FILE* source, FILE* dest, int level) {
         return false;
     }
     
-    // Compress until end of file
+    // Compress until end of file or the limit
     int flush;
     do {
-        strm.avail_in = fread(in, 1, CHUNK, source);
+        size_t wanted = static_cast<size_t>(std::min<std::uint64_t>(CHUNK, limit));
+        strm.avail_in = wanted > 0 ? fread(in, 1, wanted, source) : 0;
+        limit -= strm.avail_in;
+        if (ioThrottle_) {
+            ioThrottle_->read(strm.avail_in);
+        }
         if (ferror(source)) {
             deflateEnd(&strm);
             std::cerr << "Error: Failed to read input file" << std::endl;
             return false;
         }
         
-        flush = feof(source) ? Z_FINISH : Z_NO_FLUSH;
+        flush = feof(source) || limit == 0 ? Z_FINISH : Z_NO_FLUSH;
         strm.next_in = in;
         
         // Run deflate() on input until output buffer not full
@@ -190,7 +282,10 @@ bool Compressor::compressFileInternal(FILE* source, FILE* dest, int level) {
             }
             
             size_t have = CHUNK - strm.avail_out;
-            if (fwrite(out, 1, have, dest) != have || ferror(dest)) {
+            if (ioThrottle_ && have > 0) {
+                ioThrottle_->write(have);
+            }
+            if (fwrite(out, 1, have, dest) != have || ferror(dest) || (written && have > 0 && !written(out, have))) {
                 deflateEnd(&strm);
                 std::cerr << "Error: Failed to write compressed data" << std::endl;
                 return false;
@@ -238,6 +333,9 @@ bool Compressor::decompressFileInternal(FILE* source, FILE* dest) {
     // Decompress until end of file
     do {
         strm.avail_in = fread(in, 1, CHUNK, source);
+        if (ioThrottle_) {
+            ioThrottle_->read(strm.avail_in);
+        }
         if (ferror(source)) {
             inflateEnd(&strm);
             std::cerr << "Error: Failed to read compressed file" << std::endl;
@@ -264,6 +362,9 @@ bool Compressor::decompressFileInternal(FILE* source, FILE* dest) {
             }
             
             size_t have = CHUNK - strm.avail_out;
+            if (ioThrottle_ && have > 0) {
+                ioThrottle_->write(have);
+            }
             if (fwrite(out, 1, have, dest) != have || ferror(dest)) {
                 inflateEnd(&strm);
                 std::cerr << "Error: Failed to write decompressed data" << std::endl;
@@ -305,13 +406,17 @@ std::vector<uint8_t> Compressor::processData(const std::vector<uint8_t>& data, b
     strm.avail_in = data.size();
     strm.next_in = const_cast<uint8_t*>(data.data());
     
+    // Compressed output is sized up front so the result never regrows
     std::vector<uint8_t> result;
-    const size_t CHUNK = 16384;
-    uint8_t out[CHUNK];
+    if (compress) {
+        result.reserve(deflateBound(&strm, static_cast<uLong>(data.size())));
+    }
+    BufferPool::Lease out = BufferPool::instance().lease(64 * 1024);
+    const size_t CHUNK = out.size();
     
     do {
         strm.avail_out = CHUNK;
-        strm.next_out = out;
+        strm.next_out = out.data();
         
         if (compress) {
             ret = deflate(&strm, Z_FINISH);
@@ -330,7 +435,7 @@ std::vector<uint8_t> Compressor::processData(const std::vector<uint8_t>& data, b
         }
         
         size_t have = CHUNK - strm.avail_out;
-        result.insert(result.end(), out, out + have);
+        result.insert(result.end(), out.data(), out.data() + have);
         
     } while (strm.avail_out == 0);
     
@@ -0,0 +1,269 @@
+#include "ConcurrencyTuner.h"
+#include "ThreadPool.h"
+#include "Utils.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <sys/resource.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+std::string pairKey(const std::string& source, const std::string& destination) {
+    return source + " -> " + destination;
+}
+
+} // namespace
+
+ConcurrencyTuner::ConcurrencyTuner(const Options& options, const Setting& defaults)
+    : options_(options)
+    , bestThroughput_(0.0)
+    , measured_(false)
+    , knob_(0)
+    , direction_(1)
+    , reversals_(0)
+    , settled_(0)
+    , steps_(0)
+    , totalReversals_(0)
+    , learned_(false)
+    , stopping_(false) {
+    current_ = clamp(defaults);
+    best_ = current_;
+}
+
+ConcurrencyTuner::~ConcurrencyTuner() {
+    stop();
+}
+
+bool ConcurrencyTuner::load(const std::string& stateFile, const std::string& source, const std::string& destination) {
+    if (!Utils::pathExists(stateFile)) {
+        return false;
+    }
+
+    try {
+        std::ifstream file(stateFile);
+        json j = json::parse(file);
+        std::string key = pairKey(source, destination);
+        if (!j.contains("pairs") || !j["pairs"].contains(key)) {
+            return false;
+        }
+
+        const json& entry = j["pairs"][key];
+        Setting setting;
+        setting.workers = entry.value("workers", current_.workers);
+        setting.writeSlots = entry.value("writeSlots", current_.writeSlots);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_ = clamp(setting);
+        best_ = current_;
+        learned_ = true;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: Ignoring unreadable tuning state " << stateFile << ": " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool ConcurrencyTuner::save(const std::string& stateFile, const std::string& source,
+                            const std::string& destination) const {
+    try {
+        json j = json::object();
+        if (Utils::pathExists(stateFile)) {
+            std::ifstream existing(stateFile);
+            j = json::parse(existing, nullptr, false);
+            if (j.is_discarded() || !j.is_object()) {
+                j = json::object();
+            }
+        }
+        j["version"] = "1.0";
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!measured_) {
+            return true;    // Nothing was learned; keep what is there
+        }
+        j["pairs"][pairKey(source, destination)] = {
+            {"workers", best_.workers},
+            {"writeSlots", best_.writeSlots},
+            {"throughput", bestThroughput_},
+            {"updated", Utils::formatTimestamp(std::chrono::system_clock::now())}
+        };
+
+        std::ofstream file(stateFile);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << j.dump(2);
+        return static_cast<bool>(file.flush());
+    } catch (const std::exception& e) {
+        std::cerr << "Error saving tuning state: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void ConcurrencyTuner::start(Probe probe, Apply apply) {
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopping_ = false;
+    }
+
+    thread_ = std::thread([this, probe = std::move(probe), apply = std::move(apply)]() {
+        std::unique_lock<std::mutex> lock(stopMutex_);
+        while (!stopRequested_.wait_for(lock, options_.interval, [this] { return stopping_; })) {
+            lock.unlock();
+            Setting before = current();
+            Setting after = step(probe());
+            if (after.workers != before.workers || after.writeSlots != before.writeSlots) {
+                apply(after);
+            }
+            lock.lock();
+        }
+    });
+}
+
+void ConcurrencyTuner::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopping_ = true;
+    }
+    stopRequested_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+ConcurrencyTuner::Setting ConcurrencyTuner::step(const Sample& sample) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    steps_++;
+
+    if (settled_ >= 2) {
+        // Holding; conditions changed enough to search again from here
+        if (sample.throughput < bestThroughput_ * (1.0 - 2.0 * options_.tolerance)) {
+            bestThroughput_ = sample.throughput;
+            settled_ = 0;
+            reversals_ = 0;
+            move(sample);
+        }
+        return current_;
+    }
+
+    if (!measured_ || sample.throughput > bestThroughput_ * (1.0 + options_.tolerance)) {
+        if (measured_) {
+            settled_ = 0;
+        }
+        best_ = current_;
+        bestThroughput_ = sample.throughput;
+        measured_ = true;
+        move(sample);
+        return current_;
+    }
+
+    // No better than the best: go back to it and try the other way
+    current_ = best_;
+    direction_ = -direction_;
+    reversals_++;
+    totalReversals_++;
+    if (reversals_ >= 2) {
+        settleKnob();
+    }
+    if (settled_ < 2) {
+        move(sample);
+    }
+    return current_;
+}
+
+ConcurrencyTuner::Setting ConcurrencyTuner::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_;
+}
+
+ConcurrencyTuner::Stats ConcurrencyTuner::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.steps = steps_;
+    stats.reversals = totalReversals_;
+    stats.best = best_;
+    stats.bestThroughput = bestThroughput_;
+    stats.learned = learned_;
+    return stats;
+}
+
+size_t ConcurrencyTuner::getMaxWorkers() const {
+    return options_.maxWorkers > 0 ? options_.maxWorkers : 2 * ThreadPool::defaultThreadCount();
+}
+
+double ConcurrencyTuner::processCpuSeconds() {
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+bool ConcurrencyTuner::readIoTicks(const std::string& deviceName, std::uint64_t& milliseconds) {
+    std::ifstream file("/proc/diskstats");
+    std::string line;
+    while (std::getline(file, line)) {
+        // major minor name reads ... in-flight io_ticks ...; io_ticks is the 13th field
+        std::istringstream fields(line);
+        unsigned int major = 0;
+        unsigned int minor = 0;
+        std::string name;
+        if (!(fields >> major >> minor >> name) || name != deviceName) {
+            continue;
+        }
+        std::uint64_t value = 0;
+        for (int field = 0; field < 10; ++field) {
+            if (!(fields >> value)) {
+                return false;
+            }
+        }
+        milliseconds = value;
+        return true;
+    }
+    return false;
+}
+
+size_t& ConcurrencyTuner::knob(Setting& setting) const {
+    return knob_ == 0 ? setting.workers : setting.writeSlots;
+}
+
+bool ConcurrencyTuner::canRaise(const Sample& sample) const {
+    if (knob_ == 0) {
+        return sample.cpu < options_.cpuCeiling && sample.queueOccupancy > 0.0;
+    }
+    return sample.ioBusy < 0.0 || sample.ioBusy < options_.ioCeiling;
+}
+
+void ConcurrencyTuner::move(const Sample& sample) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        size_t& value = knob(current_);
+        bool up = direction_ > 0;
+        if (up ? value < getMaxWorkers() && canRaise(sample) : value > 1) {
+            value = up ? value + 1 : value - 1;
+            return;
+        }
+        direction_ = -direction_;
+    }
+
+    // Neither way is open on this knob
+    settleKnob();
+}
+
+void ConcurrencyTuner::settleKnob() {
+    knob_ = 1 - knob_;
+    direction_ = 1;
+    reversals_ = 0;
+    settled_++;
+}
+
+ConcurrencyTuner::Setting ConcurrencyTuner::clamp(Setting setting) const {
+    size_t cap = getMaxWorkers();
+    setting.workers = std::min(std::max<size_t>(1, setting.workers), cap);
+    setting.writeSlots = std::min(std::max<size_t>(1, setting.writeSlots), cap);
+    return setting;
+}
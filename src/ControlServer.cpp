@@ -0,0 +1,261 @@
+#include "ControlServer.h"
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr size_t MAX_COMMAND_LENGTH = 4096;
+constexpr int CLIENT_TIMEOUT_MS = 5000;
+
+bool writeAll(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Reads up to the first newline; false on timeout, error or an oversized line
+bool readLine(int fd, std::string& line) {
+    line.clear();
+    char buffer[512];
+    while (line.size() <= MAX_COMMAND_LENGTH) {
+        pollfd pfd{fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, CLIENT_TIMEOUT_MS);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            return false;
+        }
+
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return !line.empty();   // Peer closed without a trailing newline
+        }
+
+        line.append(buffer, static_cast<size_t>(n));
+        size_t newline = line.find('\n');
+        if (newline != std::string::npos) {
+            line.resize(newline);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+ControlServer::ControlServer(const std::string& socketPath)
+    : socketPath_(socketPath)
+    , listenFd_(-1)
+    , wakeFds_{-1, -1}
+    , running_(false) {
+}
+
+ControlServer::~ControlServer() {
+    stop();
+}
+
+void ControlServer::registerCommand(const std::string& name, Handler handler) {
+    std::lock_guard<std::mutex> lock(handlersMutex_);
+    handlers_[name] = handler;
+}
+
+bool ControlServer::start() {
+    if (running_) {
+        return true;
+    }
+
+    sockaddr_un address;
+    if (!fillAddress(socketPath_, address)) {
+        std::cerr << "Error: Control socket path too long: " << socketPath_ << std::endl;
+        return false;
+    }
+
+    // A socket file nobody answers on is left over from a crashed daemon
+    std::string probe;
+    if (sendCommand(socketPath_, "ping", probe)) {
+        std::cerr << "Error: A daemon is already listening on " << socketPath_ << std::endl;
+        return false;
+    }
+    ::unlink(socketPath_.c_str());
+
+    listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "Error: Cannot create control socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Keep the socket private from the moment it appears on disk
+    mode_t previousMask = ::umask(0077);
+    int bound = ::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    ::umask(previousMask);
+
+    if (bound < 0 || ::chmod(socketPath_.c_str(), 0600) < 0 || ::listen(listenFd_, 8) < 0) {
+        std::cerr << "Error: Cannot listen on " << socketPath_ << ": " << std::strerror(errno) << std::endl;
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    if (::pipe2(wakeFds_, O_CLOEXEC) < 0) {
+        std::cerr << "Error: Cannot create control wakeup pipe: " << std::strerror(errno) << std::endl;
+        ::close(listenFd_);
+        listenFd_ = -1;
+        ::unlink(socketPath_.c_str());
+        return false;
+    }
+
+    running_ = true;
+    serverThread_ = std::thread(&ControlServer::serverLoop, this);
+    return true;
+}
+
+void ControlServer::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    char byte = 0;
+    if (::write(wakeFds_[1], &byte, 1) < 0) {
+        // The loop also notices running_ on its next poll timeout
+    }
+    if (serverThread_.joinable()) {
+        serverThread_.join();
+    }
+
+    ::close(listenFd_);
+    ::close(wakeFds_[0]);
+    ::close(wakeFds_[1]);
+    listenFd_ = -1;
+    wakeFds_[0] = wakeFds_[1] = -1;
+    ::unlink(socketPath_.c_str());
+}
+
+bool ControlServer::isRunning() const {
+    return running_;
+}
+
+std::string ControlServer::getSocketPath() const {
+    return socketPath_;
+}
+
+bool ControlServer::sendCommand(const std::string& socketPath, const std::string& command, std::string& response) {
+    sockaddr_un address;
+    if (!fillAddress(socketPath, address)) {
+        return false;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+              writeAll(fd, command + "\n") &&
+              readLine(fd, response);
+    ::close(fd);
+    return ok;
+}
+
+void ControlServer::serverLoop() {
+    while (running_) {
+        pollfd fds[2] = {{listenFd_, POLLIN, 0}, {wakeFds_[0], POLLIN, 0}};
+        int ready = ::poll(fds, 2, 1000);
+        if (ready <= 0 || (fds[1].revents & POLLIN)) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int clientFd = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (clientFd >= 0) {
+                handleConnection(clientFd);
+                ::close(clientFd);
+            }
+        }
+    }
+}
+
+void ControlServer::handleConnection(int clientFd) {
+    std::string line;
+    if (!readLine(clientFd, line)) {
+        writeAll(clientFd, "error: expected one command line\n");
+        return;
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    writeAll(clientFd, dispatch(line) + "\n");
+}
+
+std::string ControlServer::dispatch(const std::string& line) {
+    std::istringstream stream(line);
+    std::vector<std::string> args;
+    std::string word;
+    while (stream >> word) {
+        args.push_back(word);
+    }
+
+    if (args.empty()) {
+        return "error: empty command";
+    }
+    if (args[0] == "ping") {
+        return "pong";
+    }
+
+    Handler handler;
+    {
+        std::lock_guard<std::mutex> lock(handlersMutex_);
+        auto it = handlers_.find(args[0]);
+        if (it == handlers_.end()) {
+            std::string known = "ping";
+            for (const auto& pair : handlers_) {
+                known += ", " + pair.first;
+            }
+            return "error: unknown command '" + args[0] + "' (known: " + known + ")";
+        }
+        handler = it->second;
+    }
+
+    try {
+        std::string response = handler(args);
+        // One response per line keeps the protocol trivially parseable
+        for (char& c : response) {
+            if (c == '\n' || c == '\r') {
+                c = ' ';
+            }
+        }
+        return response;
+    } catch (const std::exception& e) {
+        return std::string("error: ") + e.what();
+    }
+}
+
+bool ControlServer::fillAddress(const std::string& socketPath, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+    return true;
+}
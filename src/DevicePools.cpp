@@ -0,0 +1,213 @@
+#include "DevicePools.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <limits.h>
+#include <stdlib.h>
+
+namespace {
+
+bool readRotational(const std::string& queueDirectory, bool& rotational) {
+    std::ifstream file(queueDirectory + "/rotational");
+    int value = 0;
+    if (!(file >> value)) {
+        return false;
+    }
+    rotational = value != 0;
+    return true;
+}
+
+} // namespace
+
+DevicePools::DevicePools()
+    : DevicePools(Options()) {
+}
+
+DevicePools::DevicePools(const Options& options)
+    : options_(options) {
+}
+
+DevicePools::~DevicePools() {
+    waitIdle();
+}
+
+void DevicePools::submit(std::uint64_t sourceDevice, std::uint64_t destinationDevice, std::function<void()> task) {
+    ThreadPool* readers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Device& source = getDevice(sourceDevice);
+        if (!source.readers) {
+            source.readers = std::make_unique<ThreadPool>(std::max(source.info.workers, options_.maxWorkers));
+            source.readers->setConcurrency(source.info.workers);
+        }
+        source.info.tasks++;
+        readers = source.readers.get();
+        if (destinationDevice != 0) {
+            getDevice(destinationDevice);
+        }
+    }
+
+    readers->submit([this, destinationDevice, task = std::move(task)]() {
+        if (destinationDevice == 0) {
+            task();
+            return;
+        }
+
+        // Holds a destination write slot for the whole task, released even if it throws
+        class WriteSlot {
+        public:
+            WriteSlot(DevicePools& pools, std::uint64_t device) : pools_(pools) {
+                std::unique_lock<std::mutex> lock(pools_.mutex_);
+                destination_ = &pools_.devices_.at(device);
+                pools_.slotFree_.wait(lock, [this] { return destination_->writers < destination_->info.writeSlots; });
+                destination_->writers++;
+            }
+            ~WriteSlot() {
+                {
+                    std::lock_guard<std::mutex> lock(pools_.mutex_);
+                    destination_->writers--;
+                }
+                pools_.slotFree_.notify_all();
+            }
+
+        private:
+            DevicePools& pools_;
+            Device* destination_;
+        };
+
+        WriteSlot slot(*this, destinationDevice);
+        task();
+    });
+}
+
+void DevicePools::waitIdle() {
+    std::vector<ThreadPool*> pools;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& pair : devices_) {
+            if (pair.second.readers) {
+                pools.push_back(pair.second.readers.get());
+            }
+        }
+    }
+    for (auto* pool : pools) {
+        pool->waitIdle();
+    }
+}
+
+void DevicePools::setWorkers(std::uint64_t device, size_t workers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(device);
+    if (it == devices_.end()) {
+        return;
+    }
+    Device& entry = it->second;
+    size_t limit = entry.readers ? entry.readers->getThreadCount()
+                                 : std::max(workersFor(entry.info.type), options_.maxWorkers);
+    entry.info.workers = std::min(std::max<size_t>(1, workers), limit);
+    if (entry.readers) {
+        entry.readers->setConcurrency(entry.info.workers);
+    }
+}
+
+void DevicePools::setWriteSlots(std::uint64_t device, size_t slots) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = devices_.find(device);
+        if (it == devices_.end()) {
+            return;
+        }
+        size_t limit = std::max(workersFor(it->second.info.type), options_.maxWorkers);
+        it->second.info.writeSlots = std::min(std::max<size_t>(1, slots), limit);
+    }
+    slotFree_.notify_all();
+}
+
+std::vector<DevicePools::DeviceInfo> DevicePools::getDevices() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<DeviceInfo> devices;
+    for (const auto& pair : devices_) {
+        DeviceInfo info = pair.second.info;
+        if (pair.second.readers) {
+            info.queued = pair.second.readers->getPendingTasks();
+            info.running = pair.second.readers->getActiveTasks();
+        }
+        devices.push_back(info);
+    }
+    return devices;
+}
+
+std::uint64_t DevicePools::deviceOf(const std::string& path) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(st.st_dev);
+}
+
+DevicePools::DeviceType DevicePools::probeDeviceType(std::uint64_t device, std::string& name) {
+    unsigned int major = ::major(static_cast<dev_t>(device));
+    unsigned int minor = ::minor(static_cast<dev_t>(device));
+    std::ostringstream id;
+    id << major << ":" << minor;
+    name = id.str();
+
+    // Major 0 is an anonymous device: tmpfs, overlayfs, NFS and friends have no queue to ask
+    std::string link = "/sys/dev/block/" + name;
+    char resolved[PATH_MAX];
+    if (major == 0 || !::realpath(link.c_str(), resolved)) {
+        return DeviceType::UNKNOWN;
+    }
+
+    std::string block(resolved);
+    name = block.substr(block.find_last_of('/') + 1);
+
+    // A partition has no queue of its own; the disk it belongs to is its parent directory
+    bool rotational = false;
+    if (readRotational(block + "/queue", rotational) ||
+        readRotational(block.substr(0, block.find_last_of('/')) + "/queue", rotational)) {
+        return rotational ? DeviceType::ROTATIONAL : DeviceType::SOLID_STATE;
+    }
+    return DeviceType::UNKNOWN;
+}
+
+std::string DevicePools::typeToString(DeviceType type) {
+    switch (type) {
+        case DeviceType::ROTATIONAL: return "rotational";
+        case DeviceType::SOLID_STATE: return "solid-state";
+        case DeviceType::UNKNOWN: return "unknown";
+    }
+    return "unknown";
+}
+
+DevicePools::Device& DevicePools::getDevice(std::uint64_t device) {
+    auto it = devices_.find(device);
+    if (it != devices_.end()) {
+        return it->second;
+    }
+
+    Device& entry = devices_[device];
+    entry.info.device = device;
+    entry.info.type = device == 0 ? DeviceType::UNKNOWN : probeDeviceType(device, entry.info.name);
+    if (device == 0) {
+        entry.info.name = "unknown";
+    }
+    entry.info.workers = workersFor(entry.info.type);
+    entry.info.writeSlots = options_.writeSlots > 0 ? options_.writeSlots : entry.info.workers;
+    return entry;
+}
+
+size_t DevicePools::workersFor(DeviceType type) const {
+    switch (type) {
+        case DeviceType::ROTATIONAL:
+            return std::max<size_t>(1, options_.rotationalWorkers);
+        case DeviceType::SOLID_STATE:
+            return options_.solidStateWorkers > 0 ? options_.solidStateWorkers : ThreadPool::defaultThreadCount();
+        case DeviceType::UNKNOWN:
+            break;
+    }
+    return std::max<size_t>(1, options_.unknownWorkers);
+}
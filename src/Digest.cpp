@@ -0,0 +1,104 @@
+#include "Digest.h"
+#include "Utils.h"
+#include <openssl/evp.h>
+#include <stdexcept>
+
+Digest::Digest()
+    : bytes_{}
+    , algorithm_(Algorithm::NONE) {
+}
+
+Digest::Digest(Algorithm algorithm, const uint8_t* bytes, size_t length)
+    : bytes_{}
+    , algorithm_(algorithm) {
+    if (length != digestSize(algorithm)) {
+        algorithm_ = Algorithm::NONE;
+        return;
+    }
+    std::memcpy(bytes_.data(), bytes, length);
+}
+
+Digest Digest::sha256(const void* data, size_t length) {
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hashLength = 0;
+    if (EVP_Digest(data, length, hash, &hashLength, EVP_sha256(), nullptr) != 1) {
+        return Digest();
+    }
+    return Digest(Algorithm::SHA256, hash, hashLength);
+}
+
+std::string Digest::toHex() const {
+    return Utils::hexEncode(bytes_.data(), size());
+}
+
+Digest Digest::fromHex(const std::string& hex) {
+    // Infer the algorithm from the encoded length
+    switch (hex.size()) {
+        case 64:
+            return fromHex(hex, Algorithm::SHA256);
+        case 32:
+            return fromHex(hex, Algorithm::MD5);
+        default:
+            return Digest();
+    }
+}
+
+Digest Digest::fromHex(const std::string& hex, Algorithm algorithm) {
+    size_t length = digestSize(algorithm);
+    if (length == 0 || hex.size() != length * 2) {
+        return Digest();
+    }
+
+    uint8_t bytes[MAX_SIZE];
+    if (!Utils::hexDecode(hex, bytes, length)) {
+        return Digest();
+    }
+    return Digest(algorithm, bytes, length);
+}
+
+size_t Digest::digestSize(Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::SHA256:
+        case Algorithm::HMAC_SHA256:
+            return 32;
+        case Algorithm::MD5:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+DigestBuilder::DigestBuilder(Digest::Algorithm algorithm)
+    : ctx_(EVP_MD_CTX_new())
+    , algorithm_(algorithm) {
+    if (!ctx_) {
+        throw std::runtime_error("Failed to allocate digest context");
+    }
+    reset();
+}
+
+DigestBuilder::~DigestBuilder() {
+    EVP_MD_CTX_free(ctx_);
+}
+
+void DigestBuilder::update(const void* data, size_t length) {
+    EVP_DigestUpdate(ctx_, data, length);
+}
+
+Digest DigestBuilder::finish() {
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hashLength = 0;
+    if (EVP_DigestFinal_ex(ctx_, hash, &hashLength) != 1) {
+        return Digest();
+    }
+    Digest digest(algorithm_, hash, hashLength);
+    reset();
+    return digest;
+}
+
+void DigestBuilder::reset() {
+    const EVP_MD* md = algorithm_ == Digest::Algorithm::MD5 ? EVP_md5() : EVP_sha256();
+    if (EVP_DigestInit_ex(ctx_, md, nullptr) != 1) {
+        throw std::runtime_error("Failed to initialize digest context");
+    }
+}
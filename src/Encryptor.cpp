@@ -1,35 +1,128 @@
 #include "Encryptor.h"
 #include "Utils.h"
+#include "IoThrottle.h"
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 #include <openssl/aes.h>
 #include <openssl/hmac.h>
 #include <openssl/kdf.h>
+#include <openssl/crypto.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <sstream>
-#include <iomanip>
+#include <limits>
+
+namespace {
+
+// Plaintext or ciphertext taken per cipher update, so its output fits one pooled 64 KiB buffer
+constexpr size_t CHUNK_SIZE = 64 * 1024 - EVP_MAX_BLOCK_LENGTH;
+
+} // namespace
 
 Encryptor::Encryptor() 
-    : keySize_(KeySize::AES_256) {
+    : keySize_(KeySize::AES_256)
+    , ioThrottle_(nullptr) {
     initializeEncryption();
 }
 
 Encryptor::~Encryptor() = default;
 
+Encryptor::StreamDecryptor::StreamDecryptor(const Encryptor& encryptor, DataSink sink)
+    : key_(encryptor.key_)
+    , sink_(std::move(sink))
+    , ctx_(nullptr)
+    , failed_(key_.empty()) {
+    if (failed_) {
+        std::cerr << "Error: No decryption key set" << std::endl;
+    }
+}
+
+Encryptor::StreamDecryptor::~StreamDecryptor() {
+    if (ctx_) {
+        EVP_CIPHER_CTX_free(ctx_);
+    }
+    OPENSSL_cleanse(key_.data(), key_.size());
+}
+
+bool Encryptor::StreamDecryptor::write(const uint8_t* data, size_t length) {
+    if (failed_) {
+        return false;
+    }
+    
+    // The first 24 bytes are the "ENCRYPT1" header and the IV
+    const size_t HEADER_SIZE = 8 + 16;
+    if (!ctx_) {
+        size_t take = std::min(length, HEADER_SIZE - header_.size());
+        header_.insert(header_.end(), data, data + take);
+        data += take;
+        length -= take;
+        if (header_.size() < HEADER_SIZE) {
+            return true;
+        }
+        
+        if (std::string(header_.begin(), header_.begin() + 8) != "ENCRYPT1") {
+            std::cerr << "Error: Invalid encryption header" << std::endl;
+            failed_ = true;
+            return false;
+        }
+        ctx_ = EVP_CIPHER_CTX_new();
+        if (!ctx_ || EVP_DecryptInit_ex(ctx_, EVP_aes_256_cbc(), nullptr, key_.data(), header_.data() + 8) != 1) {
+            failed_ = true;
+            return false;
+        }
+    }
+    
+    if (!outBuffer_) {
+        outBuffer_ = BufferPool::instance().lease(CHUNK_SIZE + EVP_MAX_BLOCK_LENGTH);
+    }
+    while (length > 0) {
+        size_t chunk = std::min(length, CHUNK_SIZE);
+        int outLen;
+        if (EVP_DecryptUpdate(ctx_, outBuffer_.data(), &outLen, data, static_cast<int>(chunk)) != 1 ||
+            (outLen > 0 && !sink_(outBuffer_.data(), static_cast<size_t>(outLen)))) {
+            failed_ = true;
+            return false;
+        }
+        data += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+bool Encryptor::StreamDecryptor::finish() {
+    if (failed_ || !ctx_) {
+        return false;
+    }
+    
+    int finalLen;
+    if (!outBuffer_) {
+        outBuffer_ = BufferPool::instance().lease(2 * EVP_MAX_BLOCK_LENGTH);
+    }
+    if (EVP_DecryptFinal_ex(ctx_, outBuffer_.data(), &finalLen) != 1 ||
+        (finalLen > 0 && !sink_(outBuffer_.data(), static_cast<size_t>(finalLen)))) {
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+void Encryptor::setIoThrottle(IoThrottle* throttle) {
+    ioThrottle_ = throttle;
+}
+
 bool Encryptor::setKey(const std::string& key) {
     if (key.empty()) {
         return false;
     }
     
     // If key is hex-encoded, decode it
+    std::vector<uint8_t> decoded;
     if (key.length() == 64) { // 32 bytes * 2 hex chars
-        key_.clear();
-        for (size_t i = 0; i < key.length(); i += 2) {
-            std::string byteStr = key.substr(i, 2);
-            uint8_t byte = static_cast<uint8_t>(std::stoul(byteStr, nullptr, 16));
-            key_.push_back(byte);
-        }
+        decoded = Utils::hexDecode(key);
+    }
+    
+    if (!decoded.empty()) {
+        key_ = decoded;
     } else {
         // Use key as-is, pad or truncate to 32 bytes
         key_.assign(key.begin(), key.end());
@@ -48,14 +141,11 @@ bool Encryptor::generateRandomKey(KeySize keySize) {
 }
 
 std::string Encryptor::getKeyHex() const {
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    
-    for (uint8_t byte : key_) {
-        ss << std::setw(2) << static_cast<int>(byte);
-    }
-    
-    return ss.str();
+    return Utils::hexEncode(key_);
+}
+
+bool Encryptor::hasKey() const {
+    return !key_.empty();
 }
 
 bool Encryptor::loadKeyFromFile(const std::string& keyFile) {
@@ -80,7 +170,12 @@ bool Encryptor::saveKeyToFile(const std::string& keyFile) {
     return file.good();
 }
 
-bool Encryptor::encryptFile(const std::string& inputFile, const std::string& outputFile) {
+bool Encryptor::encryptFile(const std::string& inputFile, const std::string& outputFile, const DataSink& written) {
+    return encryptFile(inputFile, outputFile, 0, std::numeric_limits<std::uint64_t>::max(), written);
+}
+
+bool Encryptor::encryptFile(const std::string& inputFile, const std::string& outputFile,
+                            std::uint64_t offset, std::uint64_t length, const DataSink& written) {
     if (key_.empty()) {
         std::cerr << "Error: No encryption key set" << std::endl;
         return false;
@@ -91,6 +186,11 @@ bool Encryptor::encryptFile(const std::string& inputFile, const std::string& out
         std::cerr << "Error: Cannot open input file: " << inputFile << std::endl;
         return false;
     }
+    if (offset > 0 && fseeko(input, static_cast<off_t>(offset), SEEK_SET) != 0) {
+        std::cerr << "Error: Cannot seek in input file: " << inputFile << std::endl;
+        fclose(input);
+        return false;
+    }
     
     FILE* output = fopen(outputFile.c_str(), "wb");
     if (!output) {
@@ -99,12 +199,12 @@ bool Encryptor::encryptFile(const std::string& inputFile, const std::string& out
         return false;
     }
     
-    bool result = encryptFileInternal(input, output);
+    bool result = encryptFileInternal(input, output, length, written);
     
     fclose(input);
-    fclose(output);
     
-    return result;
+    // A failed close means buffered output never reached the file
+    return fclose(output) == 0 && result;
 }
 
 bool Encryptor::decryptFile(const std::string& inputFile, const std::string& outputFile) {
@@ -147,23 +247,12 @@ std::string Encryptor::encryptString(const std::string& plaintext) {
     std::vector<uint8_t> encrypted = encryptData(data);
     
     // Convert to hex string
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (uint8_t byte : encrypted) {
-        ss << std::setw(2) << static_cast<int>(byte);
-    }
-    
-    return ss.str();
+    return Utils::hexEncode(encrypted);
 }
 
 std::string Encryptor::decryptString(const std::string& encrypted) {
     // Convert from hex string
-    std::vector<uint8_t> data;
-    for (size_t i = 0; i < encrypted.length(); i += 2) {
-        std::string byteStr = encrypted.substr(i, 2);
-        uint8_t byte = static_cast<uint8_t>(std::stoul(byteStr, nullptr, 16));
-        data.push_back(byte);
-    }
+    std::vector<uint8_t> data = Utils::hexDecode(encrypted);
     
     std::vector<uint8_t> decrypted = decryptData(data);
     return std::string(decrypted.begin(), decrypted.end());
@@ -187,32 +276,31 @@ bool Encryptor::isEncrypted(const std::string& filePath) {
     return std::string(header, 8) == "ENCRYPT1";
 }
 
-std::string Encryptor::calculateHMAC(const std::string& data) {
+Digest Encryptor::calculateHMAC(const std::string& data) {
     if (key_.empty()) {
-        return "";
+        return Digest();
     }
     
-    unsigned char* digest = HMAC(EVP_sha256(), 
-                                key_.data(), key_.size(),
-                                reinterpret_cast<const unsigned char*>(data.c_str()), data.length(),
-                                nullptr, nullptr);
-    
-    if (!digest) {
-        return "";
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    if (!HMAC(EVP_sha256(), 
+              key_.data(), key_.size(),
+              reinterpret_cast<const unsigned char*>(data.c_str()), data.length(),
+              digest, &digestLength)) {
+        return Digest();
     }
     
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (int i = 0; i < 32; i++) {
-        ss << std::setw(2) << static_cast<int>(digest[i]);
-    }
-    
-    return ss.str();
+    return Digest(Digest::Algorithm::HMAC_SHA256, digest, digestLength);
 }
 
-bool Encryptor::verifyHMAC(const std::string& data, const std::string& hmac) {
-    std::string calculatedHMAC = calculateHMAC(data);
-    return calculatedHMAC == hmac;
+bool Encryptor::verifyHMAC(const std::string& data, const Digest& hmac) {
+    Digest calculatedHMAC = calculateHMAC(data);
+    if (calculatedHMAC.empty() || calculatedHMAC.algorithm() != hmac.algorithm()) {
+        return false;
+    }
+    
+    // Constant-time comparison to avoid leaking the matching prefix length
+    return CRYPTO_memcmp(calculatedHMAC.data(), hmac.data(), calculatedHMAC.size()) == 0;
 }
 
 std::string Encryptor::deriveKeyFromPassword(const std::string& password, const std::string& salt) {
@@ -230,25 +318,12 @@ std::string Encryptor::deriveKeyFromPassword(const std::string& password, const
         return "";
     }
     
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (uint8_t byte : derivedKey) {
-        ss << std::setw(2) << static_cast<int>(byte);
-    }
-    
-    return ss.str();
+    return Utils::hexEncode(derivedKey);
 }
 
 std::string Encryptor::generateSalt() {
     auto saltBytes = generateRandomBytes(16);
-    
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (uint8_t byte : saltBytes) {
-        ss << std::setw(2) << static_cast<int>(byte);
-    }
-    
-    return ss.str();
+    return Utils::hexEncode(saltBytes);
 }
 
 bool Encryptor::initializeEncryption() {
@@ -293,8 +368,8 @@ std::vector<uint8_t> Encryptor::processData(const std::vector<uint8_t>& data, bo
     }
     
     // Process data
-    const size_t CHUNK_SIZE = 4096;
-    std::vector<uint8_t> outBuffer(CHUNK_SIZE + EVP_CIPHER_block_size(EVP_aes_256_cbc()));
+    BufferPool::Lease outBuffer = BufferPool::instance().lease(CHUNK_SIZE + EVP_MAX_BLOCK_LENGTH);
+    result.reserve(data.size() + EVP_MAX_BLOCK_LENGTH);
     
     for (size_t i = 0; i < data.size(); i += CHUNK_SIZE) {
         size_t chunkSize = std::min(CHUNK_SIZE, data.size() - i);
@@ -313,7 +388,7 @@ std::vector<uint8_t> Encryptor::processData(const std::vector<uint8_t>& data, bo
             return std::vector<uint8_t>();
         }
         
-        result.insert(result.end(), outBuffer.begin(), outBuffer.begin() + outLen);
+        result.insert(result.end(), outBuffer.data(), outBuffer.data() + outLen);
     }
     
     // Finalize
@@ -325,7 +400,7 @@ std::vector<uint8_t> Encryptor::processData(const std::vector<uint8_t>& data, bo
     }
     
     if (ret == 1) {
-        result.insert(result.end(), outBuffer.begin(), outBuffer.begin() + finalLen);
+        result.insert(result.end(), outBuffer.data(), outBuffer.data() + finalLen);
     }
     
     EVP_CIPHER_CTX_free(ctx);
@@ -333,14 +408,25 @@ std::vector<uint8_t> Encryptor::processData(const std::vector<uint8_t>& data, bo
     return (ret == 1) ? result : std::vector<uint8_t>();
 }
 
-bool Encryptor::encryptFileInternal(FILE* input, FILE* output) {
+bool Encryptor::encryptFileInternal(FILE* input, FILE* output, std::uint64_t limit, const DataSink& written) {
+    auto put = [output, &written](const uint8_t* data, size_t length) {
+        return fwrite(data, 1, length, output) == length && (!written || length == 0 || written(data, length));
+    };
+    
+    // Every file and split segment gets a fresh IV so no two blobs share one under the same key
+    std::vector<uint8_t> iv = generateRandomBytes(16);
+    if (iv.empty()) {
+        std::cerr << "Error: Failed to generate IV" << std::endl;
+        return false;
+    }
+    
     // Write header and IV
     const char* header = "ENCRYPT1";
-    if (fwrite(header, 1, 8, output) != 8) {
+    if (!put(reinterpret_cast<const uint8_t*>(header), 8)) {
         return false;
     }
     
-    if (fwrite(iv_.data(), 1, iv_.size(), output) != iv_.size()) {
+    if (!put(iv.data(), iv.size())) {
         return false;
     }
     
@@ -349,24 +435,31 @@ bool Encryptor::encryptFileInternal(FILE* input, FILE* output) {
         return false;
     }
     
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key_.data(), iv_.data()) != 1) {
+    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key_.data(), iv.data()) != 1) {
         EVP_CIPHER_CTX_free(ctx);
         return false;
     }
     
-    const size_t CHUNK_SIZE = 4096;
-    std::vector<uint8_t> inBuffer(CHUNK_SIZE);
-    std::vector<uint8_t> outBuffer(CHUNK_SIZE + EVP_CIPHER_block_size(EVP_aes_256_cbc()));
+    BufferPool::Lease inBuffer = BufferPool::instance().lease(CHUNK_SIZE);
+    BufferPool::Lease outBuffer = BufferPool::instance().lease(CHUNK_SIZE + EVP_MAX_BLOCK_LENGTH);
     
     size_t bytesRead;
-    while ((bytesRead = fread(inBuffer.data(), 1, CHUNK_SIZE, input)) > 0) {
+    while (limit > 0 &&
+           (bytesRead = fread(inBuffer.data(), 1, static_cast<size_t>(std::min<std::uint64_t>(CHUNK_SIZE, limit)), input)) > 0) {
+        limit -= bytesRead;
+        if (ioThrottle_) {
+            ioThrottle_->read(bytesRead);
+        }
         int outLen;
         if (EVP_EncryptUpdate(ctx, outBuffer.data(), &outLen, inBuffer.data(), bytesRead) != 1) {
             EVP_CIPHER_CTX_free(ctx);
             return false;
         }
         
-        if (fwrite(outBuffer.data(), 1, outLen, output) != static_cast<size_t>(outLen)) {
+        if (ioThrottle_ && outLen > 0) {
+            ioThrottle_->write(static_cast<size_t>(outLen));
+        }
+        if (!put(outBuffer.data(), static_cast<size_t>(outLen))) {
             EVP_CIPHER_CTX_free(ctx);
             return false;
         }
@@ -378,7 +471,7 @@ bool Encryptor::encryptFileInternal(FILE* input, FILE* output) {
         return false;
     }
     
-    if (fwrite(outBuffer.data(), 1, finalLen, output) != static_cast<size_t>(finalLen)) {
+    if (!put(outBuffer.data(), static_cast<size_t>(finalLen))) {
         EVP_CIPHER_CTX_free(ctx);
         return false;
     }
@@ -388,6 +481,20 @@ bool Encryptor::encryptFileInternal(FILE* input, FILE* output) {
 }
 
 bool Encryptor::decryptFileInternal(FILE* input, FILE* output) {
+    return decryptStream(input, [this, output](const uint8_t* data, size_t length) {
+        if (ioThrottle_) {
+            ioThrottle_->write(length);
+        }
+        return fwrite(data, 1, length, output) == length;
+    });
+}
+
+bool Encryptor::decryptStream(FILE* input, const DataSink& sink) const {
+    if (key_.empty()) {
+        std::cerr << "Error: No decryption key set" << std::endl;
+        return false;
+    }
+    
     // Read and verify header
     char header[8];
     if (fread(header, 1, 8, input) != 8 || std::string(header, 8) != "ENCRYPT1") {
@@ -412,31 +519,33 @@ bool Encryptor::decryptFileInternal(FILE* input, FILE* output) {
         return false;
     }
     
-    const size_t CHUNK_SIZE = 4096;
-    std::vector<uint8_t> inBuffer(CHUNK_SIZE);
-    std::vector<uint8_t> outBuffer(CHUNK_SIZE + EVP_CIPHER_block_size(EVP_aes_256_cbc()));
+    BufferPool::Lease inBuffer = BufferPool::instance().lease(CHUNK_SIZE);
+    BufferPool::Lease outBuffer = BufferPool::instance().lease(CHUNK_SIZE + EVP_MAX_BLOCK_LENGTH);
     
     size_t bytesRead;
     while ((bytesRead = fread(inBuffer.data(), 1, CHUNK_SIZE, input)) > 0) {
+        if (ioThrottle_) {
+            ioThrottle_->read(bytesRead);
+        }
         int outLen;
         if (EVP_DecryptUpdate(ctx, outBuffer.data(), &outLen, inBuffer.data(), bytesRead) != 1) {
             EVP_CIPHER_CTX_free(ctx);
             return false;
         }
         
-        if (fwrite(outBuffer.data(), 1, outLen, output) != static_cast<size_t>(outLen)) {
+        if (outLen > 0 && !sink(outBuffer.data(), static_cast<size_t>(outLen))) {
             EVP_CIPHER_CTX_free(ctx);
             return false;
         }
     }
     
     int finalLen;
-    if (EVP_DecryptFinal_ex(ctx, outBuffer.data(), &finalLen) != 1) {
+    if (ferror(input) || EVP_DecryptFinal_ex(ctx, outBuffer.data(), &finalLen) != 1) {
         EVP_CIPHER_CTX_free(ctx);
         return false;
     }
     
-    if (fwrite(outBuffer.data(), 1, finalLen, output) != static_cast<size_t>(finalLen)) {
+    if (finalLen > 0 && !sink(outBuffer.data(), static_cast<size_t>(finalLen))) {
         EVP_CIPHER_CTX_free(ctx);
         return false;
     }
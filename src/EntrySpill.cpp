@@ -0,0 +1,71 @@
+#include "EntrySpill.h"
+#include <filesystem>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+EntrySpill::EntrySpill(const std::string& path)
+    : path_(path)
+    , count_(0) {
+}
+
+EntrySpill::~EntrySpill() {
+    output_.close();
+    std::error_code error;
+    std::filesystem::remove(path_, error);
+}
+
+bool EntrySpill::write(const BackupMetadata::FileEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!output_.is_open()) {
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path_).parent_path(), error);
+        output_.open(path_, std::ios::trunc);
+        if (!output_) {
+            std::cerr << "Error: Cannot open spill file: " << path_ << std::endl;
+            return false;
+        }
+    }
+
+    output_ << BackupMetadata::fileEntryToJson(entry).dump() << '\n';
+    count_++;
+    return static_cast<bool>(output_);
+}
+
+bool EntrySpill::forEach(const std::function<bool(const BackupMetadata::FileEntry&)>& visit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ == 0) {
+        return true;
+    }
+    if (!output_.flush()) {
+        return false;
+    }
+
+    std::ifstream input(path_);
+    std::string text;
+    size_t visited = 0;
+    while (std::getline(input, text)) {
+        BackupMetadata::FileEntry entry;
+        try {
+            entry = BackupMetadata::fileEntryFromJson(json::parse(text));
+        } catch (const std::exception& e) {
+            std::cerr << "Error: Corrupt spill file " << path_ << ": " << e.what() << std::endl;
+            return false;
+        }
+        if (!visit(entry)) {
+            return false;
+        }
+        visited++;
+    }
+    return visited == count_;
+}
+
+size_t EntrySpill::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+const std::string& EntrySpill::getPath() const {
+    return path_;
+}
@@ -0,0 +1,542 @@
+#include "ErasureCoder.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// GF(2^8) with the polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11d)
+struct GaloisTables {
+    uint8_t exp[512];
+    uint8_t log[256];
+    uint8_t mul[256][256];
+
+    GaloisTables() {
+        unsigned int value = 1;
+        for (int i = 0; i < 255; ++i) {
+            exp[i] = static_cast<uint8_t>(value);
+            log[value] = static_cast<uint8_t>(i);
+            value <<= 1;
+            if (value & 0x100) {
+                value ^= 0x11d;
+            }
+        }
+        for (int i = 255; i < 512; ++i) {
+            exp[i] = exp[i - 255];
+        }
+        log[0] = 0;
+
+        for (int a = 0; a < 256; ++a) {
+            for (int b = 0; b < 256; ++b) {
+                mul[a][b] = (a == 0 || b == 0) ? 0 : exp[log[a] + log[b]];
+            }
+        }
+    }
+
+    uint8_t inverse(uint8_t a) const {
+        return exp[255 - log[a]];
+    }
+};
+
+const GaloisTables GF;
+
+void mulAddScalar(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t length) {
+    const uint8_t* row = GF.mul[coefficient];
+    for (size_t i = 0; i < length; ++i) {
+        dst[i] ^= row[src[i]];
+    }
+}
+
+#if defined(__x86_64__)
+// Split-nibble multiply: two 16-entry lookups per byte through pshufb
+__attribute__((target("ssse3")))
+void mulAddSsse3(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t length) {
+    const uint8_t* row = GF.mul[coefficient];
+    alignas(16) uint8_t low[16];
+    alignas(16) uint8_t high[16];
+    for (int i = 0; i < 16; ++i) {
+        low[i] = row[i];
+        high[i] = row[i << 4];
+    }
+
+    const __m128i lowTable = _mm_load_si128(reinterpret_cast<const __m128i*>(low));
+    const __m128i highTable = _mm_load_si128(reinterpret_cast<const __m128i*>(high));
+    const __m128i mask = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i product = _mm_xor_si128(
+            _mm_shuffle_epi8(lowTable, _mm_and_si128(input, mask)),
+            _mm_shuffle_epi8(highTable, _mm_and_si128(_mm_srli_epi64(input, 4), mask)));
+        __m128i output = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(output, product));
+    }
+    mulAddScalar(dst + i, src + i, coefficient, length - i);
+}
+
+__attribute__((target("avx2")))
+void mulAddAvx2(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t length) {
+    const uint8_t* row = GF.mul[coefficient];
+    alignas(16) uint8_t low[16];
+    alignas(16) uint8_t high[16];
+    for (int i = 0; i < 16; ++i) {
+        low[i] = row[i];
+        high[i] = row[i << 4];
+    }
+
+    const __m256i lowTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(low)));
+    const __m256i highTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(high)));
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i product = _mm256_xor_si256(
+            _mm256_shuffle_epi8(lowTable, _mm256_and_si256(input, mask)),
+            _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi64(input, 4), mask)));
+        __m256i output = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(output, product));
+    }
+    mulAddScalar(dst + i, src + i, coefficient, length - i);
+}
+#endif
+
+// Sidecar layout: 32-byte header, then per stripe (k + m) shard CRC32Cs and m parity shards
+constexpr char PARITY_MAGIC[4] = {'B', 'P', 'A', 'R'};
+constexpr uint8_t PARITY_VERSION = 1;
+constexpr size_t HEADER_SIZE = 32;
+constexpr size_t MIN_SHARD_SIZE = 64;
+
+void putLE32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void putLE64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t getLE32(const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+uint64_t getLE64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+// Reads up to length bytes at offset and zero-fills the rest
+size_t readPadded(FILE* file, uint64_t offset, uint8_t* buffer, size_t length) {
+    std::memset(buffer, 0, length);
+    if (fseeko(file, static_cast<off_t>(offset), SEEK_SET) != 0) {
+        return 0;
+    }
+    return fread(buffer, 1, length, file);
+}
+
+} // namespace
+
+ErasureCoder::ErasureCoder(size_t dataShards, size_t parityShards, Kernel kernel)
+    : dataShards_(dataShards)
+    , parityShards_(parityShards)
+    , kernel_(kernel) {
+    if (dataShards_ == 0 || parityShards_ == 0 || dataShards_ + parityShards_ > MAX_SHARDS) {
+        throw std::invalid_argument("Invalid erasure coding layout");
+    }
+
+    if (kernel_ == Kernel::AUTO) {
+        kernel_ = isKernelSupported(Kernel::AVX2) ? Kernel::AVX2 :
+                  isKernelSupported(Kernel::SSSE3) ? Kernel::SSSE3 : Kernel::SCALAR;
+    } else if (!isKernelSupported(kernel_)) {
+        kernel_ = Kernel::SCALAR;
+    }
+
+    // Identity rows keep the code systematic; Cauchy rows 1 / (x_i + y_j) make
+    // every k x k submatrix invertible
+    matrix_.assign((dataShards_ + parityShards_) * dataShards_, 0);
+    for (size_t j = 0; j < dataShards_; ++j) {
+        matrix_[j * dataShards_ + j] = 1;
+    }
+    for (size_t i = 0; i < parityShards_; ++i) {
+        for (size_t j = 0; j < dataShards_; ++j) {
+            uint8_t x = static_cast<uint8_t>(dataShards_ + i);
+            uint8_t y = static_cast<uint8_t>(j);
+            matrix_[(dataShards_ + i) * dataShards_ + j] = GF.inverse(x ^ y);
+        }
+    }
+}
+
+ErasureCoder::~ErasureCoder() = default;
+
+void ErasureCoder::encode(const std::vector<const uint8_t*>& data, std::vector<uint8_t*>& parity,
+                          size_t shardSize) const {
+    for (size_t i = 0; i < parityShards_; ++i) {
+        const uint8_t* row = &matrix_[(dataShards_ + i) * dataShards_];
+        std::memset(parity[i], 0, shardSize);
+        for (size_t j = 0; j < dataShards_; ++j) {
+            mulAdd(parity[i], data[j], row[j], shardSize);
+        }
+    }
+}
+
+bool ErasureCoder::reconstruct(std::vector<uint8_t*>& shards, const std::vector<bool>& present,
+                               size_t shardSize) const {
+    const size_t k = dataShards_;
+
+    // Any k surviving shards determine the data
+    std::vector<size_t> rows;
+    for (size_t i = 0; i < shards.size() && rows.size() < k; ++i) {
+        if (present[i]) {
+            rows.push_back(i);
+        }
+    }
+    if (rows.size() < k) {
+        return false;
+    }
+
+    bool dataMissing = false;
+    for (size_t j = 0; j < k; ++j) {
+        dataMissing = dataMissing || !present[j];
+    }
+
+    if (dataMissing) {
+        std::vector<uint8_t> decode(k * k);
+        for (size_t r = 0; r < k; ++r) {
+            std::memcpy(&decode[r * k], &matrix_[rows[r] * k], k);
+        }
+        if (!invertMatrix(decode, k)) {
+            return false;
+        }
+
+        for (size_t j = 0; j < k; ++j) {
+            if (present[j]) {
+                continue;
+            }
+            std::memset(shards[j], 0, shardSize);
+            for (size_t r = 0; r < k; ++r) {
+                mulAdd(shards[j], shards[rows[r]], decode[j * k + r], shardSize);
+            }
+        }
+    }
+
+    // Missing parity is simply re-encoded from the now complete data
+    for (size_t i = 0; i < parityShards_; ++i) {
+        if (present[k + i]) {
+            continue;
+        }
+        const uint8_t* row = &matrix_[(k + i) * k];
+        std::memset(shards[k + i], 0, shardSize);
+        for (size_t j = 0; j < k; ++j) {
+            mulAdd(shards[k + i], shards[j], row[j], shardSize);
+        }
+    }
+
+    return true;
+}
+
+bool ErasureCoder::encodeFile(const std::string& filePath, const std::string& parityPath,
+                              size_t maxShardSize) const {
+    FILE* input = fopen(filePath.c_str(), "rb");
+    if (!input) {
+        return false;
+    }
+
+    Utils::createDirectoryRecursive(Utils::getParentDirectory(parityPath));
+    std::string tempPath = parityPath + ".tmp";
+    FILE* output = fopen(tempPath.c_str(), "wb");
+    if (!output) {
+        fclose(input);
+        return false;
+    }
+
+    const size_t k = dataShards_;
+    const size_t m = parityShards_;
+    uint64_t fileSize = Utils::getFileSize(filePath);
+
+    // Small files get small shards so parity stays proportional to the data
+    size_t shardSize = static_cast<size_t>((fileSize + k - 1) / k);
+    shardSize = (shardSize + MIN_SHARD_SIZE - 1) / MIN_SHARD_SIZE * MIN_SHARD_SIZE;
+    shardSize = std::max(MIN_SHARD_SIZE, std::min(shardSize, std::max(maxShardSize, MIN_SHARD_SIZE)));
+
+    uint8_t header[HEADER_SIZE] = {};
+    std::memcpy(header, PARITY_MAGIC, 4);
+    header[4] = PARITY_VERSION;
+    header[5] = static_cast<uint8_t>(k);
+    header[6] = static_cast<uint8_t>(m);
+    putLE32(header + 8, static_cast<uint32_t>(shardSize));
+    putLE64(header + 16, fileSize);
+    putLE32(header + 28, Utils::crc32c(header, 28));
+    bool ok = fwrite(header, 1, HEADER_SIZE, output) == HEADER_SIZE;
+
+    std::vector<uint8_t> stripe((k + m) * shardSize);
+    std::vector<uint8_t> crcs((k + m) * 4);
+    std::vector<const uint8_t*> data(k);
+    std::vector<uint8_t*> parity(m);
+    for (size_t j = 0; j < k; ++j) {
+        data[j] = &stripe[j * shardSize];
+    }
+    for (size_t i = 0; i < m; ++i) {
+        parity[i] = &stripe[(k + i) * shardSize];
+    }
+
+    uint64_t stripeBytes = static_cast<uint64_t>(k) * shardSize;
+    for (uint64_t offset = 0; ok && offset < fileSize; offset += stripeBytes) {
+        readPadded(input, offset, stripe.data(), k * shardSize);
+        encode(data, parity, shardSize);
+
+        for (size_t s = 0; s < k + m; ++s) {
+            putLE32(&crcs[s * 4], Utils::crc32c(&stripe[s * shardSize], shardSize));
+        }
+        ok = fwrite(crcs.data(), 1, crcs.size(), output) == crcs.size() &&
+             fwrite(parity[0], 1, m * shardSize, output) == m * shardSize;
+    }
+
+    ok = ok && !ferror(input);
+    fclose(input);
+    ok = fclose(output) == 0 && ok;
+
+    if (!ok) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return std::rename(tempPath.c_str(), parityPath.c_str()) == 0;
+}
+
+ErasureCoder::RepairResult ErasureCoder::repairFile(const std::string& filePath, const std::string& parityPath) {
+    RepairResult result;
+
+    FILE* parityFile = fopen(parityPath.c_str(), "rb");
+    if (!parityFile) {
+        result.error = "No parity file";
+        return result;
+    }
+    result.parityFound = true;
+
+    uint8_t header[HEADER_SIZE];
+    if (fread(header, 1, HEADER_SIZE, parityFile) != HEADER_SIZE ||
+        std::memcmp(header, PARITY_MAGIC, 4) != 0 || header[4] != PARITY_VERSION ||
+        getLE32(header + 28) != Utils::crc32c(header, 28)) {
+        fclose(parityFile);
+        result.error = "Parity header is damaged";
+        return result;
+    }
+
+    const size_t k = header[5];
+    const size_t m = header[6];
+    const size_t shardSize = getLE32(header + 8);
+    const uint64_t fileSize = getLE64(header + 16);
+    if (k == 0 || m == 0 || shardSize == 0) {
+        fclose(parityFile);
+        result.error = "Parity header is damaged";
+        return result;
+    }
+    ErasureCoder coder(k, m);
+
+    FILE* file = fopen(filePath.c_str(), "r+b");
+    if (!file && m >= k) {
+        file = fopen(filePath.c_str(), "w+b"); // Enough parity to rebuild a lost file outright
+    }
+    if (!file) {
+        fclose(parityFile);
+        result.damaged = true;
+        result.error = "Cannot open file: " + Utils::getLastErrorMessage();
+        return result;
+    }
+
+    std::vector<uint8_t> stripe((k + m) * shardSize);
+    std::vector<uint8_t> crcs((k + m) * 4);
+    std::vector<uint8_t*> shards(k + m);
+    for (size_t s = 0; s < k + m; ++s) {
+        shards[s] = &stripe[s * shardSize];
+    }
+
+    uint64_t stripeBytes = static_cast<uint64_t>(k) * shardSize;
+    for (uint64_t offset = 0; offset < fileSize; offset += stripeBytes) {
+        readPadded(file, offset, stripe.data(), k * shardSize);
+        if (fread(crcs.data(), 1, crcs.size(), parityFile) != crcs.size() ||
+            fread(shards[k], 1, m * shardSize, parityFile) != m * shardSize) {
+            result.damaged = true;
+            result.stripesUnrecoverable++;
+            result.error = "Parity file is truncated";
+            break;
+        }
+
+        std::vector<bool> present(k + m);
+        size_t badData = 0;
+        for (size_t s = 0; s < k + m; ++s) {
+            present[s] = Utils::crc32c(shards[s], shardSize) == getLE32(&crcs[s * 4]);
+            if (s < k && !present[s]) {
+                badData++;
+            }
+        }
+        if (badData == 0) {
+            continue;
+        }
+
+        result.damaged = true;
+        if (!coder.reconstruct(shards, present, shardSize)) {
+            result.stripesUnrecoverable++;
+            continue;
+        }
+
+        // Write back only the rebuilt shards, clipped to the original file length
+        for (size_t j = 0; j < k; ++j) {
+            uint64_t shardOffset = offset + static_cast<uint64_t>(j) * shardSize;
+            if (present[j] || shardOffset >= fileSize) {
+                continue;
+            }
+            size_t length = static_cast<size_t>(std::min<uint64_t>(shardSize, fileSize - shardOffset));
+            if (fseeko(file, static_cast<off_t>(shardOffset), SEEK_SET) != 0 ||
+                fwrite(shards[j], 1, length, file) != length) {
+                result.stripesUnrecoverable++;
+                result.error = "Cannot write repaired data";
+                break;
+            }
+            result.shardsRepaired++;
+        }
+    }
+
+    // Trailing garbage beyond the protected length is damage too
+    fflush(file);
+    if (Utils::getFileSize(filePath) > fileSize) {
+        result.damaged = true;
+        if (ftruncate(fileno(file), static_cast<off_t>(fileSize)) != 0) {
+            result.stripesUnrecoverable++;
+        }
+    }
+
+    bool writeOk = fclose(file) == 0;
+    fclose(parityFile);
+
+    result.repaired = result.damaged && result.stripesUnrecoverable == 0 && writeOk;
+    return result;
+}
+
+std::string ErasureCoder::parityPath(const std::string& backupPath, const std::string& relativePath) {
+    return Utils::joinPaths(Utils::joinPaths(backupPath, PARITY_DIRECTORY), relativePath + ".par");
+}
+
+std::string ErasureCoder::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::AUTO: return "auto";
+        case Kernel::SCALAR: return "scalar";
+        case Kernel::SSSE3: return "ssse3";
+        case Kernel::AVX2: return "avx2";
+        default: return "unknown";
+    }
+}
+
+bool ErasureCoder::isKernelSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::AUTO:
+        case Kernel::SCALAR:
+            return true;
+#if defined(__x86_64__)
+        case Kernel::SSSE3:
+            return __builtin_cpu_supports("ssse3");
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+bool ErasureCoder::parseLayout(const std::string& layout, size_t& dataShards, size_t& parityShards) {
+    size_t plus = layout.find('+');
+    if (plus == std::string::npos) {
+        return false;
+    }
+
+    try {
+        dataShards = std::stoul(layout.substr(0, plus));
+        parityShards = std::stoul(layout.substr(plus + 1));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return dataShards > 0 && parityShards > 0 && dataShards + parityShards <= MAX_SHARDS;
+}
+
+void ErasureCoder::mulAdd(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t length) const {
+    if (coefficient == 0) {
+        return;
+    }
+
+    switch (kernel_) {
+#if defined(__x86_64__)
+        case Kernel::AVX2:
+            mulAddAvx2(dst, src, coefficient, length);
+            return;
+        case Kernel::SSSE3:
+            mulAddSsse3(dst, src, coefficient, length);
+            return;
+#endif
+        default:
+            mulAddScalar(dst, src, coefficient, length);
+            return;
+    }
+}
+
+bool ErasureCoder::invertMatrix(std::vector<uint8_t>& matrix, size_t n) const {
+    // Gauss-Jordan elimination on [matrix | identity]
+    std::vector<uint8_t> inverse(n * n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        inverse[i * n + i] = 1;
+    }
+
+    for (size_t col = 0; col < n; ++col) {
+        size_t pivot = col;
+        while (pivot < n && matrix[pivot * n + col] == 0) {
+            pivot++;
+        }
+        if (pivot == n) {
+            return false;
+        }
+        if (pivot != col) {
+            for (size_t c = 0; c < n; ++c) {
+                std::swap(matrix[pivot * n + c], matrix[col * n + c]);
+                std::swap(inverse[pivot * n + c], inverse[col * n + c]);
+            }
+        }
+
+        uint8_t scale = GF.inverse(matrix[col * n + col]);
+        for (size_t c = 0; c < n; ++c) {
+            matrix[col * n + c] = GF.mul[scale][matrix[col * n + c]];
+            inverse[col * n + c] = GF.mul[scale][inverse[col * n + c]];
+        }
+
+        for (size_t row = 0; row < n; ++row) {
+            uint8_t factor = matrix[row * n + col];
+            if (row == col || factor == 0) {
+                continue;
+            }
+            for (size_t c = 0; c < n; ++c) {
+                matrix[row * n + c] ^= GF.mul[factor][matrix[col * n + c]];
+                inverse[row * n + c] ^= GF.mul[factor][inverse[col * n + c]];
+            }
+        }
+    }
+
+    matrix.swap(inverse);
+    return true;
+}
@@ -1,21 +1,54 @@
 #include "FileTracker.h"
 #include "Utils.h"
+#include "IoThrottle.h"
+#include "IoScheduler.h"
+#include "MemoryBudget.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
 #include <nlohmann/json.hpp>
+#include <sys/stat.h>
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
+namespace {
+
+// Rough heap footprint of one state entry: hash node, key, and the path the value repeats
+std::uint64_t entryBytes(const std::string& path) {
+    std::uint64_t heap = path.size() > 15 ? path.size() + 1 : 0;
+    return sizeof(std::string) + sizeof(FileTracker::FileInfo) + 2 * heap + 4 * sizeof(void*);
+}
+
+} // namespace
+
 FileTracker::FileTracker() = default;
 
-FileTracker::~FileTracker() = default;
+FileTracker::~FileTracker() {
+    MemoryBudget::instance().uncharge(chargedBytes_);
+}
 
 bool FileTracker::scanDirectory(const std::string& path) {
+    return scan(path, false);
+}
+
+bool FileTracker::rescanDirectory(const std::string& path) {
+    return scan(path, true);
+}
+
+bool FileTracker::scan(const std::string& path, bool reuseChecksums) {
     try {
         currentState_.clear();
-        scanDirectoryRecursive(path);
+        scanDirectoryRecursive(path, reuseChecksums);
+        
+        currentDirectories_ = DirectoryIndex();
+        currentDirectories_.root = path;
+        while (currentDirectories_.root.size() > 1 && currentDirectories_.root.back() == fs::path::preferred_separator) {
+            currentDirectories_.root.pop_back();
+        }
+        buildDirectoryIndex(currentState_, currentDirectories_);
+        chargeState();
         return true;
     } catch (const std::exception& e) {
         std::cerr << "Error scanning directory: " << e.what() << std::endl;
@@ -23,41 +56,85 @@ bool FileTracker::scanDirectory(const std::string& path) {
     }
 }
 
-void FileTracker::scanDirectoryRecursive(const std::string& path) {
+void FileTracker::scanDirectoryRecursive(const std::string& path, bool reuseChecksums) {
+    std::vector<std::string> toHash;
     for (const auto& entry : fs::recursive_directory_iterator(path)) {
         try {
-            FileInfo info = createFileInfo(entry);
+            FileInfo info = createFileInfo(entry, reuseChecksums);
+            if (!info.isDirectory && info.checksum.empty()) {
+                toHash.push_back(info.path);
+            }
             currentState_[info.path] = info;
         } catch (const std::exception& e) {
             std::cerr << "Error processing file " << entry.path() << ": " << e.what() << std::endl;
         }
     }
+    
+    // Contents are read in a second pass, so a rotational source is read in on-disk order
+    ReadOrder::arrange(toHash, readOrder_);
+    for (const auto& filePath : toHash) {
+        FileInfo& info = currentState_[filePath];
+        try {
+            IoScheduler::setCurrentFile(info.size);
+            info.checksum = calculateFileChecksum(filePath);
+        } catch (const std::exception& e) {
+            std::cerr << "Error processing file " << filePath << ": " << e.what() << std::endl;
+            currentState_.erase(filePath);
+        }
+    }
 }
 
-FileTracker::FileInfo FileTracker::createFileInfo(const fs::directory_entry& entry) {
+FileTracker::FileInfo FileTracker::createFileInfo(const fs::directory_entry& entry, bool reuseChecksums) {
     FileInfo info;
     info.path = entry.path().string();
     info.isDirectory = entry.is_directory();
     
+    struct stat st;
+    if (::stat(info.path.c_str(), &st) == 0) {
+        info.device = static_cast<std::uint64_t>(st.st_dev);
+    }
+    
     if (!info.isDirectory) {
         info.size = entry.file_size();
         info.lastModified = Utils::getFileModificationTime(info.path);
-        info.checksum = calculateFileChecksum(info.path);
+        
+        // Unchanged size and mtime: trust the previous checksum instead of rereading the file;
+        // anything else is left empty for the hashing pass
+        auto previous = reuseChecksums ? previousState_.find(info.path) : previousState_.end();
+        if (previous != previousState_.end() && !previous->second.isDirectory &&
+            !previous->second.checksum.empty() && previous->second.size == info.size &&
+            std::chrono::time_point_cast<std::chrono::seconds>(previous->second.lastModified) ==
+            std::chrono::time_point_cast<std::chrono::seconds>(info.lastModified)) {
+            info.checksum = previous->second.checksum;
+        }
     } else {
         info.size = 0;
         info.lastModified = Utils::getFileModificationTime(info.path);
-        info.checksum = "";
+        info.checksum = Digest();
     }
     
     return info;
 }
 
 bool FileTracker::loadPreviousState(const std::string& stateFile) {
+    if (!Utils::pathExists(stateFile)) {
+        return true; // No previous state is OK
+    }
+    
+    bool loaded = readStateFile(stateFile, previousState_, previousDirectories_);
+    chargeState();
+    return loaded;
+}
+
+bool FileTracker::loadCurrentState(const std::string& stateFile) {
+    bool loaded = readStateFile(stateFile, currentState_, currentDirectories_);
+    chargeState();
+    return loaded;
+}
+
+bool FileTracker::readStateFile(const std::string& stateFile, std::unordered_map<std::string, FileInfo>& files,
+                                DirectoryIndex& index, size_t depth) {
     try {
-        if (!Utils::pathExists(stateFile)) {
-            return true; // No previous state is OK
-        }
-        
         std::ifstream file(stateFile);
         if (!file.is_open()) {
             return false;
@@ -66,22 +143,61 @@ bool FileTracker::loadPreviousState(const std::string& stateFile) {
         json j;
         file >> j;
         
-        previousState_.clear();
+        files.clear();
+        index = DirectoryIndex();
+        
+        // Delta files hold only changes on top of an older state file
+        if (j.contains("base")) {
+            if (depth >= 10000) {
+                std::cerr << "Error loading state: delta chain too long at " << stateFile << std::endl;
+                return false;
+            }
+            std::string basePath = (fs::path(stateFile).parent_path() / j["base"].get<std::string>()).string();
+            if (!Utils::pathExists(basePath)) {
+                std::cerr << "Error loading state: " << stateFile << " is a delta on " << basePath
+                          << ", which no longer exists" << std::endl;
+                return false;
+            }
+            if (!readStateFile(basePath, files, index, depth + 1)) {
+                return false;
+            }
+            for (const auto& deleted : j["deleted"]) {
+                files.erase(deleted.get<std::string>());
+                index.digests.erase(deleted.get<std::string>());
+            }
+        }
         
         for (const auto& item : j["files"]) {
-            FileInfo info;
-            info.path = item["path"];
-            info.size = item["size"];
-            info.isDirectory = item["isDirectory"];
-            info.checksum = item["checksum"];
-            
-            // Parse timestamp
-            std::string timestamp = item["lastModified"];
-            info.lastModified = Utils::parseTimestamp(timestamp);
-            
-            previousState_[info.path] = info;
+            FileInfo info = fileInfoFromJson(item);
+            files[info.path] = info;
         }
         
+        if (j.contains("root")) {
+            index.root = j["root"].get<std::string>();
+        } else {
+            // Older state files: the shallowest entry sits directly under the root
+            size_t shallowest = std::string::npos;
+            for (const auto& pair : files) {
+                fs::path path(pair.first);
+                size_t entryDepth = std::distance(path.begin(), path.end());
+                if (entryDepth < shallowest) {
+                    shallowest = entryDepth;
+                    index.root = path.parent_path().string();
+                }
+            }
+        }
+        
+        // Recorded digests save rehashing; anything missing is recomputed from the entries
+        if (j.contains("directories")) {
+            for (const auto& item : j["directories"].items()) {
+                Digest digest = Digest::fromHex(item.value().get<std::string>());
+                if (!digest.empty()) {
+                    index.digests[item.key()] = digest;
+                }
+            }
+        }
+        buildDirectoryIndex(files, index);
+        
         return true;
         
     } catch (const std::exception& e) {
@@ -91,22 +207,76 @@ bool FileTracker::loadPreviousState(const std::string& stateFile) {
 }
 
 bool FileTracker::saveDatabaseState(const std::string& stateFile) {
+    try {
+        json header;
+        header["version"] = "1.0";
+        header["timestamp"] = Utils::formatTimestamp(std::chrono::system_clock::now());
+        header["root"] = currentDirectories_.root;
+        
+        std::ofstream file(stateFile);
+        if (!file.is_open()) {
+            return false;
+        }
+        
+        // Streamed entry by entry rather than built as one DOM next to currentState_
+        std::string opening = header.dump();
+        opening.pop_back();
+        file << opening << ",\"files\":[";
+        bool first = true;
+        for (const auto& pair : currentState_) {
+            file << (first ? "\n" : ",\n") << fileInfoToJson(pair.second).dump();
+            first = false;
+        }
+        
+        file << "],\"directories\":{";
+        first = true;
+        for (const auto& pair : currentDirectories_.digests) {
+            file << (first ? "\n" : ",\n") << json(pair.first).dump() << ":\"" << pair.second.toHex() << "\"";
+            first = false;
+        }
+        file << "}}\n";
+        return static_cast<bool>(file.flush());
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error saving state: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool FileTracker::saveDatabaseDelta(const std::string& stateFile, const std::string& baseStateFile) {
+    // A delta on a missing base could never be loaded; the caller writes a snapshot instead
+    if (!Utils::pathExists(baseStateFile)) {
+        return false;
+    }
+    
     try {
         json j;
-        j["version"] = "1.0";
+        j["version"] = "2.0";
         j["timestamp"] = Utils::formatTimestamp(std::chrono::system_clock::now());
+        j["root"] = currentDirectories_.root;
+        j["base"] = fs::path(baseStateFile).lexically_relative(fs::path(stateFile).parent_path()).string();
         j["files"] = json::array();
+        j["deleted"] = json::array();
         
+        // Full entries for new or changed paths, bare paths for removed ones
         for (const auto& pair : currentState_) {
-            const FileInfo& info = pair.second;
-            json fileObj;
-            fileObj["path"] = info.path;
-            fileObj["size"] = info.size;
-            fileObj["isDirectory"] = info.isDirectory;
-            fileObj["checksum"] = info.checksum;
-            fileObj["lastModified"] = Utils::formatTimestamp(info.lastModified);
-            
-            j["files"].push_back(fileObj);
+            auto previous = previousState_.find(pair.first);
+            if (previous == previousState_.end() || !compareFileInfo(pair.second, previous->second)) {
+                j["files"].push_back(fileInfoToJson(pair.second));
+            }
+        }
+        for (const auto& pair : previousState_) {
+            if (currentState_.find(pair.first) == currentState_.end()) {
+                j["deleted"].push_back(pair.first);
+            }
+        }
+        
+        j["directories"] = json::object();
+        for (const auto& pair : currentDirectories_.digests) {
+            auto previous = previousDirectories_.digests.find(pair.first);
+            if (previous == previousDirectories_.digests.end() || previous->second != pair.second) {
+                j["directories"][pair.first] = pair.second.toHex();
+            }
         }
         
         std::ofstream file(stateFile);
@@ -115,83 +285,147 @@ bool FileTracker::saveDatabaseState(const std::string& stateFile) {
         }
         
         file << j.dump(2);
-        return true;
+        return static_cast<bool>(file.flush());
         
     } catch (const std::exception& e) {
-        std::cerr << "Error saving state: " << e.what() << std::endl;
+        std::cerr << "Error saving state delta: " << e.what() << std::endl;
         return false;
     }
 }
 
-std::vector<std::string> FileTracker::getChangedFiles() {
-    std::vector<std::string> changed;
+void FileTracker::commitCurrentState() {
+    previousState_ = currentState_;
+    previousDirectories_ = currentDirectories_;
+    chargeState();
+}
+
+json FileTracker::fileInfoToJson(const FileInfo& info) {
+    json fileObj;
+    fileObj["path"] = info.path;
+    fileObj["size"] = info.size;
+    fileObj["isDirectory"] = info.isDirectory;
+    fileObj["checksum"] = info.checksum.toHex();
+    fileObj["lastModified"] = Utils::formatTimestamp(info.lastModified);
+    return fileObj;
+}
+
+FileTracker::FileInfo FileTracker::fileInfoFromJson(const json& item) {
+    FileInfo info;
+    info.path = item["path"];
+    info.size = item["size"];
+    info.isDirectory = item["isDirectory"];
+    info.checksum = Digest::fromHex(item["checksum"].get<std::string>());
     
-    // Find new and modified files
-    for (const auto& pair : currentState_) {
-        const std::string& path = pair.first;
-        const FileInfo& currentInfo = pair.second;
-        
-        auto it = previousState_.find(path);
-        if (it == previousState_.end()) {
-            // New file
-            changed.push_back(path);
+    // Parse timestamp
+    std::string timestamp = item["lastModified"];
+    info.lastModified = Utils::parseTimestamp(timestamp);
+    return info;
+}
+
+FileTracker::StateDiff FileTracker::diffStates() const {
+    StateDiff diff;
+    diffDirectory(currentDirectories_.root, previousDirectories_.root, "", diff);
+    
+    std::sort(diff.added.begin(), diff.added.end());
+    std::sort(diff.modified.begin(), diff.modified.end());
+    std::sort(diff.deleted.begin(), diff.deleted.end());
+    return diff;
+}
+
+void FileTracker::diffDirectory(const std::string& currentPath, const std::string& previousPath,
+                                const std::string& relativePath, StateDiff& diff) const {
+    auto currentDigest = currentDirectories_.digests.find(currentPath);
+    auto previousDigest = previousDirectories_.digests.find(previousPath);
+    bool inCurrent = !currentPath.empty() && currentDigest != currentDirectories_.digests.end();
+    bool inPrevious = !previousPath.empty() && previousDigest != previousDirectories_.digests.end();
+    
+    if (inCurrent && inPrevious && currentDigest->second == previousDigest->second) {
+        diff.directoriesSkipped++;
+        return;
+    }
+    diff.directoriesVisited++;
+    
+    static const std::vector<std::string> noChildren;
+    auto currentChildren = inCurrent ? currentDirectories_.children.find(currentPath) : currentDirectories_.children.end();
+    auto previousChildren = inPrevious ? previousDirectories_.children.find(previousPath) : previousDirectories_.children.end();
+    const auto& currentNames = currentChildren != currentDirectories_.children.end() ? currentChildren->second : noChildren;
+    const auto& previousNames = previousChildren != previousDirectories_.children.end() ? previousChildren->second : noChildren;
+    
+    // Both child lists are sorted, so walk them together
+    auto a = currentNames.begin();
+    auto b = previousNames.begin();
+    while (a != currentNames.end() || b != previousNames.end()) {
+        std::string name;
+        bool hasCurrent = false;
+        bool hasPrevious = false;
+        if (b == previousNames.end() || (a != currentNames.end() && *a < *b)) {
+            name = *a++;
+            hasCurrent = true;
+        } else if (a == currentNames.end() || *b < *a) {
+            name = *b++;
+            hasPrevious = true;
         } else {
-            // Check if modified
-            const FileInfo& previousInfo = it->second;
-            if (!compareFileInfo(currentInfo, previousInfo)) {
-                changed.push_back(path);
+            name = *a++;
+            ++b;
+            hasCurrent = hasPrevious = true;
+        }
+        
+        std::string relative = relativePath.empty() ? name : relativePath + "/" + name;
+        const FileInfo* current = hasCurrent ? &currentState_.at(childPath(currentPath, name)) : nullptr;
+        const FileInfo* previous = hasPrevious ? &previousState_.at(childPath(previousPath, name)) : nullptr;
+        
+        if (current && previous && current->isDirectory == previous->isDirectory) {
+            if (current->isDirectory) {
+                diffDirectory(current->path, previous->path, relative, diff);
+            } else if (!compareFileInfo(*current, *previous)) {
+                diff.modified.push_back(relative);
+            }
+            continue;
+        }
+        
+        // Added, removed, or replaced by an entry of the other kind
+        if (previous) {
+            diff.deleted.push_back(relative);
+            if (previous->isDirectory) {
+                diffDirectory("", previous->path, relative, diff);
+            }
+        }
+        if (current) {
+            diff.added.push_back(relative);
+            if (current->isDirectory) {
+                diffDirectory(current->path, "", relative, diff);
             }
         }
     }
+}
+
+std::vector<std::string> FileTracker::getChangedFiles() {
+    StateDiff diff = diffStates();
+    
+    // Find new and modified files
+    std::vector<std::string> changed = toCurrentPaths(diff.added);
+    std::vector<std::string> modified = toCurrentPaths(diff.modified);
+    changed.insert(changed.end(), modified.begin(), modified.end());
     
     return changed;
 }
 
 std::vector<std::string> FileTracker::getNewFiles() {
-    std::vector<std::string> newFiles;
-    
-    for (const auto& pair : currentState_) {
-        const std::string& path = pair.first;
-        
-        if (previousState_.find(path) == previousState_.end()) {
-            newFiles.push_back(path);
-        }
-    }
-    
-    return newFiles;
+    return toCurrentPaths(diffStates().added);
 }
 
 std::vector<std::string> FileTracker::getDeletedFiles() {
     std::vector<std::string> deletedFiles;
     
-    for (const auto& pair : previousState_) {
-        const std::string& path = pair.first;
-        
-        if (currentState_.find(path) == currentState_.end()) {
-            deletedFiles.push_back(path);
-        }
+    for (const auto& relative : diffStates().deleted) {
+        deletedFiles.push_back(childPath(previousDirectories_.root, relative));
     }
     
     return deletedFiles;
 }
 
 std::vector<std::string> FileTracker::getModifiedFiles() {
-    std::vector<std::string> modifiedFiles;
-    
-    for (const auto& pair : currentState_) {
-        const std::string& path = pair.first;
-        const FileInfo& currentInfo = pair.second;
-        
-        auto it = previousState_.find(path);
-        if (it != previousState_.end()) {
-            const FileInfo& previousInfo = it->second;
-            if (!compareFileInfo(currentInfo, previousInfo)) {
-                modifiedFiles.push_back(path);
-            }
-        }
-    }
-    
-    return modifiedFiles;
+    return toCurrentPaths(diffStates().modified);
 }
 
 bool FileTracker::hasFileChanged(const std::string& filePath) {
@@ -221,25 +455,60 @@ FileTracker::FileInfo FileTracker::getFileInfo(const std::string& filePath) {
     empty.size = 0;
     empty.isDirectory = false;
     empty.lastModified = std::chrono::system_clock::now();
-    empty.checksum = "";
+    empty.checksum = Digest();
     return empty;
 }
 
-std::string FileTracker::calculateFileChecksum(const std::string& filePath) {
-    return Utils::calculateSHA256(filePath);
+Digest FileTracker::calculateFileChecksum(const std::string& filePath) {
+    return calculateChecksumSHA256(filePath);
+}
+
+Digest FileTracker::getDirectoryDigest(const std::string& directoryPath) const {
+    auto it = currentDirectories_.digests.find(directoryPath);
+    return it != currentDirectories_.digests.end() ? it->second : Digest();
 }
 
 void FileTracker::updateFileInfo(const std::string& filePath, const FileInfo& info) {
     currentState_[filePath] = info;
+    currentDirectories_.digests.clear();
+    buildDirectoryIndex(currentState_, currentDirectories_);
 }
 
 void FileTracker::removeFile(const std::string& filePath) {
     currentState_.erase(filePath);
+    currentDirectories_.digests.clear();
+    buildDirectoryIndex(currentState_, currentDirectories_);
+}
+
+void FileTracker::chargeState() {
+    // Both states and their directory indexes stay resident, so they count against the budget
+    std::uint64_t bytes = 0;
+    for (const auto* state : {&currentState_, &previousState_}) {
+        for (const auto& pair : *state) {
+            bytes += entryBytes(pair.first);
+        }
+    }
+    for (const auto* index : {&currentDirectories_, &previousDirectories_}) {
+        for (const auto& pair : index->digests) {
+            bytes += entryBytes(pair.first);
+        }
+    }
+    
+    MemoryBudget& budget = MemoryBudget::instance();
+    if (bytes > chargedBytes_) {
+        budget.charge(bytes - chargedBytes_);
+    } else {
+        budget.uncharge(chargedBytes_ - bytes);
+    }
+    chargedBytes_ = bytes;
 }
 
 void FileTracker::clear() {
     currentState_.clear();
     previousState_.clear();
+    currentDirectories_ = DirectoryIndex();
+    previousDirectories_ = DirectoryIndex();
+    chargeState();
 }
 
 size_t FileTracker::getTotalFiles() const {
@@ -247,26 +516,8 @@ size_t FileTracker::getTotalFiles() const {
 }
 
 size_t FileTracker::getChangedFilesCount() const {
-    size_t count = 0;
-    
-    for (const auto& pair : currentState_) {
-        const std::string& path = pair.first;
-        const FileInfo& currentInfo = pair.second;
-        
-        auto it = previousState_.find(path);
-        if (it == previousState_.end()) {
-            // New file
-            count++;
-        } else {
-            // Check if modified
-            const FileInfo& previousInfo = it->second;
-            if (!compareFileInfo(currentInfo, previousInfo)) {
-                count++;
-            }
-        }
-    }
-    
-    return count;
+    StateDiff diff = diffStates();
+    return diff.added.size() + diff.modified.size();
 }
 
 size_t FileTracker::getTotalSize() const {
@@ -287,8 +538,9 @@ bool FileTracker::compareFileInfo(const FileInfo& current, const FileInfo& previ
         return false;
     }
     
-    // Compare modification time
-    if (current.lastModified != previous.lastModified) {
+    // Compare modification time at the precision the state file keeps
+    if (std::chrono::time_point_cast<std::chrono::seconds>(current.lastModified) !=
+        std::chrono::time_point_cast<std::chrono::seconds>(previous.lastModified)) {
         return false;
     }
     
@@ -301,6 +553,84 @@ bool FileTracker::compareFileInfo(const FileInfo& current, const FileInfo& previ
     return current.checksum == previous.checksum;
 }
 
-std::string FileTracker::calculateChecksumSHA256(const std::string& filePath) {
-    return Utils::calculateSHA256(filePath);
+Digest FileTracker::calculateChecksumSHA256(const std::string& filePath) {
+    if (!ioThrottle_) {
+        return Utils::calculateSHA256(filePath);
+    }
+    return Utils::calculateSHA256(filePath, [this](size_t bytes) { ioThrottle_->read(bytes); });
+}
+
+void FileTracker::setIoThrottle(IoThrottle* throttle) {
+    ioThrottle_ = throttle;
+}
+
+void FileTracker::setReadOrder(ReadOrder::Mode mode) {
+    readOrder_ = mode;
+}
+
+std::vector<std::string> FileTracker::toCurrentPaths(const std::vector<std::string>& relativePaths) const {
+    std::vector<std::string> paths;
+    paths.reserve(relativePaths.size());
+    for (const auto& relative : relativePaths) {
+        paths.push_back(childPath(currentDirectories_.root, relative));
+    }
+    return paths;
+}
+
+void FileTracker::buildDirectoryIndex(const std::unordered_map<std::string, FileInfo>& files, DirectoryIndex& index) {
+    index.children.clear();
+    index.children[index.root];
+    
+    for (const auto& pair : files) {
+        fs::path path(pair.first);
+        index.children[path.parent_path().string()].push_back(path.filename().string());
+    }
+    for (auto& pair : index.children) {
+        std::sort(pair.second.begin(), pair.second.end());
+    }
+    
+    // Longer paths first so every subdirectory is hashed before its parent
+    std::vector<std::string> directories;
+    directories.push_back(index.root);
+    for (const auto& pair : files) {
+        if (pair.second.isDirectory) {
+            directories.push_back(pair.first);
+        }
+    }
+    std::sort(directories.begin(), directories.end(), [](const std::string& a, const std::string& b) {
+        return a.size() > b.size();
+    });
+    
+    DigestBuilder builder;
+    for (const auto& directory : directories) {
+        if (index.digests.count(directory)) {
+            continue;
+        }
+        
+        for (const auto& name : index.children[directory]) {
+            const FileInfo& child = files.at(childPath(directory, name));
+            uint8_t kind = child.isDirectory ? 'd' : 'f';
+            uint64_t nameLength = name.size();
+            builder.update(&kind, 1);
+            builder.update(&nameLength, sizeof(nameLength));
+            builder.update(name.data(), name.size());
+            
+            if (child.isDirectory) {
+                const Digest& digest = index.digests[child.path];
+                builder.update(digest.data(), digest.size());
+            } else {
+                uint64_t size = child.size;
+                int64_t mtime = std::chrono::duration_cast<std::chrono::seconds>(
+                    child.lastModified.time_since_epoch()).count();
+                builder.update(&size, sizeof(size));
+                builder.update(&mtime, sizeof(mtime));
+                builder.update(child.checksum.data(), child.checksum.size());
+            }
+        }
+        index.digests[directory] = builder.finish();
+    }
+}
+
+std::string FileTracker::childPath(const std::string& directory, const std::string& name) {
+    return (fs::path(directory) / name).string();
 }
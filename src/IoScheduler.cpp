@@ -0,0 +1,185 @@
+#include "IoScheduler.h"
+#include <algorithm>
+#include <limits>
+
+struct IoScheduler::Job {
+    IoScheduler* scheduler = nullptr;
+    std::string name;
+    unsigned int weight = 100;
+    int priority = 0;
+    size_t scopes = 0;
+    double virtualTime = 0.0;               // Bytes moved, scaled by 100 / weight
+    std::chrono::steady_clock::time_point lastActive;
+    JobStats stats;
+    std::chrono::steady_clock::time_point windowStart;
+    std::uintmax_t windowBytes = 0;
+};
+
+namespace {
+
+constexpr std::chrono::seconds RATE_WINDOW{2};
+constexpr std::chrono::milliseconds RECHECK_INTERVAL{10};
+
+thread_local std::shared_ptr<IoScheduler::Job> currentJob;
+thread_local std::uintmax_t currentFileSize = std::numeric_limits<std::uintmax_t>::max();
+
+} // namespace
+
+IoScheduler::JobScope::JobScope(IoScheduler& scheduler, const std::string& name, unsigned int weight, int priority)
+    : scheduler_(scheduler)
+    , job_(scheduler.attach(name, weight, priority))
+    , previous_(currentJob) {
+    currentJob = job_;
+}
+
+IoScheduler::JobScope::~JobScope() {
+    currentJob = previous_;
+    scheduler_.detach(job_);
+}
+
+IoScheduler::IoScheduler()
+    : IoScheduler(Options()) {
+}
+
+IoScheduler::IoScheduler(const Options& options)
+    : options_(options) {
+}
+
+IoScheduler::~IoScheduler() = default;
+
+void IoScheduler::charge(size_t bytes, bool write) {
+    std::shared_ptr<Job> job = currentJob;
+    if (!job || bytes == 0) {
+        return;
+    }
+
+    IoScheduler& scheduler = *job->scheduler;
+    std::unique_lock<std::mutex> lock(scheduler.mutex_);
+    scheduler.account(*job, bytes, write);
+    scheduler.turn_.notify_all();
+
+    if (currentFileSize <= scheduler.options_.smallFileBytes) {
+        return;     // Latency protection for metadata and small files
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + scheduler.options_.maxWait;
+    auto now = start;
+    while (now < deadline && scheduler.mustWait(*job, now)) {
+        scheduler.turn_.wait_until(lock, std::min(deadline, now + RECHECK_INTERVAL));
+        now = std::chrono::steady_clock::now();
+        job->lastActive = now;  // Still backlogged while held back
+    }
+    job->stats.waitSeconds += std::chrono::duration<double>(now - start).count();
+}
+
+void IoScheduler::setCurrentFile(std::uintmax_t size) {
+    currentFileSize = size;
+}
+
+bool IoScheduler::hasConcurrentJobs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t running = 0;
+    for (const auto& pair : jobs_) {
+        if (pair.second->scopes > 0 && ++running > 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<IoScheduler::JobStats> IoScheduler::getJobStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+
+    std::vector<JobStats> stats;
+    for (const auto& pair : jobs_) {
+        JobStats job = pair.second->stats;
+        job.active = isActive(*pair.second, now);
+        if (!job.active) {
+            job.bytesPerSecond = 0.0;
+        }
+        stats.push_back(job);
+    }
+    return stats;
+}
+
+std::shared_ptr<IoScheduler::Job> IoScheduler::attach(const std::string& name, unsigned int weight, int priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& job = jobs_[name];
+    if (!job) {
+        job = std::make_shared<Job>();
+        job->scheduler = this;
+        job->name = name;
+        job->stats.name = name;
+    }
+
+    job->weight = std::max(1u, weight);
+    job->priority = priority;
+    job->stats.weight = job->weight;
+    job->stats.priority = priority;
+    job->scopes++;
+    return job;
+}
+
+void IoScheduler::detach(const std::shared_ptr<Job>& job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->scopes--;
+    }
+    turn_.notify_all();
+}
+
+void IoScheduler::account(Job& job, size_t bytes, bool write) {
+    auto now = std::chrono::steady_clock::now();
+
+    // A job returning from idle starts level with the others rather than cashing in its absence
+    if (!isActive(job, now)) {
+        double floor = std::numeric_limits<double>::max();
+        for (const auto& pair : jobs_) {
+            const Job& other = *pair.second;
+            if (&other != &job && other.priority == job.priority && isActive(other, now)) {
+                floor = std::min(floor, other.virtualTime);
+            }
+        }
+        if (floor != std::numeric_limits<double>::max()) {
+            job.virtualTime = std::max(job.virtualTime, floor);
+        }
+        job.windowStart = now;
+        job.windowBytes = 0;
+    }
+
+    job.virtualTime += static_cast<double>(bytes) * 100.0 / job.weight;
+    job.lastActive = now;
+
+    (write ? job.stats.bytesWritten : job.stats.bytesRead) += bytes;
+    job.stats.operations++;
+    job.windowBytes += bytes;
+    auto elapsed = now - job.windowStart;
+    if (elapsed >= RATE_WINDOW) {
+        job.stats.bytesPerSecond = job.windowBytes / std::chrono::duration<double>(elapsed).count();
+        job.windowStart = now;
+        job.windowBytes = 0;
+    }
+}
+
+bool IoScheduler::mustWait(const Job& job, std::chrono::steady_clock::time_point now) const {
+    double lead = static_cast<double>(options_.sliceBytes);
+    for (const auto& pair : jobs_) {
+        const Job& other = *pair.second;
+        if (&other == &job || !isActive(other, now)) {
+            continue;
+        }
+        if (other.priority > job.priority) {
+            return true;
+        }
+        if (other.priority == job.priority && job.virtualTime > other.virtualTime + lead) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IoScheduler::isActive(const Job& job, std::chrono::steady_clock::time_point now) const {
+    return job.scopes > 0 && now - job.lastActive < options_.activeWindow;
+}
@@ -0,0 +1,88 @@
+#include "IoThrottle.h"
+#include "IoScheduler.h"
+#include "Utils.h"
+#include <cctype>
+#include <sstream>
+
+IoThrottle::IoThrottle() = default;
+
+IoThrottle::~IoThrottle() = default;
+
+void IoThrottle::setLimits(const Limits& limits) {
+    readBytes_.setRate(static_cast<double>(limits.readBytesPerSecond));
+    writeBytes_.setRate(static_cast<double>(limits.writeBytesPerSecond));
+    operations_.setRate(static_cast<double>(limits.iops));
+}
+
+IoThrottle::Limits IoThrottle::getLimits() const {
+    Limits limits;
+    limits.readBytesPerSecond = static_cast<std::uintmax_t>(readBytes_.getRate());
+    limits.writeBytesPerSecond = static_cast<std::uintmax_t>(writeBytes_.getRate());
+    limits.iops = static_cast<std::uint32_t>(operations_.getRate());
+    return limits;
+}
+
+bool IoThrottle::isLimited() const {
+    return readBytes_.isLimited() || writeBytes_.isLimited() || operations_.isLimited();
+}
+
+void IoThrottle::read(size_t bytes) {
+    IoScheduler::charge(bytes, false);
+    operations_.acquire(1.0);
+    readBytes_.acquire(static_cast<double>(bytes));
+}
+
+void IoThrottle::write(size_t bytes) {
+    IoScheduler::charge(bytes, true);
+    operations_.acquire(1.0);
+    writeBytes_.acquire(static_cast<double>(bytes));
+}
+
+bool IoThrottle::parseRate(const std::string& text, std::uintmax_t& bytesPerSecond) {
+    std::string value = Utils::toLower(Utils::trim(text));
+    if (value == "off" || value == "unlimited") {
+        bytesPerSecond = 0;
+        return true;
+    }
+
+    size_t digits = 0;
+    double number = 0.0;
+    try {
+        number = std::stod(value, &digits);
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (number < 0.0) {
+        return false;
+    }
+
+    std::string suffix = value.substr(digits);
+    if (!suffix.empty() && suffix.back() == 'b') {
+        suffix.pop_back();      // "50mb" reads the same as "50m"
+    }
+    double scale = 1.0;
+    if (suffix == "k") {
+        scale = 1024.0;
+    } else if (suffix == "m") {
+        scale = 1024.0 * 1024.0;
+    } else if (suffix == "g") {
+        scale = 1024.0 * 1024.0 * 1024.0;
+    } else if (!suffix.empty()) {
+        return false;
+    }
+
+    bytesPerSecond = static_cast<std::uintmax_t>(number * scale);
+    return true;
+}
+
+std::string IoThrottle::describe(const Limits& limits) {
+    auto rate = [](std::uintmax_t bytes) {
+        return bytes > 0 ? Utils::formatBytes(bytes) + "/s" : std::string("unlimited");
+    };
+
+    std::ostringstream text;
+    text << "read " << rate(limits.readBytesPerSecond)
+         << ", write " << rate(limits.writeBytesPerSecond)
+         << ", iops " << (limits.iops > 0 ? std::to_string(limits.iops) : std::string("unlimited"));
+    return text.str();
+}
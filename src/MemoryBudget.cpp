@@ -0,0 +1,134 @@
+#include "MemoryBudget.h"
+#include <algorithm>
+#include <chrono>
+
+MemoryBudget::Reservation::~Reservation() {
+    release();
+}
+
+MemoryBudget::Reservation::Reservation(Reservation&& other) noexcept
+    : bytes_(other.bytes_) {
+    other.bytes_ = 0;
+}
+
+MemoryBudget::Reservation& MemoryBudget::Reservation::operator=(Reservation&& other) noexcept {
+    if (this != &other) {
+        release();
+        bytes_ = other.bytes_;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+void MemoryBudget::Reservation::release() {
+    if (bytes_ > 0) {
+        MemoryBudget::instance().releaseReserved(bytes_);
+        bytes_ = 0;
+    }
+}
+
+MemoryBudget::MemoryBudget()
+    : limit_(0)
+    , charged_(0)
+    , reserved_(0)
+    , peak_(0)
+    , waits_(0)
+    , waitSeconds_(0.0)
+    , spills_(0) {
+}
+
+MemoryBudget& MemoryBudget::instance() {
+    // Never destroyed, like the buffer pool that charges it
+    static MemoryBudget* budget = new MemoryBudget();
+    return *budget;
+}
+
+void MemoryBudget::setLimit(std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limit_ = bytes;
+    released_.notify_all();
+}
+
+std::uint64_t MemoryBudget::getLimit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limit_;
+}
+
+bool MemoryBudget::isLimited() const {
+    return getLimit() > 0;
+}
+
+MemoryBudget::Reservation MemoryBudget::reserve(std::uint64_t bytes) {
+    Reservation reservation;
+    if (bytes == 0) {
+        return reservation;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto fits = [&] { return limit_ == 0 || reserved_ == 0 || charged_ + reserved_ + bytes <= limit_; };
+    if (!fits()) {
+        auto waitStart = std::chrono::steady_clock::now();
+        waits_++;
+        released_.wait(lock, fits);
+        waitSeconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+    }
+    reserved_ += bytes;
+    notePeak();
+    reservation.bytes_ = bytes;
+    return reservation;
+}
+
+void MemoryBudget::charge(std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    charged_ += bytes;
+    notePeak();
+}
+
+bool MemoryBudget::tryCharge(std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (limit_ > 0 && charged_ + reserved_ + bytes > limit_) {
+        return false;
+    }
+    charged_ += bytes;
+    notePeak();
+    return true;
+}
+
+void MemoryBudget::uncharge(std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    charged_ -= std::min(bytes, charged_);
+    released_.notify_all();
+}
+
+bool MemoryBudget::overBudget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limit_ > 0 && charged_ + reserved_ > limit_;
+}
+
+void MemoryBudget::recordSpill() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    spills_++;
+}
+
+MemoryBudget::Stats MemoryBudget::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.limit = limit_;
+    stats.charged = charged_;
+    stats.reserved = reserved_;
+    stats.peak = peak_;
+    stats.waits = waits_;
+    stats.waitSeconds = waitSeconds_;
+    stats.spills = spills_;
+    return stats;
+}
+
+void MemoryBudget::releaseReserved(std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reserved_ -= std::min(bytes, reserved_);
+    released_.notify_all();
+}
+
+void MemoryBudget::notePeak() {
+    peak_ = std::max(peak_, charged_ + reserved_);
+}
@@ -0,0 +1,378 @@
+#include "MerkleTree.h"
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Domain separation so file, directory and interior hashes can never collide
+constexpr uint8_t FILE_TAG = 0x00;
+constexpr uint8_t DIRECTORY_TAG = 0x01;
+constexpr uint8_t NODE_TAG = 0x02;
+constexpr uint8_t EMPTY_TAG = 0x03;
+
+void updateLength(DigestBuilder& builder, std::uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 7; i >= 0; --i) {
+        bytes[i] = static_cast<uint8_t>(value & 0xff);
+        value >>= 8;
+    }
+    builder.update(bytes, sizeof(bytes));
+}
+
+void updateName(DigestBuilder& builder, const std::string& name) {
+    updateLength(builder, name.size());
+    builder.update(name.data(), name.size());
+}
+
+void updateDigest(DigestBuilder& builder, const Digest& digest) {
+    uint8_t algorithm = static_cast<uint8_t>(digest.algorithm());
+    builder.update(&algorithm, 1);
+    builder.update(digest.data(), digest.size());
+}
+
+} // namespace
+
+MerkleTree::MerkleTree()
+    : built_(false) {
+    clear();
+}
+
+MerkleTree::~MerkleTree() = default;
+
+void MerkleTree::addFile(const std::string& relativePath, const Digest& checksum, std::uintmax_t size) {
+    std::string path = normalizePath(relativePath);
+    if (path.empty()) {
+        return;
+    }
+
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "" : path.substr(0, slash);
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    Child& child = ensureDirectory(directory).children[name];
+    child.isDirectory = false;
+    child.checksum = checksum;
+    child.size = size;
+    built_ = false;
+}
+
+void MerkleTree::build() {
+    // Deepest directories first so every subdirectory digest is ready before its parent
+    std::vector<std::string> paths;
+    paths.reserve(directories_.size());
+    for (const auto& pair : directories_) {
+        paths.push_back(pair.first);
+    }
+    std::sort(paths.begin(), paths.end(), [](const std::string& a, const std::string& b) {
+        size_t depthA = std::count(a.begin(), a.end(), '/') + (a.empty() ? 0 : 1);
+        size_t depthB = std::count(b.begin(), b.end(), '/') + (b.empty() ? 0 : 1);
+        return depthA != depthB ? depthA > depthB : a < b;
+    });
+
+    for (const auto& path : paths) {
+        Directory& directory = directories_[path];
+        directory.digest = foldHashes(childHashes(path, directory));
+    }
+    built_ = true;
+}
+
+void MerkleTree::clear() {
+    directories_.clear();
+    directories_[""] = Directory();
+    built_ = false;
+}
+
+Digest MerkleTree::getRoot() const {
+    return getDirectoryDigest("");
+}
+
+Digest MerkleTree::getDirectoryDigest(const std::string& directory) const {
+    if (!built_) {
+        return Digest();
+    }
+    auto it = directories_.find(normalizePath(directory));
+    return it != directories_.end() ? it->second.digest : Digest();
+}
+
+std::map<std::string, Digest> MerkleTree::getDirectoryDigests() const {
+    std::map<std::string, Digest> digests;
+    if (!built_) {
+        return digests;
+    }
+    for (const auto& pair : directories_) {
+        digests[pair.first] = pair.second.digest;
+    }
+    return digests;
+}
+
+std::vector<std::string> MerkleTree::diff(const MerkleTree& other) const {
+    std::vector<std::string> differences;
+    diffDirectory(other, "", &directories_.at(""), &other.directories_.at(""), differences);
+    std::sort(differences.begin(), differences.end());
+    differences.erase(std::unique(differences.begin(), differences.end()), differences.end());
+    return differences;
+}
+
+std::vector<std::string> MerkleTree::findMismatchedDirectories(
+    const std::map<std::string, Digest>& recorded) const {
+    std::vector<std::string> mismatched;
+    if (!built_) {
+        return mismatched;
+    }
+
+    for (const auto& pair : directories_) {
+        auto it = recorded.find(pair.first);
+        if (it == recorded.end() || it->second != pair.second.digest) {
+            mismatched.push_back(pair.first);
+        }
+    }
+    for (const auto& pair : recorded) {
+        if (directories_.find(pair.first) == directories_.end()) {
+            mismatched.push_back(pair.first);
+        }
+    }
+    std::sort(mismatched.begin(), mismatched.end());
+    return mismatched;
+}
+
+bool MerkleTree::getInclusionProof(const std::string& relativePath, InclusionProof& proof) const {
+    std::string path = normalizePath(relativePath);
+    if (!built_ || path.empty()) {
+        return false;
+    }
+
+    proof.relativePath = path;
+    proof.levels.clear();
+
+    std::string current = path;
+    while (!current.empty()) {
+        size_t slash = current.rfind('/');
+        std::string parent = slash == std::string::npos ? "" : current.substr(0, slash);
+        std::string name = slash == std::string::npos ? current : current.substr(slash + 1);
+
+        auto dirIt = directories_.find(parent);
+        if (dirIt == directories_.end()) {
+            return false;
+        }
+        const Directory& directory = dirIt->second;
+        auto childIt = directory.children.find(name);
+        if (childIt == directory.children.end()) {
+            return false;
+        }
+        if (proof.levels.empty() && childIt->second.isDirectory) {
+            return false;
+        }
+
+        ProofLevel level;
+        level.name = name;
+
+        // Walk the binary tree inside the directory, recording siblings on the way up
+        std::vector<Digest> layer = childHashes(parent, directory);
+        size_t index = static_cast<size_t>(std::distance(directory.children.begin(), childIt));
+        while (layer.size() > 1) {
+            size_t sibling = index ^ 1;
+            if (sibling < layer.size()) {
+                level.steps.push_back({layer[sibling], (index & 1) != 0});
+            }
+
+            std::vector<Digest> next;
+            next.reserve((layer.size() + 1) / 2);
+            for (size_t i = 0; i < layer.size(); i += 2) {
+                next.push_back(i + 1 < layer.size() ? nodeHash(layer[i], layer[i + 1]) : layer[i]);
+            }
+            layer.swap(next);
+            index /= 2;
+        }
+
+        proof.levels.push_back(std::move(level));
+        current = parent;
+    }
+
+    return true;
+}
+
+bool MerkleTree::verifyInclusionProof(const InclusionProof& proof, const Digest& checksum,
+                                      std::uintmax_t size, const Digest& root) {
+    if (proof.levels.empty() || root.empty()) {
+        return false;
+    }
+
+    Digest hash;
+    for (size_t i = 0; i < proof.levels.size(); ++i) {
+        const ProofLevel& level = proof.levels[i];
+        hash = i == 0 ? fileHash(level.name, checksum, size) : directoryHash(level.name, hash);
+        for (const auto& step : level.steps) {
+            hash = step.siblingOnLeft ? nodeHash(step.sibling, hash) : nodeHash(hash, step.sibling);
+        }
+    }
+
+    // The path in the proof must also be the one the hashes commit to
+    std::string path;
+    for (auto it = proof.levels.rbegin(); it != proof.levels.rend(); ++it) {
+        path = joinPath(path, it->name);
+    }
+
+    return hash == root && path == normalizePath(proof.relativePath);
+}
+
+MerkleTree::Directory& MerkleTree::ensureDirectory(const std::string& path) {
+    auto it = directories_.find(path);
+    if (it != directories_.end()) {
+        return it->second;
+    }
+
+    // Register the new directory with each missing ancestor
+    std::string current = path;
+    directories_[current] = Directory();
+    while (!current.empty()) {
+        size_t slash = current.rfind('/');
+        std::string parent = slash == std::string::npos ? "" : current.substr(0, slash);
+        std::string name = slash == std::string::npos ? current : current.substr(slash + 1);
+
+        bool parentExists = directories_.find(parent) != directories_.end();
+        directories_[parent].children[name].isDirectory = true;
+        if (parentExists) {
+            break;
+        }
+        current = parent;
+    }
+
+    return directories_[path];
+}
+
+std::vector<Digest> MerkleTree::childHashes(const std::string& path, const Directory& directory) const {
+    std::vector<Digest> hashes;
+    hashes.reserve(directory.children.size());
+    for (const auto& pair : directory.children) {
+        if (pair.second.isDirectory) {
+            hashes.push_back(directoryHash(pair.first, directories_.at(joinPath(path, pair.first)).digest));
+        } else {
+            hashes.push_back(fileHash(pair.first, pair.second.checksum, pair.second.size));
+        }
+    }
+    return hashes;
+}
+
+void MerkleTree::diffDirectory(const MerkleTree& other, const std::string& path,
+                               const Directory* mine, const Directory* theirs,
+                               std::vector<std::string>& differences) const {
+    if (mine && theirs && built_ && other.built_ && mine->digest == theirs->digest) {
+        return;
+    }
+    if (!mine || !theirs) {
+        if (mine) {
+            collectFiles(path, *mine, differences);
+        } else if (theirs) {
+            other.collectFiles(path, *theirs, differences);
+        }
+        return;
+    }
+
+    // Merge the two sorted child lists
+    auto a = mine->children.begin();
+    auto b = theirs->children.begin();
+    while (a != mine->children.end() || b != theirs->children.end()) {
+        const Child* childA = nullptr;
+        const Child* childB = nullptr;
+        std::string name;
+
+        if (b == theirs->children.end() || (a != mine->children.end() && a->first < b->first)) {
+            name = a->first;
+            childA = &(a++)->second;
+        } else if (a == mine->children.end() || b->first < a->first) {
+            name = b->first;
+            childB = &(b++)->second;
+        } else {
+            name = a->first;
+            childA = &(a++)->second;
+            childB = &(b++)->second;
+        }
+
+        std::string childPath = joinPath(path, name);
+        bool dirA = childA && childA->isDirectory;
+        bool dirB = childB && childB->isDirectory;
+
+        if (dirA || dirB) {
+            const Directory* subA = dirA ? &directories_.at(childPath) : nullptr;
+            const Directory* subB = dirB ? &other.directories_.at(childPath) : nullptr;
+            diffDirectory(other, childPath, subA, subB, differences);
+        }
+
+        bool fileA = childA && !childA->isDirectory;
+        bool fileB = childB && !childB->isDirectory;
+        if (fileA != fileB ||
+            (fileA && fileB && (childA->checksum != childB->checksum || childA->size != childB->size))) {
+            differences.push_back(childPath);
+        }
+    }
+}
+
+void MerkleTree::collectFiles(const std::string& path, const Directory& directory,
+                              std::vector<std::string>& files) const {
+    for (const auto& pair : directory.children) {
+        std::string childPath = joinPath(path, pair.first);
+        if (pair.second.isDirectory) {
+            collectFiles(childPath, directories_.at(childPath), files);
+        } else {
+            files.push_back(childPath);
+        }
+    }
+}
+
+std::string MerkleTree::normalizePath(const std::string& path) {
+    std::string normalized = fs::path(path).lexically_normal().generic_string();
+    while (!normalized.empty() && normalized.back() == '/') {
+        normalized.pop_back();
+    }
+    if (normalized == ".") {
+        normalized.clear();
+    }
+    return normalized;
+}
+
+std::string MerkleTree::joinPath(const std::string& directory, const std::string& name) {
+    return directory.empty() ? name : directory + "/" + name;
+}
+
+Digest MerkleTree::fileHash(const std::string& name, const Digest& checksum, std::uintmax_t size) {
+    DigestBuilder builder;
+    builder.update(&FILE_TAG, 1);
+    updateName(builder, name);
+    updateDigest(builder, checksum);
+    updateLength(builder, size);
+    return builder.finish();
+}
+
+Digest MerkleTree::directoryHash(const std::string& name, const Digest& digest) {
+    DigestBuilder builder;
+    builder.update(&DIRECTORY_TAG, 1);
+    updateName(builder, name);
+    updateDigest(builder, digest);
+    return builder.finish();
+}
+
+Digest MerkleTree::nodeHash(const Digest& left, const Digest& right) {
+    uint8_t buffer[1 + 2 * Digest::MAX_SIZE];
+    buffer[0] = NODE_TAG;
+    std::memcpy(buffer + 1, left.data(), left.size());
+    std::memcpy(buffer + 1 + left.size(), right.data(), right.size());
+    return Digest::sha256(buffer, 1 + left.size() + right.size());
+}
+
+Digest MerkleTree::foldHashes(std::vector<Digest> hashes) {
+    if (hashes.empty()) {
+        return Digest::sha256(&EMPTY_TAG, 1);
+    }
+
+    // An odd node at the end of a layer is promoted unchanged
+    while (hashes.size() > 1) {
+        size_t out = 0;
+        for (size_t i = 0; i < hashes.size(); i += 2) {
+            hashes[out++] = i + 1 < hashes.size() ? nodeHash(hashes[i], hashes[i + 1]) : hashes[i];
+        }
+        hashes.resize(out);
+    }
+    return hashes.front();
+}
@@ -0,0 +1,354 @@
+#include "PackRestorer.h"
+#include "BlockCache.h"
+#include "BufferPool.h"
+#include "Compressor.h"
+#include "Encryptor.h"
+#include "MemoryBudget.h"
+#include "ThreadPool.h"
+#include "Utils.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t PIECE_BYTES = 256 * 1024;
+
+struct Piece {
+    size_t record = 0;
+    std::vector<uint8_t> data;
+    bool last = false;
+    bool decoded = true;        // Set on the last piece: whether the whole blob decoded
+    MemoryBudget::Reservation budget;
+};
+
+// Decoded pieces on their way to the writers, bounded by the bytes they hold
+class PieceQueue {
+public:
+    PieceQueue(size_t writers, size_t capacity)
+        : queues_(writers)
+        , capacity_(capacity)
+        , queued_(0)
+        , closed_(false) {
+    }
+
+    void push(size_t writer, Piece piece) {
+        // The process-wide budget is waited on first, outside the queue lock
+        piece.budget = MemoryBudget::instance().reserve(piece.data.size());
+        std::unique_lock<std::mutex> lock(mutex_);
+        spaceFree_.wait(lock, [&] { return queued_ == 0 || queued_ + piece.data.size() <= capacity_; });
+        queued_ += piece.data.size();
+        queues_[writer].push_back(std::move(piece));
+        available_.notify_all();
+    }
+
+    bool pop(size_t writer, Piece& piece) {
+        piece = Piece();        // The last piece's reservation must not be held while waiting
+        std::unique_lock<std::mutex> lock(mutex_);
+        available_.wait(lock, [&] { return closed_ || !queues_[writer].empty(); });
+        if (queues_[writer].empty()) {
+            return false;
+        }
+        piece = std::move(queues_[writer].front());
+        queues_[writer].pop_front();
+        queued_ -= piece.data.size();
+        spaceFree_.notify_all();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        available_.notify_all();
+    }
+
+private:
+    std::vector<std::deque<Piece>> queues_;
+    size_t capacity_;
+    size_t queued_;
+    bool closed_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::condition_variable spaceFree_;
+};
+
+// Reads one run of a pack front to back in large blocks and hands out ascending byte ranges
+class RunReader {
+public:
+    RunReader(int fd, const PackStore::ReadRun& run, size_t blockBytes)
+        : fd_(fd)
+        , runEnd_(run.offset + run.length)
+        , buffer_(BufferPool::instance().lease(std::max<size_t>(blockBytes, 64 * 1024)))
+        , bufferStart_(run.offset)
+        , bufferLength_(0)
+        , bytesRead_(0) {
+    }
+
+    bool feed(std::uint64_t offset, std::uint64_t length, const Compressor::DataSink& sink) {
+        std::uint64_t position = offset;
+        std::uint64_t end = offset + length;
+        while (position < end) {
+            while (position >= bufferStart_ + bufferLength_) {
+                if (!readBlock()) {
+                    return false;
+                }
+            }
+            std::uint64_t available = std::min(end, bufferStart_ + bufferLength_) - position;
+            if (!sink(buffer_.data() + (position - bufferStart_), static_cast<size_t>(available))) {
+                return false;
+            }
+            position += available;
+        }
+        return true;
+    }
+
+    std::uint64_t getBytesRead() const {
+        return bytesRead_;
+    }
+
+private:
+    int fd_;
+    std::uint64_t runEnd_;
+    BufferPool::Lease buffer_;
+    std::uint64_t bufferStart_;
+    size_t bufferLength_;
+    std::uint64_t bytesRead_;
+
+    // The next block starts where the last one ended, so gaps are read through, never seeked over
+    bool readBlock() {
+        std::uint64_t start = bufferStart_ + bufferLength_;
+        size_t wanted = static_cast<size_t>(std::min<std::uint64_t>(buffer_.size(), runEnd_ - start));
+        size_t filled = 0;
+        while (fd_ >= 0 && filled < wanted) {
+            ssize_t bytes = ::pread(fd_, buffer_.data() + filled, wanted - filled, static_cast<off_t>(start + filled));
+            if (bytes <= 0) {
+                break;
+            }
+            filled += static_cast<size_t>(bytes);
+        }
+        bufferStart_ = start;
+        bufferLength_ = filled;
+        bytesRead_ += filled;
+        return filled > 0;
+    }
+};
+
+// Hands a cached decoded blob to its writer without touching the pack
+void sendCached(const BlockCache::Block& block, size_t index, PieceQueue& queue, size_t writer) {
+    for (size_t offset = 0; offset < block->size(); offset += PIECE_BYTES) {
+        Piece piece;
+        piece.record = index;
+        size_t length = std::min(PIECE_BYTES, block->size() - offset);
+        piece.data.assign(block->begin() + offset, block->begin() + offset + length);
+        queue.push(writer, std::move(piece));
+    }
+    Piece last;
+    last.record = index;
+    last.last = true;
+    queue.push(writer, std::move(last));
+}
+
+// Streams one blob through decrypt -> inflate into pieces for its writer
+bool decodeRecord(RunReader& reader, const PackStore::Record& record, size_t index, const Encryptor* encryptor,
+                  BlockCache* cache, PieceQueue& queue, size_t writer) {
+    // Blobs small enough to cache are also kept whole while they stream past
+    std::shared_ptr<std::vector<uint8_t>> decoded;
+    MemoryBudget& budget = MemoryBudget::instance();
+    if (cache && cache->admits(record.size) && budget.tryCharge(record.size)) {
+        decoded = std::make_shared<std::vector<uint8_t>>();
+        decoded->reserve(static_cast<size_t>(record.size));
+    }
+
+    Piece piece;
+    piece.record = index;
+    Compressor::DataSink emit = [&](const uint8_t* data, size_t length) {
+        if (decoded) {
+            decoded->insert(decoded->end(), data, data + length);
+        }
+        piece.data.insert(piece.data.end(), data, data + length);
+        if (piece.data.size() >= PIECE_BYTES) {
+            queue.push(writer, std::move(piece));
+            piece = Piece();
+            piece.record = index;
+        }
+        return true;
+    };
+
+    std::unique_ptr<Compressor::StreamInflater> inflater;
+    std::unique_ptr<Encryptor::StreamDecryptor> decryptor;
+    Compressor::DataSink sink = emit;
+    if (record.compressed) {
+        inflater = std::make_unique<Compressor::StreamInflater>(emit);
+        sink = [&inflater](const uint8_t* data, size_t length) {
+            return inflater->write(data, length);
+        };
+    }
+    bool ok = true;
+    if (record.encrypted) {
+        if (encryptor) {
+            decryptor = std::make_unique<Encryptor::StreamDecryptor>(*encryptor, sink);
+            sink = [&decryptor](const uint8_t* data, size_t length) {
+                return decryptor->write(data, length);
+            };
+        } else {
+            ok = false;
+        }
+    }
+
+    ok = ok && reader.feed(record.offset, record.length, sink);
+    ok = ok && (!decryptor || decryptor->finish()) && (!inflater || inflater->finish());
+
+    // Only verified content goes in, or one bad blob would poison every copy of it
+    if (decoded) {
+        budget.uncharge(record.size);   // The cache charges what it keeps
+    }
+    if (ok && decoded && decoded->size() == record.size && Utils::calculateSHA256(*decoded) == record.checksum) {
+        cache->put(record.checksum, decoded);
+    }
+
+    piece.last = true;
+    piece.decoded = ok;
+    queue.push(writer, std::move(piece));
+    return ok;
+}
+
+} // namespace
+
+PackRestorer::PackRestorer(const std::string& directory, const Encryptor* encryptor)
+    : PackRestorer(directory, encryptor, Options()) {
+}
+
+PackRestorer::PackRestorer(const std::string& directory, const Encryptor* encryptor, const Options& options)
+    : directory_(directory)
+    , encryptor_(encryptor)
+    , cache_(nullptr)
+    , options_(options) {
+}
+
+void PackRestorer::setBlockCache(BlockCache* cache) {
+    cache_ = cache;
+}
+
+PackRestorer::Result PackRestorer::restore(const std::vector<PackStore::Record>& records,
+                                           const std::string& restorePath, ProgressCallback progress) {
+    Result result;
+    std::vector<PackStore::ReadRun> runs = PackStore::planReads(records, options_.maxGap);
+    result.runs = runs.size();
+
+    // Parents are created up front so writers never race on shared directories
+    size_t total = 0;
+    for (const auto& run : runs) {
+        for (size_t index : run.records) {
+            Utils::createDirectoryRecursive(Utils::getParentDirectory(
+                Utils::joinPaths(restorePath, records[index].relativePath)));
+            total++;
+        }
+    }
+
+    size_t writers = std::max<size_t>(1, options_.writers);
+    PieceQueue queue(writers, options_.bufferBytes);
+    std::mutex resultMutex;
+    size_t done = 0;
+    auto finishRecord = [&](size_t index, bool ok) {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        if (ok) {
+            result.restored++;
+        } else {
+            result.failed++;
+            std::cerr << "Error: Failed to restore " << records[index].relativePath << std::endl;
+        }
+        done++;
+        if (progress) {
+            progress(done, total);
+        }
+    };
+
+    ThreadPool pool(writers);
+    for (size_t writer = 0; writer < writers; ++writer) {
+        pool.submit([&, writer]() {
+            DigestBuilder hasher;
+            FILE* output = nullptr;
+            bool started = false;
+            bool ok = true;
+            std::uint64_t written = 0;
+
+            Piece piece;
+            while (queue.pop(writer, piece)) {
+                const PackStore::Record& record = records[piece.record];
+                if (!started) {
+                    started = true;
+                    written = 0;
+                    hasher.reset();
+                    // A blob that failed before producing anything leaves no file behind
+                    ok = !(piece.last && !piece.decoded);
+                    if (ok) {
+                        output = std::fopen(Utils::joinPaths(restorePath, record.relativePath).c_str(), "wb");
+                        ok = output != nullptr;
+                    }
+                }
+
+                if (ok && !piece.data.empty()) {
+                    hasher.update(piece.data.data(), piece.data.size());
+                    written += piece.data.size();
+                    ok = std::fwrite(piece.data.data(), 1, piece.data.size(), output) == piece.data.size();
+                }
+
+                if (piece.last) {
+                    if (output) {
+                        ok = std::fclose(output) == 0 && ok;
+                        output = nullptr;
+                    }
+                    ok = ok && piece.decoded && written == record.size && hasher.finish() == record.checksum;
+                    finishRecord(piece.record, ok);
+                    started = false;
+                }
+            }
+        });
+    }
+
+    // One reader walks the packs in offset order; records go round-robin to the writers
+    size_t nextWriter = 0;
+    std::string openPack;
+    int fd = -1;
+    for (const auto& run : runs) {
+        if (run.pack != openPack) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            openPack = run.pack;
+            fd = ::open(Utils::joinPaths(directory_, run.pack).c_str(), O_RDONLY | O_CLOEXEC);
+#ifdef POSIX_FADV_SEQUENTIAL
+            if (fd >= 0) {
+                posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            }
+#endif
+        }
+
+        RunReader reader(fd, run, options_.readBlockBytes);
+        for (size_t index : run.records) {
+            const PackStore::Record& record = records[index];
+            BlockCache::Block block = cache_ ? cache_->get(record.checksum) : nullptr;
+            if (block) {
+                sendCached(block, index, queue, nextWriter);
+                result.cacheHits++;
+            } else {
+                decodeRecord(reader, record, index, encryptor_, cache_, queue, nextWriter);
+            }
+            nextWriter = (nextWriter + 1) % writers;
+        }
+        result.bytesRead += reader.getBytesRead();
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+
+    queue.close();
+    pool.waitIdle();
+    return result;
+}
@@ -0,0 +1,381 @@
+#include "PackStore.h"
+#include "Utils.h"
+#include "IoThrottle.h"
+#include "BufferPool.h"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <tuple>
+#include <unistd.h>
+
+namespace {
+
+std::int64_t toMillis(const std::chrono::system_clock::time_point& time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+// Committed records only; committedBytes receives the journal length up to the last marker
+bool loadJournal(const std::string& directory, std::vector<PackStore::Record>& records,
+                 std::uint64_t& committedBytes) {
+    records.clear();
+    committedBytes = 0;
+
+    std::ifstream file(Utils::joinPaths(directory, PackStore::JOURNAL_FILE), std::ios::binary);
+    if (!file.is_open()) {
+        return true;    // No commits yet
+    }
+
+    std::vector<PackStore::Record> pending;
+    std::uint64_t position = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        position += line.size() + 1;
+        if (file.eof()) {
+            break;      // No trailing newline: torn write
+        }
+
+        nlohmann::json j = nlohmann::json::parse(line, nullptr, false);
+        if (j.is_discarded() || !j.is_object()) {
+            break;
+        }
+
+        if (j.contains("committed")) {
+            if (j.value("records", std::size_t(0)) != pending.size()) {
+                break;
+            }
+            records.insert(records.end(), pending.begin(), pending.end());
+            pending.clear();
+            committedBytes = position;
+            continue;
+        }
+
+        PackStore::Record record;
+        record.commit = j.value("commit", std::uint64_t(0));
+        record.time = std::chrono::system_clock::time_point(std::chrono::milliseconds(j.value("time", std::int64_t(0))));
+        record.relativePath = j.value("path", "");
+        record.deleted = j.value("deleted", false);
+        if (!record.deleted) {
+            record.pack = j.value("pack", "");
+            record.offset = j.value("offset", std::uint64_t(0));
+            record.length = j.value("length", std::uint64_t(0));
+            record.size = j.value("size", std::uintmax_t(0));
+            record.checksum = Digest::fromHex(j.value("checksum", ""));
+            record.compressed = j.value("compressed", false);
+            record.encrypted = j.value("encrypted", false);
+        }
+        pending.push_back(record);
+    }
+    return true;
+}
+
+} // namespace
+
+PackStore::PackStore(const std::string& directory, std::uint64_t packLimit)
+    : directory_(directory)
+    , packLimit_(packLimit)
+    , lastCommit_(0)
+    , pack_(nullptr)
+    , packSize_(0)
+    , committedSize_(0)
+    , inCommit_(false)
+    , ioThrottle_(nullptr) {
+}
+
+PackStore::~PackStore() {
+    close();
+}
+
+bool PackStore::open() {
+    close();
+    if (!Utils::createDirectoryRecursive(directory_)) {
+        std::cerr << "Error: Cannot create pack directory: " << directory_ << std::endl;
+        return false;
+    }
+
+    std::vector<Record> records;
+    std::uint64_t journalBytes = 0;
+    loadJournal(directory_, records, journalBytes);
+
+    // Drop the tail of an interrupted commit so new lines start on a clean boundary
+    std::string journalPath = Utils::joinPaths(directory_, JOURNAL_FILE);
+    if (Utils::pathExists(journalPath) && Utils::getFileSize(journalPath) != journalBytes &&
+        ::truncate(journalPath.c_str(), static_cast<off_t>(journalBytes)) != 0) {
+        std::cerr << "Error: Cannot truncate torn journal: " << journalPath << std::endl;
+        return false;
+    }
+
+    std::string latestPack;
+    std::uint64_t committedEnd = 0;
+    for (const auto& record : records) {
+        lastCommit_ = std::max(lastCommit_, record.commit);
+        if (record.deleted) {
+            continue;
+        }
+        if (record.pack > latestPack) {
+            latestPack = record.pack;
+            committedEnd = 0;
+        }
+        if (record.pack == latestPack) {
+            committedEnd = std::max(committedEnd, record.offset + record.length);
+        }
+    }
+
+    packName_ = latestPack;
+    return openPack(latestPack.empty() ? nextPackName() : latestPack, committedEnd);
+}
+
+void PackStore::close() {
+    if (inCommit_) {
+        abortCommit();
+    }
+    if (pack_) {
+        std::fclose(pack_);
+        pack_ = nullptr;
+    }
+}
+
+std::string PackStore::getDirectory() const {
+    return directory_;
+}
+
+std::uint64_t PackStore::getLastCommit() const {
+    return lastCommit_;
+}
+
+void PackStore::setIoThrottle(IoThrottle* throttle) {
+    ioThrottle_ = throttle;
+}
+
+bool PackStore::beginCommit() {
+    if (!pack_ || inCommit_) {
+        return false;
+    }
+    if (packSize_ >= packLimit_ && !openPack(nextPackName(), 0)) {
+        return false;
+    }
+    staged_.clear();
+    inCommit_ = true;
+    return true;
+}
+
+bool PackStore::appendBlob(const std::string& blobPath, Record record) {
+    if (!inCommit_) {
+        return false;
+    }
+
+    FILE* blob = std::fopen(blobPath.c_str(), "rb");
+    if (!blob) {
+        return false;
+    }
+
+    record.pack = packName_;
+    record.offset = packSize_;
+    record.length = 0;
+
+    BufferPool::Lease buffer = BufferPool::instance().lease(1024 * 1024);
+    size_t bytesRead;
+    bool ok = true;
+    while ((bytesRead = std::fread(buffer.data(), 1, buffer.size(), blob)) > 0) {
+        if (ioThrottle_) {
+            ioThrottle_->read(bytesRead);
+            ioThrottle_->write(bytesRead);
+        }
+        if (std::fwrite(buffer.data(), 1, bytesRead, pack_) != bytesRead) {
+            ok = false;
+            break;
+        }
+        record.length += bytesRead;
+    }
+    ok = ok && !std::ferror(blob);
+    std::fclose(blob);
+
+    packSize_ += record.length;
+    if (ok) {
+        staged_.push_back(record);
+    }
+    return ok;
+}
+
+void PackStore::recordDeletion(const std::string& relativePath) {
+    if (!inCommit_) {
+        return;
+    }
+    Record record;
+    record.relativePath = relativePath;
+    record.deleted = true;
+    staged_.push_back(record);
+}
+
+bool PackStore::commit() {
+    if (!inCommit_) {
+        return false;
+    }
+    if (!syncFile(pack_)) {
+        abortCommit();
+        return false;
+    }
+
+    std::uint64_t commitId = lastCommit_ + 1;
+    std::int64_t time = toMillis(std::chrono::system_clock::now());
+
+    std::ostringstream lines;
+    for (const auto& record : staged_) {
+        nlohmann::json j;
+        j["commit"] = commitId;
+        j["time"] = time;
+        j["path"] = record.relativePath;
+        if (record.deleted) {
+            j["deleted"] = true;
+        } else {
+            j["pack"] = record.pack;
+            j["offset"] = record.offset;
+            j["length"] = record.length;
+            j["size"] = record.size;
+            j["checksum"] = record.checksum.toHex();
+            j["compressed"] = record.compressed;
+            j["encrypted"] = record.encrypted;
+        }
+        lines << j.dump() << "\n";
+    }
+    lines << nlohmann::json{{"committed", commitId}, {"time", time}, {"records", staged_.size()}}.dump() << "\n";
+
+    FILE* journal = std::fopen(Utils::joinPaths(directory_, JOURNAL_FILE).c_str(), "ab");
+    std::string data = lines.str();
+    bool ok = journal && std::fwrite(data.data(), 1, data.size(), journal) == data.size() && syncFile(journal);
+    if (journal) {
+        std::fclose(journal);
+    }
+    if (!ok) {
+        // The torn journal tail is dropped by the next open()
+        abortCommit();
+        return false;
+    }
+
+    lastCommit_ = commitId;
+    committedSize_ = packSize_;
+    staged_.clear();
+    inCommit_ = false;
+    return true;
+}
+
+void PackStore::abortCommit() {
+    staged_.clear();
+    inCommit_ = false;
+    if (pack_) {
+        // Reclaim the uncommitted bytes so the next commit starts where this one did
+        std::fflush(pack_);
+        if (::ftruncate(fileno(pack_), static_cast<off_t>(committedSize_)) == 0) {
+            packSize_ = committedSize_;
+        }
+        std::fseek(pack_, 0, SEEK_END);
+    }
+}
+
+bool PackStore::readJournal(const std::string& directory, std::vector<Record>& records) {
+    std::uint64_t committedBytes = 0;
+    return loadJournal(directory, records, committedBytes);
+}
+
+bool PackStore::extractBlob(const std::string& directory, const Record& record, const std::string& outputPath) {
+    if (record.deleted) {
+        return false;
+    }
+
+    FILE* pack = std::fopen(Utils::joinPaths(directory, record.pack).c_str(), "rb");
+    if (!pack) {
+        return false;
+    }
+    FILE* output = std::fopen(outputPath.c_str(), "wb");
+    if (!output) {
+        std::fclose(pack);
+        return false;
+    }
+
+    bool ok = std::fseek(pack, static_cast<long>(record.offset), SEEK_SET) == 0;
+    BufferPool::Lease buffer = BufferPool::instance().lease(1024 * 1024);
+    std::uint64_t remaining = record.length;
+    while (ok && remaining > 0) {
+        size_t chunk = static_cast<size_t>(std::min<std::uint64_t>(remaining, buffer.size()));
+        ok = std::fread(buffer.data(), 1, chunk, pack) == chunk &&
+             std::fwrite(buffer.data(), 1, chunk, output) == chunk;
+        remaining -= chunk;
+    }
+
+    std::fclose(pack);
+    ok = std::fclose(output) == 0 && ok;
+    return ok;
+}
+
+std::vector<PackStore::ReadRun> PackStore::planReads(const std::vector<Record>& records, std::uint64_t maxGap) {
+    std::vector<size_t> order;
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (!records[i].deleted) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&records](size_t a, size_t b) {
+        return std::tie(records[a].pack, records[a].offset) < std::tie(records[b].pack, records[b].offset);
+    });
+    
+    std::vector<ReadRun> runs;
+    for (size_t index : order) {
+        const Record& record = records[index];
+        ReadRun* run = runs.empty() ? nullptr : &runs.back();
+        std::uint64_t runEnd = run ? run->offset + run->length : 0;
+        if (!run || run->pack != record.pack || record.offset > runEnd + maxGap) {
+            runs.emplace_back();
+            run = &runs.back();
+            run->pack = record.pack;
+            run->offset = record.offset;
+            runEnd = record.offset;
+        }
+        run->length = std::max(runEnd, record.offset + record.length) - run->offset;
+        run->records.push_back(index);
+    }
+    return runs;
+}
+
+bool PackStore::openPack(const std::string& name, std::uint64_t committedSize) {
+    if (pack_) {
+        std::fclose(pack_);
+        pack_ = nullptr;
+    }
+
+    std::string path = Utils::joinPaths(directory_, name);
+    pack_ = std::fopen(path.c_str(), Utils::pathExists(path) ? "r+b" : "w+b");
+    if (!pack_) {
+        std::cerr << "Error: Cannot open pack file: " << path << std::endl;
+        return false;
+    }
+
+    // Bytes past the committed end were appended by an interrupted commit
+    if (::ftruncate(fileno(pack_), static_cast<off_t>(committedSize)) != 0) {
+        std::cerr << "Error: Cannot truncate pack file: " << path << std::endl;
+        std::fclose(pack_);
+        pack_ = nullptr;
+        return false;
+    }
+    std::fseek(pack_, 0, SEEK_END);
+
+    packName_ = name;
+    packSize_ = committedSize;
+    committedSize_ = committedSize;
+    return true;
+}
+
+std::string PackStore::nextPackName() const {
+    unsigned long number = 0;
+    if (!packName_.empty()) {
+        number = std::stoul(packName_.substr(5, 6));    // pack_NNNNNN.pack
+    }
+    std::ostringstream name;
+    name << "pack_" << std::setw(6) << std::setfill('0') << (number + 1) << ".pack";
+    return name.str();
+}
+
+bool PackStore::syncFile(FILE* file) {
+    return std::fflush(file) == 0 && ::fsync(fileno(file)) == 0;
+}
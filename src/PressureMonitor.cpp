@@ -0,0 +1,129 @@
+#include "PressureMonitor.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+PressureMonitor::PressureMonitor()
+    : thresholds_() {
+}
+
+PressureMonitor::PressureMonitor(const Thresholds& thresholds)
+    : thresholds_(thresholds) {
+}
+
+PressureMonitor::~PressureMonitor() = default;
+
+void PressureMonitor::setThresholds(const Thresholds& thresholds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thresholds_ = thresholds;
+}
+
+PressureMonitor::Thresholds PressureMonitor::getThresholds() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return thresholds_;
+}
+
+void PressureMonitor::addSignal(const std::string& name, Signal signal) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    signals_[name] = signal;
+}
+
+void PressureMonitor::removeSignal(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    signals_.erase(name);
+}
+
+PressureMonitor::Sample PressureMonitor::sample() const {
+    Sample sample;
+
+    bool io = readPsi("/proc/pressure/io", sample.io);
+    bool cpu = readPsi("/proc/pressure/cpu", sample.cpu);
+    bool memory = readPsi("/proc/pressure/memory", sample.memory);
+    sample.psiAvailable = io || cpu || memory;
+    readLoadPerCpu(sample.loadPerCpu);
+
+    // Copy the signals so a slow callback doesn't hold the lock
+    std::map<std::string, Signal> signals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        signals = signals_;
+    }
+    for (const auto& pair : signals) {
+        try {
+            sample.signals[pair.first] = pair.second();
+        } catch (...) {
+            // A failing signal reports no pressure rather than stalling every job
+        }
+    }
+
+    return sample;
+}
+
+bool PressureMonitor::isHigh(const Sample& sample, std::string* reason) const {
+    Thresholds thresholds = getThresholds();
+    std::ostringstream why;
+
+    if (sample.psiAvailable) {
+        if (sample.io > thresholds.io) {
+            why << "io pressure " << sample.io << "%";
+        } else if (sample.cpu > thresholds.cpu) {
+            why << "cpu pressure " << sample.cpu << "%";
+        } else if (sample.memory > thresholds.memory) {
+            why << "memory pressure " << sample.memory << "%";
+        }
+    } else if (sample.loadPerCpu > thresholds.loadPerCpu) {
+        why << "load " << sample.loadPerCpu << " per cpu";
+    }
+
+    if (why.tellp() == 0) {
+        for (const auto& pair : sample.signals) {
+            if (pair.second > thresholds.signal) {
+                why << pair.first << " " << pair.second;
+                break;
+            }
+        }
+    }
+
+    if (reason) {
+        *reason = why.str();
+    }
+    return why.tellp() > 0;
+}
+
+bool PressureMonitor::readPsi(const std::string& path, double& avg10) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // some avg10=1.23 avg60=0.50 avg300=0.10 total=123456
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.rfind("some ", 0) != 0) {
+            continue;
+        }
+        size_t pos = line.find("avg10=");
+        if (pos == std::string::npos) {
+            return false;
+        }
+        try {
+            avg10 = std::stod(line.substr(pos + 6));
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool PressureMonitor::readLoadPerCpu(double& loadPerCpu) {
+    std::ifstream file("/proc/loadavg");
+    double load1 = 0.0;
+    if (!file.is_open() || !(file >> load1)) {
+        return false;
+    }
+
+    unsigned int cpus = std::thread::hardware_concurrency();
+    loadPerCpu = load1 / (cpus > 0 ? cpus : 1);
+    return true;
+}
@@ -0,0 +1,102 @@
+#include "RateLimiter.h"
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+constexpr double SLICE_SECONDS = 0.01;      // Tokens a thread takes from the shared bucket at once
+constexpr double BURST_SECONDS = 0.25;      // Idle time that may be banked
+
+std::atomic<std::uint64_t> nextLimiterId{1};
+
+struct ThreadCache {
+    std::uint64_t generation = 0;
+    double tokens = 0.0;
+};
+
+} // namespace
+
+RateLimiter::RateLimiter()
+    : RateLimiter(0.0) {
+}
+
+RateLimiter::RateLimiter(double tokensPerSecond)
+    : id_(nextLimiterId++)
+    , limited_(false)
+    , generation_(1)
+    , rate_(0.0)
+    , burst_(0.0)
+    , available_(0.0)
+    , lastRefill_(std::chrono::steady_clock::now()) {
+    setRate(tokensPerSecond);
+}
+
+RateLimiter::~RateLimiter() = default;
+
+void RateLimiter::setRate(double tokensPerSecond) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rate_ = std::max(0.0, tokensPerSecond);
+    burst_ = rate_ * BURST_SECONDS;
+    available_ = std::min(std::max(available_, 0.0), burst_);   // Old debt is forgiven
+    lastRefill_ = std::chrono::steady_clock::now();
+    limited_ = rate_ > 0.0;
+    generation_++;
+}
+
+double RateLimiter::getRate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rate_;
+}
+
+bool RateLimiter::isLimited() const {
+    return limited_;
+}
+
+void RateLimiter::acquire(double tokens) {
+    if (!limited_ || tokens <= 0.0) {
+        return;
+    }
+
+    // Ids are never reused, so a destroyed limiter's entry is merely stale
+    thread_local std::unordered_map<std::uint64_t, ThreadCache> caches;
+    ThreadCache& cache = caches[id_];
+
+    std::uint64_t generation = generation_;
+    if (cache.generation != generation) {
+        cache.generation = generation;
+        cache.tokens = 0.0;
+    }
+    if (cache.tokens >= tokens) {
+        cache.tokens -= tokens;
+        return;
+    }
+
+    double needed = tokens - cache.tokens;
+    std::chrono::duration<double> wait;
+    double slice;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slice = needed + rate_ * SLICE_SECONDS;
+        wait = take(slice);
+    }
+    cache.tokens += slice - tokens;
+
+    if (wait.count() > 0.0) {
+        std::this_thread::sleep_for(wait);
+    }
+}
+
+std::chrono::duration<double> RateLimiter::take(double tokens) {
+    if (rate_ <= 0.0) {
+        return std::chrono::duration<double>(0.0);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - lastRefill_).count();
+    available_ = std::min(burst_, available_ + elapsed * rate_);
+    lastRefill_ = now;
+
+    available_ -= tokens;
+    return std::chrono::duration<double>(available_ < 0.0 ? -available_ / rate_ : 0.0);
+}
@@ -0,0 +1,166 @@
+#include "ReadOrder.h"
+#include "DevicePools.h"
+#include "Utils.h"
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+
+namespace {
+
+struct Placement {
+    std::uint64_t device = 0;
+    int group = 0;              // 0 = keyed by scan position, 1 = by inode, 2 = by physical offset
+    std::uint64_t key = 0;
+};
+
+} // namespace
+
+std::vector<size_t> ReadOrder::plan(const std::vector<std::string>& paths, Mode mode) {
+    std::vector<size_t> order(paths.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    if (mode == Mode::SCAN || paths.size() < 2) {
+        return order;
+    }
+
+    std::vector<Placement> placements(paths.size());
+    std::map<std::uint64_t, bool> sortDevice;   // AUTO only reorders rotational devices
+    bool anySorted = false;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        Placement& placement = placements[i];
+        placement.key = i;
+
+        struct stat st;
+        if (::stat(paths[i].c_str(), &st) != 0) {
+            continue;
+        }
+        placement.device = static_cast<std::uint64_t>(st.st_dev);
+
+        auto device = sortDevice.find(placement.device);
+        if (device == sortDevice.end()) {
+            device = sortDevice.emplace(placement.device, ordersDevice(placement.device, mode)).first;
+        }
+        if (!device->second) {
+            continue;
+        }
+        anySorted = true;
+
+        std::vector<Extent> extents;
+        if (mode != Mode::INODE && mapExtents(paths[i], extents, 1) && !extents.empty()) {
+            placement.group = 2;
+            placement.key = extents.front().physical;
+        } else {
+            placement.group = 1;
+            placement.key = static_cast<std::uint64_t>(st.st_ino);
+        }
+    }
+    if (!anySorted) {
+        return order;
+    }
+
+    // Devices keep the order of their first file; files without extents go ahead of the mapped ones
+    std::map<std::uint64_t, size_t> deviceRank;
+    for (const auto& placement : placements) {
+        deviceRank.emplace(placement.device, deviceRank.size());
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const Placement& left = placements[a];
+        const Placement& right = placements[b];
+        return std::make_tuple(deviceRank[left.device], left.group, left.key) <
+               std::make_tuple(deviceRank[right.device], right.group, right.key);
+    });
+    return order;
+}
+
+void ReadOrder::arrange(std::vector<std::string>& paths, Mode mode) {
+    std::vector<size_t> order = plan(paths, mode);
+    std::vector<std::string> arranged;
+    arranged.reserve(paths.size());
+    for (size_t index : order) {
+        arranged.push_back(std::move(paths[index]));
+    }
+    paths.swap(arranged);
+}
+
+bool ReadOrder::ordersDevice(std::uint64_t device, Mode mode) {
+    if (mode == Mode::SCAN) {
+        return false;
+    }
+    if (mode != Mode::AUTO) {
+        return true;
+    }
+    std::string name;
+    return DevicePools::probeDeviceType(device, name) == DevicePools::DeviceType::ROTATIONAL;
+}
+
+bool ReadOrder::mapExtents(const std::string& path, std::vector<Extent>& extents, size_t maxExtents) {
+    extents.clear();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Without a limit, a first call with no extent slots asks how many there are
+    size_t count = maxExtents;
+    if (count == 0) {
+        struct fiemap probe = {};
+        probe.fm_length = FIEMAP_MAX_OFFSET;
+        if (::ioctl(fd, FS_IOC_FIEMAP, &probe) != 0) {
+            ::close(fd);
+            return false;
+        }
+        count = probe.fm_mapped_extents;
+    }
+
+    std::vector<std::uint8_t> buffer(sizeof(struct fiemap) + count * sizeof(struct fiemap_extent));
+    auto* map = reinterpret_cast<struct fiemap*>(buffer.data());
+    map->fm_length = FIEMAP_MAX_OFFSET;
+    map->fm_extent_count = static_cast<std::uint32_t>(count);
+    bool ok = ::ioctl(fd, FS_IOC_FIEMAP, map) == 0;
+    ::close(fd);
+    if (!ok) {
+        return false;
+    }
+
+    for (std::uint32_t i = 0; i < map->fm_mapped_extents; ++i) {
+        const struct fiemap_extent& extent = map->fm_extents[i];
+        if (extent.fe_flags & (FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DATA_INLINE)) {
+            continue;   // No meaningful disk address
+        }
+        extents.push_back({extent.fe_logical, extent.fe_physical, extent.fe_length});
+    }
+    return true;
+}
+
+bool ReadOrder::parseMode(const std::string& text, Mode& mode) {
+    std::string value = Utils::toLower(text);
+    if (value == "auto") {
+        mode = Mode::AUTO;
+    } else if (value == "scan") {
+        mode = Mode::SCAN;
+    } else if (value == "inode") {
+        mode = Mode::INODE;
+    } else if (value == "physical") {
+        mode = Mode::PHYSICAL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string ReadOrder::modeToString(Mode mode) {
+    switch (mode) {
+        case Mode::AUTO: return "auto";
+        case Mode::SCAN: return "scan";
+        case Mode::INODE: return "inode";
+        case Mode::PHYSICAL: return "physical";
+    }
+    return "auto";
+}
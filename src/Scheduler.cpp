@@ -1,17 +1,23 @@
 #include "Scheduler.h"
+#include "ThreadPool.h"
 #include "Utils.h"
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <random>
 
 using json = nlohmann::json;
 
 Scheduler::Scheduler() 
-    : running_(false)
+    : nextGeneration_(0)
+    , running_(false)
+    , activeJobs_(0)
     , maxConcurrentBackups_(1)
     , retryAttempts_(3)
-    , retryDelay_(std::chrono::seconds(60)) {
+    , retryDelay_(std::chrono::seconds(60))
+    , pressureHigh_(false)
+    , startJitter_(0) {
 }
 
 Scheduler::~Scheduler() {
@@ -52,7 +58,15 @@ bool Scheduler::scheduleBackup(const std::string& name, ScheduleType type, std::
         schedule.nextRun = std::chrono::system_clock::now() + schedule.interval;
     }
     
-    schedules_[name] = schedule;
+    {
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
+        if (type != ScheduleType::ONCE) {
+            schedule.nextRun += startOffset(name);
+        }
+        schedules_[name] = schedule;
+        addTimer(name, schedule);
+    }
+    wakeup_.notify_all();
     
     std::cout << "Scheduled backup '" << name << "' with interval " 
               << Utils::formatDuration(schedule.interval) << std::endl;
@@ -68,7 +82,12 @@ bool Scheduler::scheduleBackupAt(const std::string& name, const std::chrono::sys
     schedule.backupName = name;
     schedule.enabled = true;
     
-    schedules_[name] = schedule;
+    {
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
+        schedules_[name] = schedule;
+        addTimer(name, schedule);
+    }
+    wakeup_.notify_all();
     
     std::cout << "Scheduled backup '" << name << "' at " 
               << Utils::formatTimestamp(when) << std::endl;
@@ -77,19 +96,45 @@ bool Scheduler::scheduleBackupAt(const std::string& name, const std::chrono::sys
 }
 
 bool Scheduler::cancelScheduledBackup(const std::string& name) {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
     auto it = schedules_.find(name);
     if (it != schedules_.end()) {
         schedules_.erase(it);
+        disarmTimer(name);
+        deferredSince_.erase(name);
         std::cout << "Cancelled scheduled backup: " << name << std::endl;
         return true;
     }
     return false;
 }
 
+bool Scheduler::setScheduleSource(const std::string& name, const std::string& sourcePath) {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
+    auto it = schedules_.find(name);
+    if (it == schedules_.end()) {
+        return false;
+    }
+    it->second.sourcePath = sourcePath;
+    return true;
+}
+
+bool Scheduler::setScheduleIoShare(const std::string& name, unsigned int weight, int priority) {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
+    auto it = schedules_.find(name);
+    if (it == schedules_.end()) {
+        return false;
+    }
+    it->second.ioWeight = std::max(1u, weight);
+    it->second.ioPriority = priority;
+    return true;
+}
+
 bool Scheduler::pauseScheduledBackup(const std::string& name) {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
     auto it = schedules_.find(name);
     if (it != schedules_.end()) {
         it->second.enabled = false;
+        disarmTimer(name);
         std::cout << "Paused scheduled backup: " << name << std::endl;
         return true;
     }
@@ -97,13 +142,38 @@ bool Scheduler::pauseScheduledBackup(const std::string& name) {
 }
 
 bool Scheduler::resumeScheduledBackup(const std::string& name) {
-    auto it = schedules_.find(name);
-    if (it != schedules_.end()) {
+    {
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
+        auto it = schedules_.find(name);
+        if (it == schedules_.end()) {
+            return false;
+        }
+        if (!it->second.enabled) {
+            it->second.enabled = true;
+            addTimer(name, it->second);
+        }
+    }
+    wakeup_.notify_all();
+    
+    std::cout << "Resumed scheduled backup: " << name << std::endl;
+    return true;
+}
+
+bool Scheduler::runNow(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
+        auto it = schedules_.find(name);
+        if (it == schedules_.end()) {
+            return false;
+        }
+        // A run of another schedule on the same source picks this up when it finishes;
+        // a run of this one already in flight re-arms it from its own interval
         it->second.enabled = true;
-        std::cout << "Resumed scheduled backup: " << name << std::endl;
-        return true;
+        it->second.nextRun = std::chrono::system_clock::now();
+        addTimer(name, it->second);
     }
-    return false;
+    wakeup_.notify_all();
+    return true;
 }
 
 void Scheduler::start() {
@@ -112,8 +182,16 @@ void Scheduler::start() {
     }
     
     running_ = true;
+    executor_ = std::make_unique<ThreadPool>(std::max<size_t>(1, maxConcurrentBackups_));
     schedulerThread_ = std::thread(&Scheduler::schedulerLoop, this);
     
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        if (scrubber_) {
+            scrubber_->start();
+        }
+    }
+    
     std::cout << "Backup scheduler started" << std::endl;
 }
 
@@ -122,12 +200,26 @@ void Scheduler::stop() {
         return;
     }
     
-    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
+        running_ = false;
+    }
+    wakeup_.notify_all();
     
     if (schedulerThread_.joinable()) {
         schedulerThread_.join();
     }
     
+    // Waits for running jobs; queued ones see running_ == false and return at once
+    executor_.reset();
+    
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        if (scrubber_) {
+            scrubber_->stop();
+        }
+    }
+    
     std::cout << "Backup scheduler stopped" << std::endl;
 }
 
@@ -135,6 +227,59 @@ bool Scheduler::isRunning() const {
     return running_;
 }
 
+void Scheduler::enableScrubbing(const Scrubber::Options& options) {
+    std::lock_guard<std::mutex> lock(jobMutex_);
+    if (scrubber_) {
+        scrubber_->stop();
+    }
+    
+    scrubber_ = std::make_unique<Scrubber>(options);
+    scrubber_->setErrorCallback([this](const std::string& name, const std::string& error) {
+        std::cerr << "Scrub detected corruption: " << error << std::endl;
+        if (errorCallback_) {
+            errorCallback_(name, error);
+        }
+    });
+    
+    if (activeJobs_ > 0) {
+        scrubber_->pause();
+    }
+    if (running_) {
+        scrubber_->start();
+    }
+    
+    std::cout << "Background scrubbing enabled for " << options.repositoryPath << std::endl;
+}
+
+void Scheduler::disableScrubbing() {
+    std::lock_guard<std::mutex> lock(jobMutex_);
+    scrubber_.reset();
+}
+
+bool Scheduler::isScrubbingEnabled() const {
+    std::lock_guard<std::mutex> lock(jobMutex_);
+    return scrubber_ != nullptr;
+}
+
+Scrubber::Stats Scheduler::getScrubStats() const {
+    std::lock_guard<std::mutex> lock(jobMutex_);
+    return scrubber_ ? scrubber_->getStats() : Scrubber::Stats();
+}
+
+void Scheduler::beginJob() {
+    std::lock_guard<std::mutex> lock(jobMutex_);
+    if (activeJobs_++ == 0 && scrubber_) {
+        scrubber_->pause();
+    }
+}
+
+void Scheduler::endJob() {
+    std::lock_guard<std::mutex> lock(jobMutex_);
+    if (activeJobs_ > 0 && --activeJobs_ == 0 && scrubber_) {
+        scrubber_->resume();
+    }
+}
+
 void Scheduler::setBackupCallback(std::function<bool(const std::string&)> callback) {
     backupCallback_ = callback;
 }
@@ -143,7 +288,13 @@ void Scheduler::setErrorCallback(std::function<void(const std::string&, const st
     errorCallback_ = callback;
 }
 
+void Scheduler::setPressureCallback(std::function<void(bool, const std::string&)> callback) {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
+    pressureCallback_ = callback;
+}
+
 std::vector<Scheduler::ScheduleInfo> Scheduler::getScheduledBackups() const {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
     std::vector<ScheduleInfo> schedules;
     
     for (const auto& pair : schedules_) {
@@ -153,9 +304,25 @@ std::vector<Scheduler::ScheduleInfo> Scheduler::getScheduledBackups() const {
     return schedules;
 }
 
+bool Scheduler::getSchedule(const std::string& name, ScheduleInfo& info) const {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
+    auto it = schedules_.find(name);
+    if (it == schedules_.end()) {
+        return false;
+    }
+    info = it->second;
+    return true;
+}
+
 std::chrono::system_clock::time_point Scheduler::getNextScheduledTime() const {
-    auto earliest = std::chrono::system_clock::time_point::max();
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
     
+    // The heap top is the answer unless it went stale; fall back to a scan then
+    if (!timers_.empty() && isTimerCurrent(timers_.top())) {
+        return timers_.top().when;
+    }
+    
+    auto earliest = std::chrono::system_clock::time_point::max();
     for (const auto& pair : schedules_) {
         const ScheduleInfo& schedule = pair.second;
         if (schedule.enabled && schedule.nextRun < earliest) {
@@ -167,28 +334,57 @@ std::chrono::system_clock::time_point Scheduler::getNextScheduledTime() const {
 }
 
 size_t Scheduler::getActiveSchedulesCount() const {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
     return std::count_if(schedules_.begin(), schedules_.end(),
                         [](const auto& pair) { return pair.second.enabled; });
 }
 
+size_t Scheduler::getRunningBackupsCount() const {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
+    return busySources_.size();
+}
+
 void Scheduler::setMaxConcurrentBackups(size_t maxConcurrent) {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
     maxConcurrentBackups_ = maxConcurrent;
 }
 
 void Scheduler::setRetryAttempts(int attempts) {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
     retryAttempts_ = attempts;
 }
 
 void Scheduler::setRetryDelay(std::chrono::seconds delay) {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
     retryDelay_ = delay;
 }
 
+void Scheduler::setStartJitter(std::chrono::seconds jitter) {
+    std::lock_guard<std::mutex> lock(scheduleMutex_);
+    startJitter_ = jitter;
+}
+
+void Scheduler::setPressurePolicy(const PressurePolicy& policy) {
+    {
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
+        pressurePolicy_ = policy;
+        pressureMonitor_.setThresholds(policy.thresholds);
+        lastSampleTime_ = std::chrono::system_clock::time_point();
+    }
+    wakeup_.notify_all();
+}
+
+void Scheduler::addPressureSignal(const std::string& name, PressureMonitor::Signal signal) {
+    pressureMonitor_.addSignal(name, signal);
+}
+
 bool Scheduler::saveSchedulesToFile(const std::string& filename) {
     try {
         json j;
         j["version"] = "1.0";
         j["schedules"] = json::array();
         
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
         for (const auto& pair : schedules_) {
             const std::string& name = pair.first;
             const ScheduleInfo& schedule = pair.second;
@@ -197,8 +393,12 @@ bool Scheduler::saveSchedulesToFile(const std::string& filename) {
             scheduleJson["name"] = name;
             scheduleJson["type"] = static_cast<int>(schedule.type);
             scheduleJson["interval"] = schedule.interval.count();
-            scheduleJson["nextRun"] = Utils::formatTimestamp(schedule.nextRun);
+            scheduleJson["nextRun"] = schedule.nextRun == std::chrono::system_clock::time_point::max()
+                                          ? "" : Utils::formatTimestamp(schedule.nextRun);
             scheduleJson["backupName"] = schedule.backupName;
+            scheduleJson["sourcePath"] = schedule.sourcePath;
+            scheduleJson["ioWeight"] = schedule.ioWeight;
+            scheduleJson["ioPriority"] = schedule.ioPriority;
             scheduleJson["enabled"] = schedule.enabled;
             
             j["schedules"].push_back(scheduleJson);
@@ -232,6 +432,7 @@ bool Scheduler::loadSchedulesFromFile(const std::string& filename) {
         json j;
         file >> j;
         
+        std::unique_lock<std::mutex> lock(scheduleMutex_);
         schedules_.clear();
         
         for (const auto& scheduleJson : j["schedules"]) {
@@ -240,13 +441,28 @@ bool Scheduler::loadSchedulesFromFile(const std::string& filename) {
             ScheduleInfo schedule;
             schedule.type = static_cast<ScheduleType>(scheduleJson["type"]);
             schedule.interval = std::chrono::seconds(scheduleJson["interval"]);
-            schedule.nextRun = Utils::parseTimestamp(scheduleJson["nextRun"]);
+            // No next run: a one-time schedule that is done, or a run cut short by a restart
+            std::string nextRun = scheduleJson["nextRun"];
+            if (!nextRun.empty()) {
+                schedule.nextRun = Utils::parseTimestamp(nextRun);
+            } else if (schedule.type == ScheduleType::ONCE) {
+                schedule.nextRun = std::chrono::system_clock::time_point::max();
+            } else {
+                schedule.nextRun = std::chrono::system_clock::now();
+            }
             schedule.backupName = scheduleJson["backupName"];
+            schedule.sourcePath = scheduleJson.value("sourcePath", "");
+            schedule.ioWeight = scheduleJson.value("ioWeight", 100u);
+            schedule.ioPriority = scheduleJson.value("ioPriority", 0);
             schedule.enabled = scheduleJson["enabled"];
             
             schedules_[name] = schedule;
         }
         
+        rebuildTimers();
+        lock.unlock();
+        wakeup_.notify_all();
+        
         return true;
         
     } catch (const std::exception& e) {
@@ -256,27 +472,185 @@ bool Scheduler::loadSchedulesFromFile(const std::string& filename) {
 }
 
 void Scheduler::schedulerLoop() {
+    std::unique_lock<std::mutex> lock(scheduleMutex_);
+    
     while (running_) {
-        try {
-            // Check for backups that need to run
-            for (auto& pair : schedules_) {
-                const std::string& name = pair.first;
-                ScheduleInfo& schedule = pair.second;
+        auto wakeAt = std::chrono::system_clock::time_point::max();
+        
+        if (!timers_.empty()) {
+            Timer next = timers_.top();
+            if (!isTimerCurrent(next)) {
+                timers_.pop();
+                continue;
+            }
+            
+            if (shouldExecuteBackup(schedules_.at(next.name))) {
+                // Sampling drops the lock, so start over to revalidate the heap afterwards
+                if (pressurePolicy_.enabled && refreshPressure(lock)) {
+                    continue;
+                }
                 
-                if (shouldExecuteBackup(schedule)) {
-                    executeScheduledBackup(name);
-                    updateNextRunTime(name);
+                timers_.pop();
+                if (!pressurePolicy_.enabled || !deferForPressure(next.name, schedules_.at(next.name))) {
+                    dispatchBackup(next.name);
                 }
+                continue;
             }
-            
-            // Sleep for a short interval before checking again
-            std::this_thread::sleep_for(std::chrono::seconds(10));
-            
-        } catch (const std::exception& e) {
-            std::cerr << "Error in scheduler loop: " << e.what() << std::endl;
-            std::this_thread::sleep_for(std::chrono::seconds(60));
+            wakeAt = next.when;
+        }
+        
+        // Keep watching pressure while backups run so they can be told to slow down
+        if (pressurePolicy_.enabled && !busySources_.empty()) {
+            auto sampleAt = lastSampleTime_ + pressurePolicy_.sampleInterval;
+            if (std::chrono::system_clock::now() >= sampleAt) {
+                refreshPressure(lock);
+                continue;
+            }
+            wakeAt = std::min(wakeAt, sampleAt);
+        }
+        
+        // Sleep until the earliest run falls due; any schedule change or stop wakes us early
+        if (wakeAt == std::chrono::system_clock::time_point::max()) {
+            wakeup_.wait(lock);
+        } else {
+            wakeup_.wait_until(lock, wakeAt);
+        }
+    }
+}
+
+bool Scheduler::refreshPressure(std::unique_lock<std::mutex>& lock) {
+    auto now = std::chrono::system_clock::now();
+    if (now - lastSampleTime_ < std::chrono::seconds(1)) {
+        return false;
+    }
+    lastSampleTime_ = now;
+    
+    // /proc reads and application signals run without the schedule lock
+    lock.unlock();
+    std::string reason;
+    bool high = pressureMonitor_.isHigh(pressureMonitor_.sample(), &reason);
+    lock.lock();
+    
+    bool changed = high != pressureHigh_;
+    pressureHigh_ = high;
+    pressureReason_ = reason;
+    
+    if (changed) {
+        std::cout << (high ? "System under pressure (" + reason + ")" : std::string("System pressure cleared"))
+                  << std::endl;
+        auto callback = pressureCallback_;
+        if (callback) {
+            lock.unlock();
+            callback(high, reason);
+            lock.lock();
+        }
+    }
+    return true;
+}
+
+bool Scheduler::deferForPressure(const std::string& name, ScheduleInfo& schedule) {
+    auto now = std::chrono::system_clock::now();
+    auto since = deferredSince_.emplace(name, now).first->second;
+    
+    if (!pressureHigh_) {
+        deferredSince_.erase(name);
+        return false;
+    }
+    if (now - since >= pressurePolicy_.maxDelay) {
+        std::cout << "Running " << name << " despite " << pressureReason_ << ": deferred for "
+                  << Utils::formatDuration(pressurePolicy_.maxDelay) << std::endl;
+        deferredSince_.erase(name);
+        return false;
+    }
+    
+    if (since == now) {
+        std::cout << "Deferring " << name << ": " << pressureReason_ << std::endl;
+    }
+    
+    // Jitter the recheck so deferred backups don't all start the moment pressure clears
+    static thread_local std::mt19937 rng(std::random_device{}());
+    auto recheck = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        pressurePolicy_.recheckInterval * std::uniform_real_distribution<double>(1.0, 1.5)(rng));
+    schedule.nextRun = std::min(now + recheck, since + pressurePolicy_.maxDelay);
+    addTimer(name, schedule);
+    return true;
+}
+
+void Scheduler::dispatchBackup(const std::string& name) {
+    ScheduleInfo& schedule = schedules_.at(name);
+    std::string source = sourceKey(name, schedule);
+    
+    // Running or waiting; finishBackup gives it a next run
+    schedule.nextRun = std::chrono::system_clock::time_point::max();
+    disarmTimer(name);
+    
+    // Never overlap two runs against the same source; the waiting one starts when it frees up.
+    // A schedule is never queued behind its own run, which re-arms it when it finishes.
+    auto busy = busySources_.find(source);
+    if (busy != busySources_.end()) {
+        auto& waiting = deferred_[source];
+        if (busy->second != name && std::find(waiting.begin(), waiting.end(), name) == waiting.end()) {
+            waiting.push_back(name);
+        }
+        return;
+    }
+    
+    busySources_.emplace(source, name);
+    int attempt = ++attempts_[name];
+    
+    executor_->submit([this, name, source, attempt]() {
+        bool success = false;
+        if (running_) {
+            success = executeScheduledBackup(name, attempt);
+        }
+        finishBackup(name, source, success);
+    });
+}
+
+void Scheduler::finishBackup(const std::string& name, const std::string& source, bool success) {
+    bool exhausted = false;
+    {
+        std::lock_guard<std::mutex> lock(scheduleMutex_);
+        busySources_.erase(source);
+        
+        auto it = schedules_.find(name);
+        if (it != schedules_.end() && running_) {
+            int attempt = attempts_[name];
+            if (!success && attempt < retryAttempts_) {
+                // Retry as a timer event so the executor slot is free in the meantime
+                std::cout << "Retrying " << name << " in " << Utils::formatDuration(retryDelay_) << "..." << std::endl;
+                it->second.nextRun = std::chrono::system_clock::now() + retryDelay_;
+                addTimer(name, it->second);
+            } else {
+                if (!success) {
+                    std::cerr << "Scheduled backup failed after " << attempt << " attempts: " << name << std::endl;
+                    exhausted = true;
+                }
+                attempts_.erase(name);
+                updateNextRunTime(name);
+            }
+        } else {
+            attempts_.erase(name);
+        }
+        
+        // Release schedules that were held back by this run; paused ones start on resume
+        auto waiting = deferred_.find(source);
+        if (waiting != deferred_.end()) {
+            for (const auto& deferredName : waiting->second) {
+                auto deferredIt = schedules_.find(deferredName);
+                if (deferredName != name && deferredIt != schedules_.end()) {
+                    deferredIt->second.nextRun = std::chrono::system_clock::now();
+                    addTimer(deferredName, deferredIt->second);
+                }
+            }
+            deferred_.erase(waiting);
         }
     }
+    wakeup_.notify_all();
+    
+    if (exhausted && errorCallback_) {
+        errorCallback_(name, "Backup failed after all retry attempts");
+    }
 }
 
 std::chrono::system_clock::time_point Scheduler::calculateNextRun(const ScheduleInfo& schedule) {
@@ -298,56 +672,35 @@ std::chrono::system_clock::time_point Scheduler::calculateNextRun(const Schedule
     }
 }
 
-void Scheduler::executeScheduledBackup(const std::string& name) {
+bool Scheduler::executeScheduledBackup(const std::string& name, int attempt) {
     std::cout << "Executing scheduled backup: " << name << std::endl;
     
     if (!backupCallback_) {
         std::cerr << "Error: No backup callback set" << std::endl;
-        return;
+        return false;
     }
     
-    // Execute backup with retry logic
-    int attempts = 0;
     bool success = false;
-    
-    while (attempts < retryAttempts_ && !success) {
-        attempts++;
+    beginJob();
+    try {
+        success = backupCallback_(name);
         
-        try {
-            success = backupCallback_(name);
-            
-            if (success) {
-                std::cout << "Scheduled backup completed successfully: " << name << std::endl;
-            } else {
-                std::cerr << "Scheduled backup failed (attempt " << attempts << "/" 
-                         << retryAttempts_ << "): " << name << std::endl;
-                
-                if (attempts < retryAttempts_) {
-                    std::cout << "Retrying in " << Utils::formatDuration(retryDelay_) << "..." << std::endl;
-                    std::this_thread::sleep_for(retryDelay_);
-                }
-            }
-            
-        } catch (const std::exception& e) {
-            std::cerr << "Exception during scheduled backup " << name << ": " << e.what() << std::endl;
-            
-            if (errorCallback_) {
-                errorCallback_(name, e.what());
-            }
-            
-            if (attempts < retryAttempts_) {
-                std::this_thread::sleep_for(retryDelay_);
-            }
+        if (success) {
+            std::cout << "Scheduled backup completed successfully: " << name << std::endl;
+        } else {
+            std::cerr << "Scheduled backup failed (attempt " << attempt << "): " << name << std::endl;
         }
-    }
-    
-    if (!success) {
-        std::cerr << "Scheduled backup failed after " << retryAttempts_ << " attempts: " << name << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Exception during scheduled backup " << name << ": " << e.what() << std::endl;
         
         if (errorCallback_) {
-            errorCallback_(name, "Backup failed after all retry attempts");
+            errorCallback_(name, e.what());
         }
     }
+    endJob();
+    
+    return success;
 }
 
 bool Scheduler::shouldExecuteBackup(const ScheduleInfo& schedule) {
@@ -368,5 +721,63 @@ void Scheduler::updateNextRunTime(const std::string& name) {
         if (it->second.type == ScheduleType::ONCE) {
             it->second.enabled = false;
         }
+        addTimer(name, it->second);
+    }
+}
+
+void Scheduler::addTimer(const std::string& name, const ScheduleInfo& schedule) {
+    // Whatever was armed before is superseded, even if nothing replaces it
+    disarmTimer(name);
+    if (!schedule.enabled || schedule.nextRun == std::chrono::system_clock::time_point::max()) {
+        return;
+    }
+    
+    // Stale entries are normally popped as they surface; rebuild if churn lets them pile up
+    if (timers_.size() >= 2 * schedules_.size() + 64) {
+        rebuildTimers();
+        return;
     }
+    std::uint64_t generation = ++nextGeneration_;
+    armed_[name] = generation;
+    timers_.push({schedule.nextRun, name, generation});
+}
+
+void Scheduler::disarmTimer(const std::string& name) {
+    armed_.erase(name);
+}
+
+bool Scheduler::isTimerCurrent(const Timer& timer) const {
+    auto it = schedules_.find(timer.name);
+    auto armed = armed_.find(timer.name);
+    return it != schedules_.end() && it->second.enabled &&
+           armed != armed_.end() && armed->second == timer.generation;
+}
+
+void Scheduler::rebuildTimers() {
+    // Re-arms every schedule with a next run; running and waiting ones have none
+    std::vector<Timer> timers;
+    timers.reserve(schedules_.size());
+    armed_.clear();
+    for (const auto& pair : schedules_) {
+        if (pair.second.enabled && pair.second.nextRun != std::chrono::system_clock::time_point::max()) {
+            std::uint64_t generation = ++nextGeneration_;
+            armed_[pair.first] = generation;
+            timers.push_back({pair.second.nextRun, pair.first, generation});
+        }
+    }
+    timers_ = std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>>(
+        std::greater<Timer>(), std::move(timers));
+}
+
+std::chrono::seconds Scheduler::startOffset(const std::string& name) const {
+    if (startJitter_.count() <= 0) {
+        return std::chrono::seconds(0);
+    }
+    
+    // Stable per name, so schedules created together stay spread across restarts
+    return std::chrono::seconds(std::hash<std::string>()(name) % startJitter_.count());
+}
+
+std::string Scheduler::sourceKey(const std::string& name, const ScheduleInfo& schedule) {
+    return schedule.sourcePath.empty() ? name : schedule.sourcePath;
 }
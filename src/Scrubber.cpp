@@ -0,0 +1,398 @@
+#include "Scrubber.h"
+#include "BackupVerifier.h"
+#include "Utils.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+Scrubber::Scrubber(const Options& options)
+    : options_(options)
+    , running_(false)
+    , paused_(false) {
+}
+
+Scrubber::~Scrubber() {
+    stop();
+}
+
+void Scrubber::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+
+    running_ = true;
+    scrubThread_ = std::thread(&Scrubber::scrubLoop, this);
+}
+
+void Scrubber::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    wakeup_.notify_all();
+
+    if (scrubThread_.joinable()) {
+        scrubThread_.join();
+    }
+}
+
+bool Scrubber::isRunning() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+void Scrubber::pause() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        paused_ = true;
+    }
+    wakeup_.notify_all();
+}
+
+void Scrubber::resume() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        paused_ = false;
+    }
+    wakeup_.notify_all();
+}
+
+bool Scrubber::isPaused() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return paused_;
+}
+
+void Scrubber::setErrorCallback(std::function<void(const std::string&, const std::string&)> callback) {
+    errorCallback_ = callback;
+}
+
+Scrubber::Stats Scrubber::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void Scrubber::scrubLoop() {
+    loadState();
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!waitWhilePaused(lock)) {
+                break;
+            }
+        }
+
+        std::vector<Blob> blobs;
+        try {
+            blobs = collectBlobs();
+        } catch (const std::exception& e) {
+            std::cerr << "Error scanning repository for scrubbing: " << e.what() << std::endl;
+        }
+
+        // Forget blobs whose backups have been removed
+        std::unordered_set<std::string> present;
+        for (const auto& blob : blobs) {
+            present.insert(blob.key);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = records_.begin(); it != records_.end();) {
+                it = present.count(it->first) ? std::next(it) : records_.erase(it);
+            }
+        }
+
+        std::vector<const Blob*> order = orderBlobs(blobs);
+        size_t index = 0;
+        while (index < order.size()) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (!waitWhilePaused(lock)) {
+                    break;
+                }
+            }
+
+            // An interrupted blob is retried once the scrubber is resumed
+            if (scrubBlob(*order[index])) {
+                index++;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!running_) {
+            break;
+        }
+        if (!order.empty() && index == order.size()) {
+            stats_.passesCompleted++;
+        }
+        lock.unlock();
+        saveState();
+        lock.lock();
+
+        // Sleep until the oldest verification falls due; rescan periodically for new backups
+        auto now = std::chrono::system_clock::now();
+        auto due = now + std::chrono::minutes(10);
+        for (const auto& pair : records_) {
+            due = std::min(due, pair.second.lastVerified + options_.minInterval);
+        }
+        if (due > now) {
+            wakeup_.wait_for(lock, due - now, [this]() { return !running_; });
+        }
+        if (!running_) {
+            break;
+        }
+    }
+
+    saveState();
+}
+
+std::vector<Scrubber::Blob> Scrubber::collectBlobs() const {
+    std::vector<Blob> blobs;
+    if (!Utils::isDirectory(options_.repositoryPath)) {
+        return blobs;
+    }
+
+    for (const auto& dirEntry : fs::directory_iterator(options_.repositoryPath)) {
+        if (!dirEntry.is_directory()) {
+            continue;
+        }
+
+        std::string backupPath = dirEntry.path().string();
+        std::string metadataFile = Utils::joinPaths(backupPath, "backup_metadata.json");
+        BackupMetadata metadata;
+        if (!Utils::pathExists(metadataFile) || !metadata.loadFromFile(metadataFile)) {
+            continue;
+        }
+
+        auto backupIds = metadata.listAllBackups();
+        if (backupIds.empty()) {
+            continue;
+        }
+
+        // The newest entry describes the contents of this backup directory
+        BackupMetadata::BackupInfo info = metadata.getBackupInfo(backupIds.back());
+        std::string backupName = dirEntry.path().filename().string();
+        for (const auto& entry : info.files) {
+            Blob blob;
+            blob.key = backupName + "/" + entry.relativePath;
+            blob.path = Utils::joinPaths(backupPath, entry.relativePath);
+            blob.entry = entry;
+            blob.blockSize = info.blockSize;
+            blobs.push_back(std::move(blob));
+        }
+    }
+
+    return blobs;
+}
+
+std::vector<const Scrubber::Blob*> Scrubber::orderBlobs(const std::vector<Blob>& blobs) const {
+    struct Candidate {
+        std::chrono::system_clock::time_point lastVerified;
+        bool wrapped;
+        const Blob* blob;
+    };
+
+    auto now = std::chrono::system_clock::now();
+    std::vector<Candidate> candidates;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& blob : blobs) {
+            auto it = records_.find(blob.key);
+            auto lastVerified = std::chrono::system_clock::time_point::min();
+            if (it != records_.end()) {
+                if (it->second.lastVerified + options_.minInterval > now) {
+                    continue;
+                }
+                lastVerified = it->second.lastVerified;
+            }
+            candidates.push_back({lastVerified, !cursor_.empty() && blob.key <= cursor_, &blob});
+        }
+    }
+
+    // Never verified first, then least recently verified; ties continue after the cursor
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.lastVerified != b.lastVerified) {
+            return a.lastVerified < b.lastVerified;
+        }
+        if (a.wrapped != b.wrapped) {
+            return !a.wrapped;
+        }
+        return a.blob->key < b.blob->key;
+    });
+
+    std::vector<const Blob*> order;
+    order.reserve(candidates.size());
+    for (const auto& candidate : candidates) {
+        order.push_back(candidate.blob);
+    }
+    return order;
+}
+
+bool Scrubber::scrubBlob(const Blob& blob) {
+    BackupVerifier::FileResult result;
+    bool interrupted = false;
+
+    if (!Utils::isRegularFile(blob.path)) {
+        result.relativePath = blob.entry.relativePath;
+        result.status = BackupVerifier::FileStatus::MISSING;
+        result.detail = "Blob not found";
+    } else {
+        result = BackupVerifier::checkStoredBlob(blob.path, blob.entry, blob.blockSize,
+                                                 [this, &interrupted](size_t blockBytes) {
+                                                     interrupted = !throttle(blockBytes);
+                                                     return !interrupted;
+                                                 });
+        if (interrupted) {
+            return false;
+        }
+    }
+
+    bool failed = result.status == BackupVerifier::FileStatus::CORRUPT ||
+                  result.status == BackupVerifier::FileStatus::MISSING;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        BlobRecord& record = records_[blob.key];
+        record.lastVerified = std::chrono::system_clock::now();
+        record.corrupt = failed;
+        cursor_ = blob.key;
+
+        stats_.bytesRead += result.bytesRead;
+        stats_.lastBlob = blob.key;
+        if (failed) {
+            stats_.blobsCorrupt++;
+        } else if (result.status == BackupVerifier::FileStatus::SKIPPED) {
+            stats_.blobsSkipped++;
+        } else {
+            stats_.blobsVerified++;
+        }
+    }
+
+    if (failed && errorCallback_) {
+        errorCallback_("scrub", blob.key + ": " + result.detail);
+    }
+
+    // Persist the cursor now and then so a restart loses little progress
+    if (std::chrono::steady_clock::now() - lastSave_ >= std::chrono::seconds(30)) {
+        saveState();
+    }
+
+    return true;
+}
+
+bool Scrubber::throttle(size_t blockBytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_ || paused_) {
+        return false;
+    }
+
+    // Pace reads so neither the byte nor the read-rate budget is exceeded; idle time is not banked
+    auto now = std::chrono::steady_clock::now();
+    if (nextRead_ < now) {
+        nextRead_ = now;
+    }
+    auto readAt = nextRead_;
+
+    std::chrono::duration<double> cost(0.0);
+    if (options_.bytesPerSecond > 0) {
+        cost = std::max(cost, std::chrono::duration<double>(static_cast<double>(blockBytes) / options_.bytesPerSecond));
+    }
+    if (options_.readsPerSecond > 0) {
+        cost = std::max(cost, std::chrono::duration<double>(1.0 / options_.readsPerSecond));
+    }
+    nextRead_ += std::chrono::duration_cast<std::chrono::steady_clock::duration>(cost);
+
+    if (readAt > now) {
+        wakeup_.wait_until(lock, readAt, [this]() { return !running_ || paused_; });
+    }
+    return running_ && !paused_;
+}
+
+bool Scrubber::waitWhilePaused(std::unique_lock<std::mutex>& lock) {
+    wakeup_.wait(lock, [this]() { return !running_ || !paused_; });
+    return running_;
+}
+
+bool Scrubber::loadState() {
+    try {
+        std::string path = statePath();
+        if (!Utils::pathExists(path)) {
+            return true; // First run
+        }
+
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        json j;
+        file >> j;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        records_.clear();
+        cursor_ = j.value("cursor", "");
+        for (const auto& item : j["blobs"].items()) {
+            BlobRecord record;
+            record.lastVerified = Utils::parseTimestamp(item.value()["lastVerified"].get<std::string>());
+            record.corrupt = item.value().value("corrupt", false);
+            records_[item.key()] = record;
+        }
+
+        return true;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading scrub state: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Scrubber::saveState() {
+    try {
+        json j;
+        j["version"] = "1.0";
+        j["timestamp"] = Utils::formatTimestamp(std::chrono::system_clock::now());
+        j["blobs"] = json::object();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            j["cursor"] = cursor_;
+            for (const auto& pair : records_) {
+                j["blobs"][pair.first] = {
+                    {"lastVerified", Utils::formatTimestamp(pair.second.lastVerified)},
+                    {"corrupt", pair.second.corrupt}
+                };
+            }
+        }
+
+        // Write then rename so an interrupted save never loses the cursor
+        std::string path = statePath();
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath);
+            if (!file.is_open()) {
+                return false;
+            }
+            file << j.dump(2);
+        }
+        fs::rename(tempPath, path);
+
+        lastSave_ = std::chrono::steady_clock::now();
+        return true;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error saving scrub state: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::string Scrubber::statePath() const {
+    return options_.statePath.empty() ? Utils::joinPaths(options_.repositoryPath, "scrub_state.json")
+                                      : options_.statePath;
+}
@@ -0,0 +1,49 @@
+#include "StoredChecksums.h"
+#include "Utils.h"
+#include <algorithm>
+
+StoredChecksums::StoredChecksums(size_t blockSize)
+    : blockSize_(blockSize)
+    , blockFill_(0)
+    , blockCrc_(0)
+    , finished_(false) {
+}
+
+void StoredChecksums::update(const uint8_t* data, size_t length) {
+    builder_.update(data, length);
+    
+    // Writes rarely line up with checksum blocks; carry the CRC across calls
+    while (blockSize_ > 0 && length > 0) {
+        size_t take = std::min(length, blockSize_ - blockFill_);
+        blockCrc_ = Utils::crc32c(data, take, blockCrc_);
+        blockFill_ += take;
+        data += take;
+        length -= take;
+        if (blockFill_ == blockSize_) {
+            blockChecksums_.push_back(blockCrc_);
+            blockFill_ = 0;
+            blockCrc_ = 0;
+        }
+    }
+}
+
+StoredChecksums::DataSink StoredChecksums::sink() {
+    return [this](const uint8_t* data, size_t length) {
+        update(data, length);
+        return true;
+    };
+}
+
+bool StoredChecksums::finish(Digest& digest, std::vector<uint32_t>& blockChecksums) {
+    if (finished_ || blockSize_ == 0) {
+        return false;
+    }
+    finished_ = true;
+    
+    if (blockFill_ > 0) {
+        blockChecksums_.push_back(blockCrc_);
+    }
+    digest = builder_.finish();
+    blockChecksums.swap(blockChecksums_);
+    return !digest.empty();
+}
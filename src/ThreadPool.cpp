@@ -0,0 +1,112 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <iostream>
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : activeTasks_(0)
+    , concurrency_(0)
+    , stopping_(false) {
+    if (threadCount == 0) {
+        threadCount = defaultThreadCount();
+    }
+    concurrency_ = threadCount;
+    
+    workers_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    taskAvailable_.notify_all();
+    
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    taskAvailable_.notify_one();
+}
+
+void ThreadPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return tasks_.empty() && activeTasks_ == 0; });
+}
+
+void ThreadPool::setConcurrency(size_t limit) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        concurrency_ = std::min(std::max<size_t>(1, limit), workers_.size());
+    }
+    taskAvailable_.notify_all();
+}
+
+size_t ThreadPool::getConcurrency() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return concurrency_;
+}
+
+size_t ThreadPool::getThreadCount() const {
+    return workers_.size();
+}
+
+size_t ThreadPool::getPendingTasks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+size_t ThreadPool::getActiveTasks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return activeTasks_;
+}
+
+size_t ThreadPool::defaultThreadCount() {
+    size_t count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 4;
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            taskAvailable_.wait(lock, [this] {
+                return (stopping_ && tasks_.empty()) || (!tasks_.empty() && activeTasks_ < concurrency_);
+            });
+            
+            if (tasks_.empty()) {
+                return; // Stopping and nothing left to run
+            }
+            
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            activeTasks_++;
+        }
+        
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Error in worker task: " << e.what() << std::endl;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            activeTasks_--;
+            if (tasks_.empty() && activeTasks_ == 0) {
+                idle_.notify_all();
+            }
+        }
+        taskAvailable_.notify_one();    // A parked thread may take the slot this one freed
+    }
+}
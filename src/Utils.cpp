@@ -1,4 +1,5 @@
 #include "Utils.h"
+#include "BufferPool.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -8,8 +9,12 @@
 #include <random>
 #include <cstring>
 #include <cerrno>
-#include <openssl/sha.h>
-#include <openssl/md5.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -196,77 +201,291 @@ std::string Utils::toUpper(const std::string& str) {
     return result;
 }
 
-std::string Utils::calculateSHA256(const std::string& filePath) {
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file) {
-        return "";
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+// Maps an ASCII character to its nibble value, or 0xFF when it is not a hex digit
+struct HexDecodeTable {
+    uint8_t values[256];
+
+    HexDecodeTable() {
+        std::memset(values, 0xFF, sizeof(values));
+        for (int i = 0; i < 10; ++i) {
+            values['0' + i] = static_cast<uint8_t>(i);
+        }
+        for (int i = 0; i < 6; ++i) {
+            values['a' + i] = static_cast<uint8_t>(10 + i);
+            values['A' + i] = static_cast<uint8_t>(10 + i);
+        }
     }
-    
-    SHA256_CTX sha256;
-    SHA256_Init(&sha256);
-    
-    char buffer[8192];
-    while (file.read(buffer, sizeof(buffer))) {
-        SHA256_Update(&sha256, buffer, file.gcount());
+};
+
+const HexDecodeTable HEX_DECODE;
+
+} // namespace
+
+std::string Utils::hexEncode(const uint8_t* data, size_t length) {
+    std::string result(length * 2, '\0');
+    char* out = &result[0];
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Encode 16 bytes per iteration: split nibbles, interleave, then map 0-15 to ASCII
+    const __m128i lowMask = _mm_set1_epi8(0x0F);
+    const __m128i asciiZero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i letterOffset = _mm_set1_epi8('a' - '0' - 10);
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), lowMask);
+        __m128i lo = _mm_and_si128(bytes, lowMask);
+
+        __m128i first = _mm_unpacklo_epi8(hi, lo);
+        __m128i second = _mm_unpackhi_epi8(hi, lo);
+
+        first = _mm_add_epi8(_mm_add_epi8(first, asciiZero),
+                             _mm_and_si128(_mm_cmpgt_epi8(first, nine), letterOffset));
+        second = _mm_add_epi8(_mm_add_epi8(second, asciiZero),
+                              _mm_and_si128(_mm_cmpgt_epi8(second, nine), letterOffset));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), first);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2 + 16), second);
     }
-    if (file.gcount() > 0) {
-        SHA256_Update(&sha256, buffer, file.gcount());
+#endif
+
+    for (; i < length; ++i) {
+        out[i * 2] = HEX_DIGITS[data[i] >> 4];
+        out[i * 2 + 1] = HEX_DIGITS[data[i] & 0x0F];
     }
-    
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256_Final(hash, &sha256);
-    
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+
+    return result;
+}
+
+std::string Utils::hexEncode(const std::vector<uint8_t>& data) {
+    return hexEncode(data.data(), data.size());
+}
+
+bool Utils::hexDecode(const std::string& hex, uint8_t* out, size_t outLength) {
+    if (hex.size() != outLength * 2) {
+        return false;
     }
-    
-    return ss.str();
+
+    const char* in = hex.data();
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Decode 32 characters into 16 bytes per iteration, validating every character
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i belowZero = _mm_set1_epi8('0' - 1);
+    const __m128i aboveNine = _mm_set1_epi8('9' + 1);
+    const __m128i belowA = _mm_set1_epi8('a' - 1);
+    const __m128i aboveF = _mm_set1_epi8('f' + 1);
+    const __m128i asciiZero = _mm_set1_epi8('0');
+    const __m128i letterBase = _mm_set1_epi8('a' - 10);
+    const __m128i byteMask = _mm_set1_epi16(0x00FF);
+
+    auto decodeNibbles = [&](__m128i chars, bool& valid) {
+        __m128i lower = _mm_or_si128(chars, caseBit);
+        __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(chars, belowZero), _mm_cmplt_epi8(chars, aboveNine));
+        __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(lower, belowA), _mm_cmplt_epi8(lower, aboveF));
+        valid = valid && _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) == 0xFFFF;
+        return _mm_or_si128(_mm_and_si128(isDigit, _mm_sub_epi8(chars, asciiZero)),
+                            _mm_and_si128(isLetter, _mm_sub_epi8(lower, letterBase)));
+    };
+
+    for (; i + 16 <= outLength; i += 16) {
+        bool valid = true;
+        __m128i first = decodeNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2)), valid);
+        __m128i second = decodeNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2 + 16)), valid);
+        if (!valid) {
+            return false;
+        }
+
+        // Each 16-bit lane holds (hi, lo) nibbles; fold them into one byte
+        first = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, byteMask), 4), _mm_srli_epi16(first, 8));
+        second = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(second, byteMask), 4), _mm_srli_epi16(second, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(first, second));
+    }
+#endif
+
+    for (; i < outLength; ++i) {
+        uint8_t hi = HEX_DECODE.values[static_cast<uint8_t>(in[i * 2])];
+        uint8_t lo = HEX_DECODE.values[static_cast<uint8_t>(in[i * 2 + 1])];
+        if (hi == 0xFF || lo == 0xFF) {
+            return false;
+        }
+        out[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+
+    return true;
 }
 
-std::string Utils::calculateSHA256(const std::vector<uint8_t>& data) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256(data.data(), data.size(), hash);
-    
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+std::vector<uint8_t> Utils::hexDecode(const std::string& hex) {
+    std::vector<uint8_t> result(hex.size() / 2);
+    if (hex.size() % 2 != 0 || !hexDecode(hex, result.data(), result.size())) {
+        return std::vector<uint8_t>();
     }
-    
-    return ss.str();
+    return result;
 }
 
-std::string Utils::calculateMD5(const std::string& filePath) {
+static Digest calculateFileDigest(const std::string& filePath, Digest::Algorithm algorithm,
+                                  const std::function<void(size_t)>& onRead = nullptr) {
     std::ifstream file(filePath, std::ios::binary);
     if (!file) {
-        return "";
+        return Digest();
     }
     
-    MD5_CTX md5;
-    MD5_Init(&md5);
+    DigestBuilder builder(algorithm);
     
-    char buffer[8192];
-    while (file.read(buffer, sizeof(buffer))) {
-        MD5_Update(&md5, buffer, file.gcount());
+    BufferPool::Lease buffer = BufferPool::instance().lease(64 * 1024);
+    while (file.read(buffer.chars(), buffer.size())) {
+        if (onRead) {
+            onRead(static_cast<size_t>(file.gcount()));
+        }
+        builder.update(buffer.chars(), file.gcount());
     }
     if (file.gcount() > 0) {
-        MD5_Update(&md5, buffer, file.gcount());
+        if (onRead) {
+            onRead(static_cast<size_t>(file.gcount()));
+        }
+        builder.update(buffer.chars(), file.gcount());
     }
     
-    unsigned char hash[MD5_DIGEST_LENGTH];
-    MD5_Final(hash, &md5);
-    
-    std::stringstream ss;
-    for (int i = 0; i < MD5_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
+    return builder.finish();
+}
+
+Digest Utils::calculateSHA256(const std::string& filePath) {
+    return calculateFileDigest(filePath, Digest::Algorithm::SHA256);
+}
+
+Digest Utils::calculateSHA256(const std::string& filePath, const std::function<void(size_t)>& onRead) {
+    return calculateFileDigest(filePath, Digest::Algorithm::SHA256, onRead);
+}
+
+Digest Utils::calculateSHA256(const std::vector<uint8_t>& data) {
+    return Digest::sha256(data.data(), data.size());
+}
+
+Digest Utils::calculateMD5(const std::string& filePath) {
+    return calculateFileDigest(filePath, Digest::Algorithm::MD5);
+}
+
+bool Utils::verifyChecksum(const std::string& filePath, const Digest& expectedChecksum) {
+    return calculateSHA256(filePath) == expectedChecksum;
+}
+
+namespace {
+
+// CRC32C (Castagnoli), reflected polynomial
+const uint32_t CRC32C_POLY = 0x82F63B78;
+
+struct Crc32cTables {
+    uint32_t table[8][256];
+
+    Crc32cTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int slice = 1; slice < 8; ++slice) {
+                table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+            }
+        }
     }
-    
-    return ss.str();
+};
+
+const Crc32cTables CRC32C_TABLES;
+
+// Slicing-by-8 software fallback
+uint32_t crc32cSoftware(uint32_t crc, const uint8_t* data, size_t length) {
+    const auto& t = CRC32C_TABLES.table;
+    while (length >= 8) {
+        uint32_t lo;
+        uint32_t hi;
+        std::memcpy(&lo, data, 4);
+        std::memcpy(&hi, data + 4, 4);
+        lo ^= crc;
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+uint32_t crc32cHardware(uint32_t crc, const uint8_t* data, size_t length) {
+    uint64_t crc64 = crc;
+    while (length >= 8) {
+        uint64_t value;
+        std::memcpy(&value, data, 8);
+        crc64 = _mm_crc32_u64(crc64, value);
+        data += 8;
+        length -= 8;
+    }
+    uint32_t crc32 = static_cast<uint32_t>(crc64);
+    while (length--) {
+        crc32 = _mm_crc32_u8(crc32, *data++);
+    }
+    return crc32;
+}
+#endif
+
+using Crc32cFunction = uint32_t (*)(uint32_t, const uint8_t*, size_t);
+
+Crc32cFunction selectCrc32c() {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return crc32cHardware;
+    }
+#endif
+    return crc32cSoftware;
 }
 
-bool Utils::verifyChecksum(const std::string& filePath, const std::string& expectedChecksum) {
-    std::string actualChecksum = calculateSHA256(filePath);
-    return actualChecksum == expectedChecksum;
+const Crc32cFunction CRC32C_IMPL = selectCrc32c();
+
+} // namespace
+
+uint32_t Utils::crc32c(const uint8_t* data, size_t length, uint32_t crc) {
+    return ~CRC32C_IMPL(~crc, data, length);
+}
+
+bool Utils::calculateStoredChecksums(const std::string& filePath, size_t blockSize,
+                                     Digest& digest, std::vector<uint32_t>& blockChecksums) {
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (!file || blockSize == 0) {
+        if (file) {
+            fclose(file);
+        }
+        return false;
+    }
+    
+    DigestBuilder builder;
+    blockChecksums.clear();
+    
+    // One pass: SHA-256 over the whole blob plus a CRC32C per block
+    BufferPool::Lease buffer = BufferPool::instance().lease(blockSize);
+    size_t bytesRead;
+    while ((bytesRead = fread(buffer.data(), 1, blockSize, file)) > 0) {
+        builder.update(buffer.data(), bytesRead);
+        blockChecksums.push_back(crc32c(buffer.data(), bytesRead));
+    }
+    
+    bool ok = !ferror(file);
+    fclose(file);
+    
+    digest = ok ? builder.finish() : Digest();
+    return ok;
 }
 
 std::chrono::system_clock::time_point Utils::parseTimestamp(const std::string& timestamp) {
@@ -0,0 +1,88 @@
+#include "WorkPlanner.h"
+#include <algorithm>
+#include <map>
+
+std::vector<WorkPlanner::Task> WorkPlanner::plan(const std::vector<File>& files, const Options& options) {
+    struct DeviceTasks {
+        bool ordered = false;
+        std::vector<Task> tasks;
+        Task batch;                     // Small files waiting to fill a batch
+    };
+
+    std::vector<std::uint64_t> deviceOrder;
+    std::map<std::uint64_t, DeviceTasks> devices;
+    std::uint64_t blockSize = std::max<std::uint64_t>(options.blockSize, 64 * 1024);
+
+    auto closeBatch = [](DeviceTasks& device) {
+        if (!device.batch.items.empty()) {
+            device.tasks.push_back(std::move(device.batch));
+            device.batch = Task();
+        }
+    };
+
+    for (size_t index = 0; index < files.size(); ++index) {
+        const File& file = files[index];
+        auto found = devices.find(file.device);
+        if (found == devices.end()) {
+            found = devices.emplace(file.device, DeviceTasks()).first;
+            found->second.ordered = file.ordered;
+            deviceOrder.push_back(file.device);
+        }
+        DeviceTasks& device = found->second;
+
+        Item item;
+        item.file = index;
+        item.length = file.size;
+
+        if (options.smallFileLimit > 0 && file.size <= options.smallFileLimit) {
+            device.batch.device = file.device;
+            device.batch.bytes += file.size;
+            device.batch.items.push_back(item);
+            if (device.batch.bytes >= options.batchBytes || device.batch.items.size() >= options.batchFiles) {
+                closeBatch(device);
+            }
+            continue;
+        }
+
+        // An ordered device must not see this file read ahead of the batch before it
+        if (device.ordered) {
+            closeBatch(device);
+        }
+
+        if (options.splitThreshold > 0 && file.size > options.splitThreshold) {
+            item.blocks = static_cast<size_t>((file.size + blockSize - 1) / blockSize);
+            for (size_t block = 0; block < item.blocks; ++block) {
+                Task task;
+                task.device = file.device;
+                item.block = block;
+                item.offset = block * blockSize;
+                item.length = std::min(blockSize, file.size - item.offset);
+                task.bytes = item.length;
+                task.items.push_back(item);
+                device.tasks.push_back(std::move(task));
+            }
+        } else {
+            Task task;
+            task.device = file.device;
+            task.bytes = file.size;
+            task.items.push_back(item);
+            device.tasks.push_back(std::move(task));
+        }
+    }
+
+    // Longest processing time first wherever the disk order does not matter
+    std::vector<Task> tasks;
+    for (std::uint64_t id : deviceOrder) {
+        DeviceTasks& device = devices[id];
+        closeBatch(device);
+        if (!device.ordered) {
+            std::stable_sort(device.tasks.begin(), device.tasks.end(), [](const Task& a, const Task& b) {
+                return a.bytes > b.bytes;
+            });
+        }
+        for (auto& task : device.tasks) {
+            tasks.push_back(std::move(task));
+        }
+    }
+    return tasks;
+}
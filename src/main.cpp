@@ -1,11 +1,29 @@
 #include "BackupManager.h"
 #include "Scheduler.h"
+#include "ErasureCoder.h"
+#include "ControlServer.h"
+#include "ChangeWatcher.h"
+#include "PackStore.h"
+#include "IoThrottle.h"
+#include "ReadOrder.h"
+#include "BlockCache.h"
+#include "BufferPool.h"
+#include "MemoryBudget.h"
 #include "Utils.h"
+#include <nlohmann/json.hpp>
 #include <iostream>
 #include <string>
 #include <vector>
+#include <map>
+#include <memory>
+#include <functional>
 #include <chrono>
 #include <iomanip>
+#include <thread>
+#include <mutex>
+#include <csignal>
+#include <pthread.h>
+#include <unistd.h>
 
 void printUsage(const std::string& programName) {
     std::cout << "Backup and Recovery System\n";
@@ -14,21 +32,57 @@ void printUsage(const std::string& programName) {
     std::cout << "  --backup              Create a full backup\n";
     std::cout << "  --incremental         Create an incremental backup\n";
     std::cout << "  --restore             Restore from backup\n";
-    std::cout << "  --verify              Verify backup integrity\n";
+    std::cout << "  --verify[=MODE]       Verify backup integrity (MODE: full, at-rest, sample; default: full)\n";
     std::cout << "  --schedule            Schedule automatic backups\n";
     std::cout << "  --list                List available backups\n";
+    std::cout << "  --diff                Show changes between --base and --backup-path (or --source)\n";
+    std::cout << "  --daemon              Keep state resident and run incrementals on --interval or on trigger\n";
+    std::cout << "  --cdp                 Continuously protect --source, committing changes every few seconds\n";
+    std::cout << "  --ctl COMMAND         Send COMMAND (trigger, status, cancel, stop) to a running daemon\n";
     std::cout << "\n";
     std::cout << "Parameters:\n";
     std::cout << "  --source PATH         Source directory to backup\n";
     std::cout << "  --dest PATH           Destination directory for backup\n";
     std::cout << "  --backup-path PATH    Path to backup for restore/verify\n";
     std::cout << "  --restore-path PATH   Path to restore files to\n";
+    std::cout << "  --base PATH           Older backup to compare against for diff\n";
     std::cout << "  --compress            Enable compression (default: enabled)\n";
     std::cout << "  --no-compress         Disable compression\n";
     std::cout << "  --encrypt             Enable encryption\n";
     std::cout << "  --key KEY             Encryption key\n";
     std::cout << "  --level LEVEL         Compression level (1-9, default: 6)\n";
     std::cout << "  --interval SECONDS    Schedule interval in seconds\n";
+    std::cout << "  --threads N           Worker threads for verification (default: all cores)\n";
+    std::cout << "  --report PATH         Write the verification report to PATH\n";
+    std::cout << "  --confidence C        Sampling confidence level (default: 0.95)\n";
+    std::cout << "  --max-corruption PCT  Smallest corrupted share of bytes to detect (default: 1)\n";
+    std::cout << "  --time-budget SECONDS Stop sampling after SECONDS\n";
+    std::cout << "  --parity K+M          Write Reed-Solomon parity (K data + M parity shards) for each blob\n";
+    std::cout << "  --no-repair           Report damage without rebuilding blobs from parity\n";
+    std::cout << "  --scrub               Re-verify stored blobs in the background while scheduling\n";
+    std::cout << "  --scrub-rate MBPS     Scrub read budget in MB/s (default: 16)\n";
+    std::cout << "  --pressure-aware      Defer scheduled backups and slow running ones under system pressure\n";
+    std::cout << "  --max-delay SECONDS   Longest a backup may be deferred for pressure (default: 3600)\n";
+    std::cout << "  --jitter SECONDS      Spread the first run of each schedule over SECONDS\n";
+    std::cout << "  --batch-delay MS      CDP: longest a change waits for its batch to commit (default: 2000)\n";
+    std::cout << "  --quiet MS            CDP: a file must be idle this long unless its writer closed it (default: 1000)\n";
+    std::cout << "  --at TIMESTAMP        Restore a CDP store as of \"YYYY-MM-DD HH:MM:SS\" (default: latest)\n";
+    std::cout << "  --read-limit RATE     Cap source and blob reads, e.g. 50M (bytes/s; K, M, G suffixes)\n";
+    std::cout << "  --write-limit RATE    Cap destination writes, e.g. 20M\n";
+    std::cout << "  --iops N              Cap read and write operations per second\n";
+    std::cout << "  --io-weight N         Share of disk I/O against concurrent scheduled jobs (default: 100)\n";
+    std::cout << "  --io-priority N       Higher priority jobs get disk I/O first (default: 0)\n";
+    std::cout << "  --job NAME=SOURCE[,weight=N][,priority=N]\n";
+    std::cout << "                        Also back up SOURCE into DEST/NAME on the same interval (repeatable)\n";
+    std::cout << "  --max-concurrent N    Scheduled jobs that may run at once (default: 1)\n";
+    std::cout << "  --read-order MODE     auto, scan, inode or physical (default: auto = physical on HDDs)\n";
+    std::cout << "  --split-size SIZE     Copy files larger than SIZE as parallel blocks (default: 256M, 0 = never)\n";
+    std::cout << "  --split-block SIZE    Block size for split files (default: 32M)\n";
+    std::cout << "  --cache-size SIZE     Memory for decoded blocks shared by restore workers (default: 256M, 0 = off)\n";
+    std::cout << "  --max-memory SIZE     Budget for buffers, in-flight blocks and metadata, e.g. 4G (default: off)\n";
+    std::cout << "  --auto-tune           Adjust copy workers and write slots during the run and remember the best\n";
+    std::cout << "  --max-workers N       Upper bound for --auto-tune (default: twice the cores)\n";
+    std::cout << "  --socket PATH         Daemon control socket (default: DEST/backup_daemon.sock)\n";
     std::cout << "  --help                Show this help message\n";
     std::cout << "\n";
     std::cout << "Examples:\n";
@@ -36,7 +90,19 @@ void printUsage(const std::string& programName) {
     std::cout << "  " << programName << " --incremental --source /home/user/docs --dest /backup\n";
     std::cout << "  " << programName << " --restore --backup-path /backup/backup_20250801_120000 --restore-path /restore\n";
     std::cout << "  " << programName << " --verify --backup-path /backup/backup_20250801_120000\n";
+    std::cout << "  " << programName << " --backup --source /home/user/docs --dest /backup --parity 8+2\n";
+    std::cout << "  " << programName << " --verify=at-rest --backup-path /backup/backup_20250801_120000\n";
+    std::cout << "  " << programName << " --verify=sample --confidence 0.99 --max-corruption 0.5 --backup-path /backup/backup_20250801_120000\n";
+    std::cout << "  " << programName << " --diff --base /backup/backup_20250801_120000 --backup-path /backup/backup_20250802_120000\n";
     std::cout << "  " << programName << " --schedule --source /home/user/docs --dest /backup --interval 3600\n";
+    std::cout << "  " << programName << " --schedule --source /home/user/docs --dest /backup --interval 3600 --scrub --scrub-rate 8\n";
+    std::cout << "  " << programName << " --schedule --source /home/user/docs --dest /backup --interval 3600 --pressure-aware --max-delay 1800\n";
+    std::cout << "  " << programName << " --schedule --source /home/user/docs --dest /backup --interval 3600 --job media=/srv/media,weight=25 --max-concurrent 2\n";
+    std::cout << "  " << programName << " --daemon --source /home/user/docs --dest /backup --interval 3600\n";
+    std::cout << "  " << programName << " --ctl trigger --dest /backup\n";
+    std::cout << "  " << programName << " --ctl \"limit read=20M write=off\" --dest /backup\n";
+    std::cout << "  " << programName << " --cdp --source /home/user/docs --dest /backup --batch-delay 1000\n";
+    std::cout << "  " << programName << " --restore --backup-path /backup/cdp --restore-path /restore --at \"2025-08-01 12:34:56\"\n";
 }
 
 void progressCallback(const std::string& operation, float percentage) {
@@ -47,6 +113,46 @@ void progressCallback(const std::string& operation, float percentage) {
     }
 }
 
+// A scheduled job besides the one for --source
+struct ScheduledJob {
+    std::string name;
+    std::string sourcePath;
+    unsigned int ioWeight = 100;
+    int ioPriority = 0;
+};
+
+// NAME=SOURCE[,weight=N][,priority=N]
+bool parseJob(const std::string& text, ScheduledJob& job) {
+    std::vector<std::string> fields = Utils::split(text, ',');
+    size_t equals = fields.empty() ? std::string::npos : fields[0].find('=');
+    if (equals == std::string::npos) {
+        return false;
+    }
+    job.name = fields[0].substr(0, equals);
+    job.sourcePath = fields[0].substr(equals + 1);
+    if (job.name.empty() || job.name.find('/') != std::string::npos || job.sourcePath.empty()) {
+        return false;
+    }
+
+    for (size_t i = 1; i < fields.size(); ++i) {
+        size_t split = fields[i].find('=');
+        std::string key = fields[i].substr(0, split);
+        std::string value = split == std::string::npos ? "" : fields[i].substr(split + 1);
+        try {
+            if (key == "weight") {
+                job.ioWeight = static_cast<unsigned int>(std::stoul(value));
+            } else if (key == "priority") {
+                job.ioPriority = std::stoi(value);
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         printUsage(argv[0]);
@@ -61,11 +167,42 @@ int main(int argc, char* argv[]) {
     std::string destPath;
     std::string backupPath;
     std::string restorePath;
+    std::string basePath;
     std::string encryptionKey;
     bool enableCompression = true;
     bool enableEncryption = false;
     int compressionLevel = 6;
     int scheduleInterval = 0;
+    size_t threadCount = 0;
+    std::string reportPath;
+    BackupVerifier::Mode verifyMode = BackupVerifier::Mode::FULL;
+    double sampleConfidence = 0.95;
+    double maxCorruptionPercent = 1.0;
+    int timeBudget = 0;
+    size_t parityDataShards = 0;
+    size_t parityShards = 0;
+    bool enableRepair = true;
+    bool enableScrub = false;
+    double scrubRate = 16.0;
+    bool pressureAware = false;
+    int maxDelay = 3600;
+    int startJitter = 0;
+    std::string socketPath;
+    std::string controlCommand;
+    int batchDelay = 2000;
+    int quietPeriod = 1000;
+    std::string restoreAt;
+    IoThrottle::Limits ioLimits;
+    std::mutex ioLimitsMutex;
+    unsigned int ioWeight = 100;
+    int ioPriority = 0;
+    std::vector<ScheduledJob> extraJobs;
+    size_t maxConcurrent = 1;
+    ReadOrder::Mode readOrder = ReadOrder::Mode::AUTO;
+    std::uintmax_t cacheSize = BlockCache::DEFAULT_CAPACITY;
+    std::uintmax_t maxMemory = 0;
+    WorkPlanner::Options workPlan;
+    ConcurrencyTuner::Options tuning;
 
     for (size_t i = 0; i < args.size(); ++i) {
         if (args[i] == "--help") {
@@ -79,10 +216,25 @@ int main(int argc, char* argv[]) {
             operation = "restore";
         } else if (args[i] == "--verify") {
             operation = "verify";
+        } else if (args[i].rfind("--verify=", 0) == 0) {
+            operation = "verify";
+            if (!BackupVerifier::parseMode(args[i].substr(9), verifyMode)) {
+                std::cerr << "Error: Unknown verification mode '" << args[i].substr(9) << "'\n";
+                return 1;
+            }
         } else if (args[i] == "--schedule") {
             operation = "schedule";
         } else if (args[i] == "--list") {
             operation = "list";
+        } else if (args[i] == "--diff") {
+            operation = "diff";
+        } else if (args[i] == "--daemon") {
+            operation = "daemon";
+        } else if (args[i] == "--cdp") {
+            operation = "cdp";
+        } else if (args[i] == "--ctl" && i + 1 < args.size()) {
+            operation = "ctl";
+            controlCommand = args[++i];
         } else if (args[i] == "--source" && i + 1 < args.size()) {
             sourcePath = args[++i];
         } else if (args[i] == "--dest" && i + 1 < args.size()) {
@@ -91,6 +243,8 @@ int main(int argc, char* argv[]) {
             backupPath = args[++i];
         } else if (args[i] == "--restore-path" && i + 1 < args.size()) {
             restorePath = args[++i];
+        } else if (args[i] == "--base" && i + 1 < args.size()) {
+            basePath = args[++i];
         } else if (args[i] == "--key" && i + 1 < args.size()) {
             encryptionKey = args[++i];
             enableEncryption = true;
@@ -104,6 +258,90 @@ int main(int argc, char* argv[]) {
             compressionLevel = std::stoi(args[++i]);
         } else if (args[i] == "--interval" && i + 1 < args.size()) {
             scheduleInterval = std::stoi(args[++i]);
+        } else if (args[i] == "--threads" && i + 1 < args.size()) {
+            threadCount = std::stoul(args[++i]);
+        } else if (args[i] == "--report" && i + 1 < args.size()) {
+            reportPath = args[++i];
+        } else if (args[i] == "--confidence" && i + 1 < args.size()) {
+            sampleConfidence = std::stod(args[++i]);
+        } else if (args[i] == "--max-corruption" && i + 1 < args.size()) {
+            maxCorruptionPercent = std::stod(args[++i]);
+        } else if (args[i] == "--time-budget" && i + 1 < args.size()) {
+            timeBudget = std::stoi(args[++i]);
+        } else if (args[i] == "--parity" && i + 1 < args.size()) {
+            if (!ErasureCoder::parseLayout(args[++i], parityDataShards, parityShards)) {
+                std::cerr << "Error: Invalid parity layout '" << args[i] << "' (expected K+M, K+M <= 255)\n";
+                return 1;
+            }
+        } else if (args[i] == "--no-repair") {
+            enableRepair = false;
+        } else if (args[i] == "--scrub") {
+            enableScrub = true;
+        } else if (args[i] == "--scrub-rate" && i + 1 < args.size()) {
+            scrubRate = std::stod(args[++i]);
+        } else if (args[i] == "--pressure-aware") {
+            pressureAware = true;
+        } else if (args[i] == "--max-delay" && i + 1 < args.size()) {
+            maxDelay = std::stoi(args[++i]);
+        } else if (args[i] == "--jitter" && i + 1 < args.size()) {
+            startJitter = std::stoi(args[++i]);
+        } else if (args[i] == "--socket" && i + 1 < args.size()) {
+            socketPath = args[++i];
+        } else if (args[i] == "--batch-delay" && i + 1 < args.size()) {
+            batchDelay = std::stoi(args[++i]);
+        } else if (args[i] == "--quiet" && i + 1 < args.size()) {
+            quietPeriod = std::stoi(args[++i]);
+        } else if (args[i] == "--at" && i + 1 < args.size()) {
+            restoreAt = args[++i];
+        } else if ((args[i] == "--read-limit" || args[i] == "--write-limit") && i + 1 < args.size()) {
+            std::uintmax_t& rate = args[i] == "--read-limit" ? ioLimits.readBytesPerSecond : ioLimits.writeBytesPerSecond;
+            if (!IoThrottle::parseRate(args[i + 1], rate)) {
+                std::cerr << "Error: Invalid rate '" << args[i + 1] << "' for " << args[i] << "\n";
+                return 1;
+            }
+            ++i;
+        } else if ((args[i] == "--split-size" || args[i] == "--split-block") && i + 1 < args.size()) {
+            std::uintmax_t size = 0;
+            if (!IoThrottle::parseRate(args[i + 1], size)) {
+                std::cerr << "Error: Invalid size '" << args[i + 1] << "' for " << args[i] << "\n";
+                return 1;
+            }
+            (args[i] == "--split-size" ? workPlan.splitThreshold : workPlan.blockSize) = size;
+            ++i;
+        } else if (args[i] == "--cache-size" && i + 1 < args.size()) {
+            if (!IoThrottle::parseRate(args[++i], cacheSize)) {
+                std::cerr << "Error: Invalid size '" << args[i] << "' for --cache-size\n";
+                return 1;
+            }
+        } else if (args[i] == "--auto-tune") {
+            tuning.enabled = true;
+        } else if (args[i] == "--max-workers" && i + 1 < args.size()) {
+            tuning.maxWorkers = static_cast<size_t>(std::stoul(args[++i]));
+        } else if (args[i] == "--max-memory" && i + 1 < args.size()) {
+            if (!IoThrottle::parseRate(args[++i], maxMemory)) {
+                std::cerr << "Error: Invalid size '" << args[i] << "' for --max-memory\n";
+                return 1;
+            }
+        } else if (args[i] == "--read-order" && i + 1 < args.size()) {
+            if (!ReadOrder::parseMode(args[++i], readOrder)) {
+                std::cerr << "Error: Unknown read order '" << args[i] << "' (expected auto, scan, inode or physical)\n";
+                return 1;
+            }
+        } else if (args[i] == "--io-weight" && i + 1 < args.size()) {
+            ioWeight = static_cast<unsigned int>(std::stoul(args[++i]));
+        } else if (args[i] == "--io-priority" && i + 1 < args.size()) {
+            ioPriority = std::stoi(args[++i]);
+        } else if (args[i] == "--job" && i + 1 < args.size()) {
+            ScheduledJob job;
+            if (!parseJob(args[++i], job)) {
+                std::cerr << "Error: Invalid job '" << args[i] << "' (expected NAME=SOURCE[,weight=N][,priority=N])\n";
+                return 1;
+            }
+            extraJobs.push_back(job);
+        } else if (args[i] == "--max-concurrent" && i + 1 < args.size()) {
+            maxConcurrent = std::max<size_t>(1, std::stoul(args[++i]));
+        } else if (args[i] == "--iops" && i + 1 < args.size()) {
+            ioLimits.iops = static_cast<std::uint32_t>(std::stoul(args[++i]));
         }
     }
 
@@ -113,8 +351,154 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (socketPath.empty() && !destPath.empty()) {
+        socketPath = Utils::joinPaths(destPath, "backup_daemon.sock");
+    }
+
     BackupManager backupManager;
     backupManager.setProgressCallback(progressCallback);
+    MemoryBudget::instance().setLimit(maxMemory);
+    backupManager.setBlockCacheCapacity(cacheSize);
+
+    // Options for unattended incremental runs (--schedule, --daemon, --cdp)
+    auto incrementalOptions = [&]() {
+        BackupManager::BackupOptions options;
+        options.sourcePath = sourcePath;
+        options.destPath = destPath;
+        options.enableCompression = enableCompression;
+        options.enableEncryption = enableEncryption;
+        options.encryptionKey = encryptionKey;
+        options.incremental = true;
+        options.compressionLevel = compressionLevel;
+        options.parityDataShards = static_cast<std::uint32_t>(parityDataShards);
+        options.parityShards = static_cast<std::uint32_t>(parityShards);
+        options.readOrder = readOrder;
+        options.workPlan = workPlan;
+        options.tuning = tuning;
+        
+        // Limits changed at runtime carry over to later runs
+        std::lock_guard<std::mutex> lock(ioLimitsMutex);
+        options.readBytesPerSecond = ioLimits.readBytesPerSecond;
+        options.writeBytesPerSecond = ioLimits.writeBytesPerSecond;
+        options.iopsLimit = ioLimits.iops;
+        return options;
+    };
+
+    // Each scheduled job runs on a BackupManager of its own, so concurrent runs never share
+    // file state, metadata or cancellation; all of them draw on one I/O scheduler. The job
+    // for --source uses backupManager and DEST, each --job NAME its own manager and DEST/NAME.
+    // Both are filled in before the scheduler starts and only read by its workers.
+    struct JobContext {
+        BackupManager* manager;
+        std::string destPath;
+    };
+    std::map<std::string, JobContext> jobs;
+    std::vector<std::unique_ptr<BackupManager>> jobManagers;
+    auto forEachManager = [&](const std::function<void(BackupManager&)>& action) {
+        action(backupManager);
+        for (auto& manager : jobManagers) {
+            action(*manager);
+        }
+    };
+
+    // Creates the schedule for --source as primaryName and one per --job through addSchedule
+    auto addJobs = [&](Scheduler& scheduler, const std::string& primaryName,
+                       const std::function<void(const std::string&)>& addSchedule) -> bool {
+        jobs[primaryName] = {&backupManager, destPath};
+        addSchedule(primaryName);
+        scheduler.setScheduleSource(primaryName, sourcePath);
+        scheduler.setScheduleIoShare(primaryName, ioWeight, ioPriority);
+
+        for (const ScheduledJob& job : extraJobs) {
+            if (jobs.count(job.name)) {
+                std::cerr << "Error: Duplicate job name '" << job.name << "'\n";
+                return false;
+            }
+            jobManagers.push_back(std::make_unique<BackupManager>());
+            BackupManager& manager = *jobManagers.back();
+            std::string name = job.name;
+            manager.setProgressCallback([name](const std::string& operation, float percentage) {
+                progressCallback(name + ": " + operation, percentage);
+            });
+            manager.setBlockCacheCapacity(cacheSize);
+            manager.setIoScheduler(backupManager.getIoScheduler());
+
+            jobs[job.name] = {&manager, Utils::joinPaths(destPath, job.name)};
+            addSchedule(job.name);
+            scheduler.setScheduleSource(job.name, job.sourcePath);
+            scheduler.setScheduleIoShare(job.name, job.ioWeight, job.ioPriority);
+        }
+        return true;
+    };
+
+    // Shared by --schedule and --daemon: incremental backups plus scrub and pressure handling
+    auto configureScheduler = [&](Scheduler& scheduler) {
+        scheduler.setMaxConcurrentBackups(maxConcurrent);
+        scheduler.setBackupCallback([&](const std::string& name) -> bool {
+            auto job = jobs.find(name);
+            if (job == jobs.end()) {
+                std::cerr << "Error: No job configured for schedule " << name << "\n";
+                return false;
+            }
+            BackupManager& manager = *job->second.manager;
+
+            BackupManager::BackupOptions options = incrementalOptions();
+            options.destPath = job->second.destPath;
+            Scheduler::ScheduleInfo schedule;
+            if (scheduler.getSchedule(name, schedule)) {
+                options.sourcePath = schedule.sourcePath;
+                options.jobName = name;
+                options.ioWeight = schedule.ioWeight;
+                options.ioPriority = schedule.ioPriority;
+            }
+
+            IoScheduler::JobStats before;
+            for (const auto& stats : manager.getIoScheduler()->getJobStats()) {
+                if (stats.name == name) {
+                    before = stats;
+                }
+            }
+            auto start = std::chrono::steady_clock::now();
+
+            // A cancelled run is not a failure to retry
+            bool success = manager.createIncrementalBackup(options) || manager.wasCancelled();
+
+            // What this run got out of the shared I/O scheduler
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            for (const auto& stats : manager.getIoScheduler()->getJobStats()) {
+                if (stats.name == name) {
+                    std::uintmax_t moved = stats.bytesRead + stats.bytesWritten - before.bytesRead - before.bytesWritten;
+                    std::cout << "I/O for " << name << " (weight " << stats.weight << ", priority " << stats.priority
+                              << "): " << Utils::formatBytes(moved) << " in " << std::fixed << std::setprecision(1)
+                              << seconds << "s (" << Utils::formatBytes(static_cast<std::uintmax_t>(moved / std::max(seconds, 0.001)))
+                              << "/s), held back " << stats.waitSeconds - before.waitSeconds << "s\n";
+                }
+            }
+            return success;
+        });
+
+        if (enableScrub) {
+            Scrubber::Options scrubOptions;
+            scrubOptions.repositoryPath = destPath;
+            scrubOptions.bytesPerSecond = static_cast<std::uintmax_t>(scrubRate * 1024 * 1024);
+            scheduler.enableScrubbing(scrubOptions);
+        }
+
+        if (pressureAware) {
+            Scheduler::PressurePolicy policy;
+            policy.enabled = true;
+            policy.maxDelay = std::chrono::seconds(maxDelay);
+            scheduler.setPressurePolicy(policy);
+            
+            // Halve the backup's duty cycle while pressure stays high mid-run
+            scheduler.setPressureCallback([&](bool high, const std::string&) {
+                forEachManager([high](BackupManager& manager) {
+                    manager.setThrottle(high ? 0.5f : 0.0f);
+                });
+            });
+        }
+        scheduler.setStartJitter(std::chrono::seconds(startJitter));
+    };
 
     try {
         if (operation == "backup" || operation == "incremental") {
@@ -131,6 +515,14 @@ int main(int argc, char* argv[]) {
             options.encryptionKey = encryptionKey;
             options.incremental = (operation == "incremental");
             options.compressionLevel = compressionLevel;
+            options.parityDataShards = static_cast<std::uint32_t>(parityDataShards);
+            options.parityShards = static_cast<std::uint32_t>(parityShards);
+            options.readOrder = readOrder;
+            options.workPlan = workPlan;
+            options.tuning = tuning;
+            options.readBytesPerSecond = ioLimits.readBytesPerSecond;
+            options.writeBytesPerSecond = ioLimits.writeBytesPerSecond;
+            options.iopsLimit = ioLimits.iops;
 
             std::cout << "Starting " << (options.incremental ? "incremental" : "full") << " backup...\n";
             std::cout << "Source: " << sourcePath << "\n";
@@ -162,7 +554,14 @@ int main(int argc, char* argv[]) {
             std::cout << "Restore to: " << restorePath << "\n";
             
             auto startTime = std::chrono::high_resolution_clock::now();
-            bool success = backupManager.restoreBackup(backupPath, restorePath);
+            bool success;
+            if (Utils::pathExists(Utils::joinPaths(backupPath, PackStore::JOURNAL_FILE))) {
+                auto until = restoreAt.empty() ? std::chrono::system_clock::time_point::max()
+                                               : Utils::parseTimestamp(restoreAt);
+                success = backupManager.restoreContinuous(backupPath, restorePath, until, encryptionKey);
+            } else {
+                success = backupManager.restoreBackup(backupPath, restorePath);
+            }
             auto endTime = std::chrono::high_resolution_clock::now();
             
             auto duration = std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime);
@@ -183,7 +582,17 @@ int main(int argc, char* argv[]) {
             std::cout << "Verifying backup: " << backupPath << "\n";
             
             auto startTime = std::chrono::high_resolution_clock::now();
-            bool success = backupManager.verifyBackup(backupPath);
+            BackupVerifier::Options verifyOptions;
+            verifyOptions.mode = verifyMode;
+            verifyOptions.encryptionKey = encryptionKey;
+            verifyOptions.threads = threadCount;
+            verifyOptions.reportPath = reportPath;
+            verifyOptions.confidence = sampleConfidence;
+            verifyOptions.maxCorruption = maxCorruptionPercent / 100.0;
+            verifyOptions.timeBudget = std::chrono::seconds(timeBudget);
+            verifyOptions.repair = enableRepair;
+            
+            bool success = backupManager.verifyBackup(backupPath, verifyOptions);
             auto endTime = std::chrono::high_resolution_clock::now();
             
             auto duration = std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime);
@@ -217,6 +626,19 @@ int main(int argc, char* argv[]) {
                 }
             }
 
+        } else if (operation == "diff") {
+            std::string targetPath = backupPath.empty() ? sourcePath : backupPath;
+            if (basePath.empty() || targetPath.empty()) {
+                std::cerr << "Error: Base backup and a backup path or source are required for diff.\n";
+                return 1;
+            }
+
+            std::cout << "Comparing " << basePath << " -> " << targetPath << "\n";
+            if (!backupManager.diffBackups(basePath, targetPath)) {
+                std::cerr << "Diff failed!\n";
+                return 1;
+            }
+
         } else if (operation == "schedule") {
             if (sourcePath.empty() || destPath.empty() || scheduleInterval <= 0) {
                 std::cerr << "Error: Source path, destination path, and interval are required for scheduling.\n";
@@ -224,28 +646,22 @@ int main(int argc, char* argv[]) {
             }
 
             Scheduler scheduler;
-            
-            // Set up the backup callback
-            scheduler.setBackupCallback([&](const std::string& name) -> bool {
-                BackupManager::BackupOptions options;
-                options.sourcePath = sourcePath;
-                options.destPath = destPath;
-                options.enableCompression = enableCompression;
-                options.enableEncryption = enableEncryption;
-                options.encryptionKey = encryptionKey;
-                options.incremental = true; // Use incremental for scheduled backups
-                options.compressionLevel = compressionLevel;
-
-                std::cout << "Executing scheduled backup: " << name << "\n";
-                return backupManager.createIncrementalBackup(options);
-            });
+            configureScheduler(scheduler);
 
             // Schedule the backup
             std::string scheduleName = "auto_backup_" + Utils::formatTimestamp(std::chrono::system_clock::now());
-            scheduler.scheduleBackup(scheduleName, Scheduler::ScheduleType::CUSTOM_INTERVAL, 
-                                   std::chrono::seconds(scheduleInterval));
+            bool added = addJobs(scheduler, scheduleName, [&](const std::string& name) {
+                scheduler.scheduleBackup(name, Scheduler::ScheduleType::CUSTOM_INTERVAL,
+                                         std::chrono::seconds(scheduleInterval));
+            });
+            if (!added) {
+                return 1;
+            }
 
             std::cout << "Scheduled backup every " << scheduleInterval << " seconds\n";
+            if (jobs.size() > 1) {
+                std::cout << jobs.size() << " jobs, up to " << maxConcurrent << " at once\n";
+            }
             std::cout << "Press Ctrl+C to stop...\n";
 
             scheduler.start();
@@ -257,6 +673,236 @@ int main(int argc, char* argv[]) {
             scheduler.stop();
             std::cout << "Scheduler stopped.\n";
 
+        } else if (operation == "daemon") {
+            if (sourcePath.empty() || destPath.empty() || scheduleInterval < 0) {
+                std::cerr << "Error: Source and destination paths are required for the daemon.\n";
+                return 1;
+            }
+            if (!Utils::createDirectoryRecursive(destPath)) {
+                std::cerr << "Error: Cannot create destination directory " << destPath << "\n";
+                return 1;
+            }
+
+            // Block termination signals before any thread starts so only sigwait() sees them;
+            // SIGUSR1 lifts the I/O limits and SIGUSR2 restores the configured ones
+            sigset_t stopSignals;
+            sigemptyset(&stopSignals);
+            sigaddset(&stopSignals, SIGINT);
+            sigaddset(&stopSignals, SIGTERM);
+            sigaddset(&stopSignals, SIGUSR1);
+            sigaddset(&stopSignals, SIGUSR2);
+            pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+            const IoThrottle::Limits configuredLimits = ioLimits;
+            auto setLimits = [&](const IoThrottle::Limits& limits) {
+                {
+                    std::lock_guard<std::mutex> lock(ioLimitsMutex);
+                    ioLimits = limits;
+                }
+                forEachManager([&limits](BackupManager& manager) {
+                    manager.setIoLimits(limits);    // Takes effect mid-run
+                });
+                std::cout << "I/O limits: " << IoThrottle::describe(limits) << "\n";
+            };
+
+            Scheduler scheduler;
+            configureScheduler(scheduler);
+
+            // The first run warms the resident state; without an interval a
+            // schedule only fires again on "trigger"
+            const std::string scheduleName = "daemon";
+            bool added = addJobs(scheduler, scheduleName, [&](const std::string& name) {
+                if (scheduleInterval > 0) {
+                    scheduler.scheduleBackup(name, Scheduler::ScheduleType::CUSTOM_INTERVAL,
+                                             std::chrono::seconds(scheduleInterval));
+                    scheduler.runNow(name);
+                } else {
+                    scheduler.scheduleBackup(name, Scheduler::ScheduleType::ONCE);
+                }
+            });
+            if (!added) {
+                return 1;
+            }
+
+            // File state and codec contexts stay in memory between runs
+            forEachManager([](BackupManager& manager) {
+                manager.setResident(true);
+            });
+
+            ControlServer control(socketPath);
+            control.registerCommand("trigger", [&](const std::vector<std::string>& args) -> std::string {
+                // trigger [NAME]; no name runs every job
+                if (args.size() > 1) {
+                    return jobs.count(args[1]) && scheduler.runNow(args[1]) ? "ok" : "error: no job " + args[1];
+                }
+                for (const auto& job : jobs) {
+                    scheduler.runNow(job.first);
+                }
+                return "ok";
+            });
+            control.registerCommand("cancel", [&](const std::vector<std::string>&) -> std::string {
+                bool cancelling = false;
+                forEachManager([&cancelling](BackupManager& manager) {
+                    if (manager.getStatus().running) {
+                        manager.cancelBackup();
+                        cancelling = true;
+                    }
+                });
+                return cancelling ? "cancelling" : "idle";
+            });
+            control.registerCommand("status", [&](const std::vector<std::string>&) -> std::string {
+                BackupManager::Status status = backupManager.getStatus();
+                BufferPool::Stats buffers = BufferPool::instance().getStats();
+                MemoryBudget::Stats memory = MemoryBudget::instance().getStats();
+                auto nextRun = scheduler.getNextScheduledTime();
+                nlohmann::json json = {
+                    {"running", status.running},
+                    {"operation", status.operation},
+                    {"progress", status.progress},
+                    {"lastBackupPath", status.lastBackupPath},
+                    {"lastBackupId", status.lastBackupId},
+                    {"trackedFiles", status.trackedFiles},
+                    {"deltaChain", status.deltaChain},
+                    {"ioLimits", IoThrottle::describe(backupManager.getIoLimits())},
+                    {"maxConcurrent", maxConcurrent},
+                    {"runningJobs", scheduler.getRunningBackupsCount()},
+                    {"jobs", nlohmann::json::array()},
+                    {"buffers", {
+                        {"leases", buffers.leases}, {"threadCacheHits", buffers.threadCacheHits},
+                        {"sharedHits", buffers.sharedHits}, {"slabAllocations", buffers.slabAllocations},
+                        {"oversizeAllocations", buffers.oversizeAllocations}, {"reservedBytes", buffers.reservedBytes},
+                        {"hugePageBytes", buffers.hugePageBytes}, {"leasedBytes", buffers.leasedBytes}
+                    }},
+                    {"memory", {
+                        {"limit", memory.limit}, {"charged", memory.charged}, {"reserved", memory.reserved},
+                        {"peak", memory.peak}, {"waits", memory.waits}, {"waitSeconds", memory.waitSeconds},
+                        {"spills", memory.spills}
+                    }},
+                    {"nextRun", nextRun == std::chrono::system_clock::time_point::max()
+                                    ? "" : Utils::formatTimestamp(nextRun)}
+                };
+                for (const auto& job : backupManager.getIoScheduler()->getJobStats()) {
+                    json["jobs"].push_back({
+                        {"name", job.name}, {"weight", job.weight}, {"priority", job.priority},
+                        {"active", job.active}, {"bytesRead", job.bytesRead}, {"bytesWritten", job.bytesWritten},
+                        {"operations", job.operations}, {"bytesPerSecond", job.bytesPerSecond},
+                        {"waitSeconds", job.waitSeconds}
+                    });
+                }
+                return json.dump();
+            });
+            control.registerCommand("limit", [&](const std::vector<std::string>& args) -> std::string {
+                // limit [read=RATE] [write=RATE] [iops=N]; no arguments reports the current limits
+                IoThrottle::Limits limits;
+                {
+                    std::lock_guard<std::mutex> lock(ioLimitsMutex);
+                    limits = ioLimits;
+                }
+                for (size_t i = 1; i < args.size(); ++i) {
+                    size_t equals = args[i].find('=');
+                    std::string key = args[i].substr(0, equals);
+                    std::string value = equals == std::string::npos ? "" : args[i].substr(equals + 1);
+                    std::uintmax_t rate = 0;
+                    if (!IoThrottle::parseRate(value, rate) || (key != "read" && key != "write" && key != "iops")) {
+                        return "error: expected read=RATE, write=RATE or iops=N, got '" + args[i] + "'";
+                    }
+                    if (key == "read") {
+                        limits.readBytesPerSecond = rate;
+                    } else if (key == "write") {
+                        limits.writeBytesPerSecond = rate;
+                    } else {
+                        limits.iops = static_cast<std::uint32_t>(rate);
+                    }
+                }
+                if (args.size() > 1) {
+                    setLimits(limits);
+                }
+                return IoThrottle::describe(limits);
+            });
+            control.registerCommand("stop", [](const std::vector<std::string>&) -> std::string {
+                kill(getpid(), SIGTERM);
+                return "stopping";
+            });
+
+            if (!control.start()) {
+                return 1;
+            }
+            scheduler.start();
+            std::cout << "Daemon listening on " << socketPath << "\n";
+
+            int received = 0;
+            while (sigwait(&stopSignals, &received) == 0 && (received == SIGUSR1 || received == SIGUSR2)) {
+                setLimits(received == SIGUSR1 ? IoThrottle::Limits() : configuredLimits);
+            }
+            std::cout << "\nStopping daemon...\n";
+
+            control.stop();
+            forEachManager([](BackupManager& manager) {
+                manager.cancelBackup();
+            });
+            scheduler.stop();
+            std::cout << "Daemon stopped.\n";
+
+        } else if (operation == "cdp") {
+            if (sourcePath.empty() || destPath.empty() || batchDelay <= 0 || quietPeriod < 0) {
+                std::cerr << "Error: Source and destination paths are required for continuous protection.\n";
+                return 1;
+            }
+
+            sigset_t stopSignals;
+            sigemptyset(&stopSignals);
+            sigaddset(&stopSignals, SIGINT);
+            sigaddset(&stopSignals, SIGTERM);
+            pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+            ChangeWatcher::Options watchOptions;
+            watchOptions.maxBatchDelay = std::chrono::milliseconds(batchDelay);
+            watchOptions.quietPeriod = std::chrono::milliseconds(quietPeriod);
+            ChangeWatcher watcher(watchOptions);
+
+            // Watch before the baseline so nothing changed during it is missed
+            if (!watcher.start(sourcePath)) {
+                return 1;
+            }
+            backupManager.setResident(true);
+            BackupManager::BackupOptions options = incrementalOptions();
+            if (!backupManager.createIncrementalBackup(options)) {
+                std::cerr << "Error: Baseline backup failed\n";
+                watcher.stop();
+                return 1;
+            }
+            std::cout << "\nProtecting " << sourcePath << " (" << watcher.getWatchCount() << " directories)\n";
+
+            std::thread committer([&]() {
+                ChangeWatcher::Batch batch;
+                bool rescanNext = false;
+                while (watcher.nextBatch(batch)) {
+                    // After a failed commit its files are only recoverable by a rescan
+                    bool ok = backupManager.commitMicroBatch(options, batch.changed, batch.deleted,
+                                                             batch.rescan || rescanNext);
+                    rescanNext = !ok;
+                }
+            });
+
+            int received = 0;
+            sigwait(&stopSignals, &received);
+            std::cout << "\nStopping continuous protection...\n";
+            watcher.stop();
+            committer.join();
+
+        } else if (operation == "ctl") {
+            if (socketPath.empty()) {
+                std::cerr << "Error: --socket or --dest is required to reach the daemon.\n";
+                return 1;
+            }
+
+            std::string response;
+            if (!ControlServer::sendCommand(socketPath, controlCommand, response)) {
+                std::cerr << "Error: No daemon answering on " << socketPath << "\n";
+                return 1;
+            }
+            std::cout << response << "\n";
+            return response.rfind("error:", 0) == 0 ? 1 : 0;
+
         } else {
             std::cerr << "Error: Unknown operation '" << operation << "'\n";
             return 1;